@@ -0,0 +1,192 @@
+#ifndef NDVEC_AUTOMATON_HEADER_INCLUDED
+#define NDVEC_AUTOMATON_HEADER_INCLUDED
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "grid.hpp"
+#include "ndvec.hpp"
+#include "neighborhood.hpp"
+#include "parallel.hpp"
+
+namespace ndvec {
+
+// Cellular automaton over a dense 2D grid, where every cell is a state in [0, 16), e.g.
+// an enum with values 0, 1, 2, ... Each generation reads one grid and writes the other,
+// and the two are swapped after the step.
+//
+// The neighbour counts of all 16 states are packed into one 64-bit integer, 4 bits per
+// state, by summing the one-hot encodings 1 << (4 * state) of the neighbours. The sums
+// are computed row by row, first over each column of 3 cells and then over a sliding
+// window of 3 column sums, so every cell costs a few additions no matter how many
+// states the rule looks at. The grid is split into tiles of rows and columns, which are
+// stepped in parallel.
+template <typename Cell, std::integral T = int>
+  requires(std::integral<Cell> or std::is_enum_v<Cell>)
+class automaton {
+public:
+  using grid_type = grid<Cell, 2, T>;
+  using vec = grid_type::vec;
+  using size_type = std::size_t;
+
+  static constexpr size_type max_states{16};
+
+  // Number of neighbours in each state.
+  class counts {
+    std::uint64_t packed{};
+
+  public:
+    constexpr explicit counts(std::uint64_t packed) noexcept : packed{packed} {}
+
+    [[nodiscard]] constexpr int count(Cell state) const noexcept {
+      return static_cast<int>((packed >> shift(state)) & 0xf);
+    }
+  };
+
+private:
+  static constexpr size_type tile_rows{32};
+  static constexpr size_type tile_columns{2048};
+
+  grid_type current;
+  grid_type next;
+  size_type generation_{};
+  // column sums and one-hot encodings of one tile row, for each chunk of tiles
+  std::vector<std::vector<std::uint64_t>> scratch;
+
+  [[nodiscard]] static constexpr unsigned shift(Cell state) noexcept {
+    return 4 * (static_cast<unsigned>(state) & 0xf);
+  }
+
+  [[nodiscard]] static constexpr bool is_state(Cell c) noexcept {
+    long long value{};
+    if constexpr (std::is_enum_v<Cell>) {
+      value = static_cast<long long>(std::to_underlying(c));
+    } else {
+      value = static_cast<long long>(c);
+    }
+    return 0 <= value and value < static_cast<long long>(max_states);
+  }
+
+  [[nodiscard]] static constexpr std::uint64_t one_hot(Cell state) noexcept {
+    return std::uint64_t{1} << shift(state);
+  }
+
+  [[nodiscard]] size_type width() const noexcept {
+    return static_cast<size_type>(current.extent().x());
+  }
+  [[nodiscard]] size_type height() const noexcept {
+    return static_cast<size_type>(current.extent().y());
+  }
+
+  [[nodiscard]] size_type column_tiles() const noexcept {
+    return (width() + tile_columns - 1) / tile_columns;
+  }
+  [[nodiscard]] size_type tile_count() const noexcept {
+    return column_tiles() * ((height() + tile_rows - 1) / tile_rows);
+  }
+
+  template <neighborhood N, typename Rule>
+  void step_tile(Rule& rule, size_type tile, std::vector<std::uint64_t>& buffer) {
+    const size_type w{width()}, h{height()};
+    const size_type x0{tile % column_tiles() * tile_columns};
+    const size_type x1{std::min(x0 + tile_columns, w)};
+    const size_type y0{tile / column_tiles() * tile_rows};
+    const size_type y1{std::min(y0 + tile_rows, h)};
+    // both buffers cover the columns [x0 - 1, x1 + 1) and column x is at x + 1 - x0,
+    // the columns outside the grid stay zero
+    const size_type span{x1 - x0 + 2};
+    buffer.assign(2 * span, 0);
+    std::uint64_t* const sums{buffer.data()};
+    std::uint64_t* const hot{buffer.data() + span};
+    const size_type lo{x0 > 0 ? x0 - 1 : x0};
+    const size_type hi{x1 < w ? x1 + 1 : x1};
+
+    const Cell* const src{current.cells().data()};
+    Cell* const dst{next.cells().data()};
+    for (size_type y{y0}; y < y1; ++y) {
+      const Cell* const row{src + y * w};
+      for (size_type x{lo}; x < hi; ++x) {
+        hot[x + 1 - x0] = one_hot(row[x]);
+      }
+      for (size_type x{lo}; x < hi; ++x) {
+        sums[x + 1 - x0] = hot[x + 1 - x0];
+      }
+      if (y > 0) {
+        for (size_type x{lo}; x < hi; ++x) {
+          sums[x + 1 - x0] += one_hot(row[x - w]);
+        }
+      }
+      if (y + 1 < h) {
+        for (size_type x{lo}; x < hi; ++x) {
+          sums[x + 1 - x0] += one_hot(row[x + w]);
+        }
+      }
+      Cell* const out{dst + y * w};
+      for (size_type x{x0}; x < x1; ++x) {
+        const size_type i{x + 1 - x0};
+        const std::uint64_t packed{
+            N == neighborhood::moore ? sums[i - 1] + sums[i] + sums[i + 1] - hot[i]
+                                     : sums[i] - hot[i] + hot[i - 1] + hot[i + 1]
+        };
+        out[x] = std::invoke(rule, row[x], counts{packed});
+      }
+    }
+  }
+
+  template <neighborhood N, typename Rule> void step_impl(Rule& rule) {
+    const size_type tiles{tile_count()};
+    scratch.resize(parallel::chunk_count(tiles, 1));
+    parallel::for_each_chunk(tiles, 1, [&](size_type chunk, auto b, auto e) {
+      for (size_type tile{b}; tile < e; ++tile) {
+        step_tile<N>(rule, tile, scratch[chunk]);
+      }
+    });
+    std::swap(current, next);
+    ++generation_;
+  }
+
+public:
+  // Throws std::invalid_argument if some cell is not a state in [0, 16).
+  explicit automaton(grid_type cells) : current{std::move(cells)}, next{current} {
+    if (not std::ranges::all_of(current, is_state)) {
+      throw std::invalid_argument("automaton cell states must be in [0, 16)");
+    }
+  }
+
+  // The current generation.
+  [[nodiscard]] const grid_type& cells() const noexcept { return current; }
+  [[nodiscard]] size_type generation() const noexcept { return generation_; }
+
+  // Replaces every cell c with rule(c, counts), where counts holds the number of
+  // neighbours in each state. Cells outside the grid are not counted. The rule must
+  // return states in [0, 16) and may be called concurrently from several threads. The
+  // neighbourhood has a radius of 1, so l1_shell is the same as von_neumann.
+  template <typename Rule>
+    requires std::is_invocable_r_v<Cell, Rule&, Cell, counts>
+  void step(Rule&& rule, neighborhood n = neighborhood::moore) {
+    if (n == neighborhood::moore) {
+      step_impl<neighborhood::moore>(rule);
+    } else {
+      step_impl<neighborhood::von_neumann>(rule);
+    }
+  }
+
+  template <typename Rule>
+    requires std::is_invocable_r_v<Cell, Rule&, Cell, counts>
+  void run(size_type generations, Rule&& rule, neighborhood n = neighborhood::moore) {
+    for (size_type g{}; g < generations; ++g) {
+      step(rule, n);
+    }
+  }
+};
+
+} // namespace ndvec
+
+#endif // NDVEC_AUTOMATON_HEADER_INCLUDED
@@ -0,0 +1,388 @@
+#ifndef NDVEC_BATCH_HEADER_INCLUDED
+#define NDVEC_BATCH_HEADER_INCLUDED
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "mat.hpp"
+#include "ndvec.hpp"
+#include "soa_vector.hpp"
+
+// Kernels that compare one query vector against a span of points, or transform all of
+// them. The per-axis work is written with GCC/Clang vector extensions, so it lowers to
+// SSE/NEON by default and to AVX2 or AVX-512 registers when compiled with e.g. -mavx2
+// or -march=native.
+namespace ndvec::batch {
+
+namespace detail {
+
+#if defined(__AVX512F__)
+inline constexpr std::size_t simd_bytes{64};
+#elif defined(__AVX2__)
+inline constexpr std::size_t simd_bytes{32};
+#else
+inline constexpr std::size_t simd_bytes{16};
+#endif
+
+template <typename T>
+inline constexpr bool has_simd_pack{
+    std::is_arithmetic_v<T> and not std::same_as<T, bool>
+    and not std::same_as<T, long double> and simd_bytes % sizeof(T) == 0
+};
+
+template <typename T> struct pack_traits {
+  static constexpr std::size_t lanes{1};
+  using type = T;
+};
+
+template <typename T>
+  requires has_simd_pack<T>
+struct pack_traits<T> {
+  static constexpr std::size_t lanes{simd_bytes / sizeof(T)};
+  typedef T type __attribute__((vector_size(simd_bytes)));
+};
+
+template <typename T> using pack = pack_traits<T>::type;
+template <typename T> inline constexpr std::size_t lanes{pack_traits<T>::lanes};
+
+template <typename Vec> struct aos_source {
+  using value_type = Vec::value_type;
+  static constexpr bool contiguous_axes{false};
+
+  std::span<const Vec> points;
+
+  [[nodiscard]] constexpr std::size_t size() const noexcept { return points.size(); }
+
+  template <std::size_t axis, typename Pack>
+  [[nodiscard]] constexpr Pack load(std::size_t i) const noexcept {
+    if constexpr (std::same_as<Pack, value_type>) {
+      return points[i].template get<axis>();
+    } else {
+      value_type column[lanes<value_type>];
+      for (std::size_t lane{}; lane < lanes<value_type>; ++lane) {
+        column[lane] = points[i + lane].template get<axis>();
+      }
+      Pack p;
+      std::memcpy(&p, column, sizeof(p));
+      return p;
+    }
+  }
+};
+
+template <typename Vec> struct soa_source {
+  using value_type = Vec::value_type;
+  static constexpr bool contiguous_axes{true};
+
+  const soa_vector<Vec>& points;
+
+  [[nodiscard]] constexpr std::size_t size() const noexcept { return points.size(); }
+
+  template <std::size_t axis, typename Pack>
+  [[nodiscard]] constexpr Pack load(std::size_t i) const noexcept {
+    const value_type* col{points.template axis_data<axis>().data() + i};
+    if constexpr (std::same_as<Pack, value_type>) {
+      return *col;
+    } else {
+      Pack p;
+      std::memcpy(&p, col, sizeof(p));
+      return p;
+    }
+  }
+};
+
+template <typename V> using lane_t = std::remove_cvref_t<decltype(std::declval<V>()[0])>;
+
+// op(p, q) for one value or one pack, rounded to the lane type at every step, so that a
+// point gives the same result on the scalar path, in a pack lane and in ndvec::distance
+// or ndvec::dot. Scalars narrower than int are computed in int, or in unsigned int for
+// unsigned types, and integer packs in unsigned lanes, which wrap instead of overflowing.
+template <typename V, typename Op>
+[[nodiscard]] constexpr V wrapping(Op op, V p, V q) noexcept {
+  if constexpr (std::is_arithmetic_v<V>) {
+    if constexpr (std::unsigned_integral<V> and sizeof(V) < sizeof(unsigned)) {
+      return static_cast<V>(op(static_cast<unsigned>(p), static_cast<unsigned>(q)));
+    } else {
+      return static_cast<V>(op(p, q));
+    }
+  } else if constexpr (std::integral<lane_t<V>>) {
+    using U = pack<std::make_unsigned_t<lane_t<V>>>;
+    return std::bit_cast<V>(op(std::bit_cast<U>(p), std::bit_cast<U>(q)));
+  } else {
+    return op(p, q);
+  }
+}
+
+struct abs_diff {
+  template <typename V> constexpr V operator()(V p, V q) const noexcept {
+    const V d{wrapping(std::minus<>{}, p, q)};
+    return d < 0 ? wrapping(std::minus<>{}, V{}, d) : d;
+  }
+};
+
+struct squared_diff {
+  template <typename V> constexpr V operator()(V p, V q) const noexcept {
+    const V d{wrapping(std::minus<>{}, p, q)};
+    return wrapping(std::multiplies<>{}, d, d);
+  }
+};
+
+struct product {
+  template <typename V> constexpr V operator()(V p, V q) const noexcept {
+    return wrapping(std::multiplies<>{}, p, q);
+  }
+};
+
+// Sum of fn(point[axis], query[axis]) over all axes, for one point or one pack of points
+// starting at i.
+template <typename Pack, typename Vec, typename Source, typename AxisFn>
+[[nodiscard]] constexpr Pack
+reduce_axes(const Vec& query, const Source& src, std::size_t i, AxisFn fn) noexcept {
+  return [&]<std::size_t... axes>(std::index_sequence<axes...>) -> Pack {
+    Pack acc{};
+    ((acc = wrapping(
+          std::plus<>{},
+          acc,
+          fn(src.template load<axes, Pack>(i),
+             static_cast<Pack>(Pack{} + query.template get<axes>()))
+      )),
+     ...);
+    return acc;
+  }(typename Vec::axes_indices{});
+}
+
+template <typename Vec, typename Source, typename AxisFn>
+constexpr void transform_reduce(
+    const Vec& query,
+    const Source& src,
+    std::span<typename Vec::value_type> out,
+    AxisFn fn
+) noexcept {
+  using T = Vec::value_type;
+  using P = pack<T>;
+  std::size_t i{};
+  // Compilers vectorize the strided AoS loads of the scalar loop better than the explicit
+  // lane-by-lane transpose, so packs are only used when each axis is contiguous.
+  if constexpr (lanes<T> > 1 and Source::contiguous_axes) {
+    for (; i + lanes<T> <= src.size(); i += lanes<T>) {
+      P res{reduce_axes<P>(query, src, i, fn)};
+      std::memcpy(out.data() + i, &res, sizeof(res));
+    }
+  }
+  for (; i < src.size(); ++i) {
+    out[i] = reduce_axes<T>(query, src, i, fn);
+  }
+}
+
+template <typename Vec, typename Source>
+[[nodiscard]] constexpr std::size_t
+argmin_distance(const Vec& query, const Source& src) noexcept {
+  using T = Vec::value_type;
+  using P = pack<T>;
+  if (src.size() == 0) {
+    return 0;
+  }
+  std::size_t best_index{};
+  T best{reduce_axes<T>(query, src, 0, abs_diff{})};
+  std::size_t i{};
+  // AoS points stay on the scalar loop, as in transform_reduce
+  if constexpr (lanes<T> > 1 and Source::contiguous_axes) {
+    for (; i + lanes<T> <= src.size(); i += lanes<T>) {
+      P dist{reduce_axes<P>(query, src, i, abs_diff{})};
+      auto is_less{dist < (P{} + best)};
+      bool any_less{false};
+      for (std::size_t lane{}; lane < lanes<T>; ++lane) {
+        any_less |= is_less[lane] != 0;
+      }
+      if (any_less) {
+        for (std::size_t lane{}; lane < lanes<T>; ++lane) {
+          if (dist[lane] < best) {
+            best = dist[lane];
+            best_index = i + lane;
+          }
+        }
+      }
+    }
+  }
+  for (; i < src.size(); ++i) {
+    if (T dist{reduce_axes<T>(query, src, i, abs_diff{})}; dist < best) {
+      best = dist;
+      best_index = i;
+    }
+  }
+  return best_index;
+}
+
+// The transform of one point or one pack of points, given and returned axis by axis.
+template <typename V, typename T, std::size_t N>
+[[nodiscard]] constexpr std::array<V, N>
+apply_affine(const affine<T, N>& m, const std::array<V, N>& in) noexcept {
+  const auto t{std::apply(
+      [](auto... vs) { return std::array<T, N>{vs...}; },
+      m.translation.values()
+  )};
+  std::array<V, N> out{};
+  for (std::size_t row{}; row < N; ++row) {
+    auto acc{static_cast<V>(V{} + t[row])};
+    for (std::size_t col{}; col < N; ++col) {
+      acc = static_cast<V>(acc + m.linear(row, col) * in[col]);
+    }
+    out[row] = acc;
+  }
+  return out;
+}
+
+} // namespace detail
+
+template <typename T, typename... Ts>
+using points_view = std::span<const ndvec<T, Ts...>>;
+
+// out[i] = points[i].distance(query), out must hold at least points.size() values.
+template <typename T, typename... Ts>
+constexpr void distance(
+    const ndvec<T, Ts...>& query,
+    std::type_identity_t<points_view<T, Ts...>> points,
+    std::type_identity_t<std::span<T>> out
+) noexcept {
+  detail::transform_reduce(query, detail::aos_source{points}, out, detail::abs_diff{});
+}
+
+// out[i] = points[i].dot(query)
+template <typename T, typename... Ts>
+constexpr void dot(
+    const ndvec<T, Ts...>& query,
+    std::type_identity_t<points_view<T, Ts...>> points,
+    std::type_identity_t<std::span<T>> out
+) noexcept {
+  detail::transform_reduce(query, detail::aos_source{points}, out, detail::product{});
+}
+
+// out[i] = (points[i] - query).dot(points[i] - query)
+template <typename T, typename... Ts>
+constexpr void squared_l2(
+    const ndvec<T, Ts...>& query,
+    std::type_identity_t<points_view<T, Ts...>> points,
+    std::type_identity_t<std::span<T>> out
+) noexcept {
+  detail::transform_reduce(
+      query,
+      detail::aos_source{points},
+      out,
+      detail::squared_diff{}
+  );
+}
+
+// Index of the first point with the smallest distance to query, or 0 if points is empty.
+template <typename T, typename... Ts>
+[[nodiscard]] constexpr std::size_t argmin_distance(
+    const ndvec<T, Ts...>& query,
+    std::type_identity_t<points_view<T, Ts...>> points
+) noexcept {
+  return detail::argmin_distance(query, detail::aos_source{points});
+}
+
+template <typename T, typename... Ts>
+constexpr void distance(
+    const ndvec<T, Ts...>& query,
+    const soa_vector<ndvec<T, Ts...>>& points,
+    std::type_identity_t<std::span<T>> out
+) noexcept {
+  detail::transform_reduce(query, detail::soa_source{points}, out, detail::abs_diff{});
+}
+
+template <typename T, typename... Ts>
+constexpr void dot(
+    const ndvec<T, Ts...>& query,
+    const soa_vector<ndvec<T, Ts...>>& points,
+    std::type_identity_t<std::span<T>> out
+) noexcept {
+  detail::transform_reduce(query, detail::soa_source{points}, out, detail::product{});
+}
+
+template <typename T, typename... Ts>
+constexpr void squared_l2(
+    const ndvec<T, Ts...>& query,
+    const soa_vector<ndvec<T, Ts...>>& points,
+    std::type_identity_t<std::span<T>> out
+) noexcept {
+  detail::transform_reduce(
+      query,
+      detail::soa_source{points},
+      out,
+      detail::squared_diff{}
+  );
+}
+
+template <typename T, typename... Ts>
+[[nodiscard]] constexpr std::size_t argmin_distance(
+    const ndvec<T, Ts...>& query,
+    const soa_vector<ndvec<T, Ts...>>& points
+) noexcept {
+  return detail::argmin_distance(query, detail::soa_source{points});
+}
+
+// out[i] = m(points[i]), out must hold at least points.size() vecs and may be points.
+// Every point is one unrolled matrix-vector product, which compilers vectorize within
+// the point, so e.g. all 24 rotations of a cloud cost no trigonometry and no branches.
+template <typename T, std::size_t N>
+constexpr void transform(
+    const affine<T, N>& m,
+    std::type_identity_t<std::span<const vecn<T, N>>> points,
+    std::type_identity_t<std::span<vecn<T, N>>> out
+) noexcept {
+  for (std::size_t i{}; i < points.size(); ++i) {
+    out[i] = m(points[i]);
+  }
+}
+
+template <typename T, std::size_t N>
+constexpr void transform(
+    const affine<T, N>& m,
+    std::type_identity_t<std::span<vecn<T, N>>> points
+) noexcept {
+  transform(m, std::span<const vecn<T, N>>(points), points);
+}
+
+// In place, one pack of every column at a time.
+template <typename T, std::size_t N>
+constexpr void transform(const affine<T, N>& m, soa_vector<vecn<T, N>>& points) noexcept {
+  using P = detail::pack<T>;
+  constexpr std::size_t lanes{detail::lanes<T>};
+  std::array<T*, N> columns{};
+  for (std::size_t axis{}; axis < N; ++axis) {
+    columns[axis] = points.axis_data(axis).data();
+  }
+  std::size_t i{};
+  if constexpr (lanes > 1) {
+    for (; i + lanes <= points.size(); i += lanes) {
+      std::array<P, N> in;
+      for (std::size_t axis{}; axis < N; ++axis) {
+        std::memcpy(&in[axis], columns[axis] + i, sizeof(P));
+      }
+      const auto out{detail::apply_affine(m, in)};
+      for (std::size_t axis{}; axis < N; ++axis) {
+        std::memcpy(columns[axis] + i, &out[axis], sizeof(P));
+      }
+    }
+  }
+  for (; i < points.size(); ++i) {
+    std::array<T, N> in;
+    for (std::size_t axis{}; axis < N; ++axis) {
+      in[axis] = columns[axis][i];
+    }
+    const auto out{detail::apply_affine(m, in)};
+    for (std::size_t axis{}; axis < N; ++axis) {
+      columns[axis][i] = out[axis];
+    }
+  }
+}
+
+} // namespace ndvec::batch
+
+#endif // NDVEC_BATCH_HEADER_INCLUDED
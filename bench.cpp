@@ -0,0 +1,1323 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <numbers>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__x86_64__) or defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "automaton.hpp"
+#include "batch.hpp"
+#include "bitgrid.hpp"
+#include "cell_list.hpp"
+#include "curve.hpp"
+#include "expr.hpp"
+#include "flat_hash.hpp"
+#include "grid.hpp"
+#include "kdtree.hpp"
+#include "mat.hpp"
+#include "ndvec.hpp"
+#include "neighborhood.hpp"
+#include "packed_vec.hpp"
+#include "parallel_bfs.hpp"
+#include "parse.hpp"
+#include "point_file.hpp"
+#include "radix_sort.hpp"
+#include "reduce.hpp"
+#include "search.hpp"
+#include "soa_vector.hpp"
+#include "sparse_grid.hpp"
+#include "zobrist.hpp"
+
+using namespace ndvec;
+
+template <typename T> void do_not_optimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Command line options, see usage below.
+struct bench_options {
+  std::string filter{};
+  std::string json_path{};
+  int repeats{15};
+  std::chrono::milliseconds warmup{10};
+};
+
+// Time per element over the repeated runs of one benchmark.
+struct measurement {
+  std::string name{};
+  std::size_t elements{};
+  double min_ns{};
+  double p10_ns{};
+  double median_ns{};
+  double p90_ns{};
+  double max_ns{};
+  // time stamp counter ticks, which run at a constant reference rate on current CPUs
+  std::optional<double> median_cycles{};
+};
+
+bench_options options;
+std::vector<measurement> results;
+
+[[nodiscard]] std::optional<std::uint64_t> cycle_count() noexcept {
+#if defined(__x86_64__) or defined(__i386__)
+  return __rdtsc();
+#else
+  return std::nullopt;
+#endif
+}
+
+// Linear interpolation between the closest ranks of sorted samples.
+[[nodiscard]] double percentile(std::span<const double> sorted, double q) {
+  const double rank{q * static_cast<double>(sorted.size() - 1)};
+  const auto lo{static_cast<std::size_t>(rank)};
+  const std::size_t hi{std::min(lo + 1, sorted.size() - 1)};
+  return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - static_cast<double>(lo));
+}
+
+// Runs fn until the warm-up time has passed, at least twice, and then the number of
+// repeats given in the options, and reports the distribution of the time per element
+// for the n elements fn processes per run.
+template <typename Fn> void measure(std::string_view name, std::size_t n, Fn&& fn) {
+  if (not name.contains(options.filter)) {
+    return;
+  }
+  using clock = std::chrono::steady_clock;
+  const auto warmup_end{clock::now() + options.warmup};
+  for (int run{}; run < 2 or clock::now() < warmup_end; ++run) {
+    fn();
+  }
+  const auto elements{static_cast<double>(std::max(n, std::size_t{1}))};
+  std::vector<double> ns, cycles;
+  for (int r{}; r < options.repeats; ++r) {
+    const auto begin{clock::now()};
+    const auto begin_cycles{cycle_count()};
+    fn();
+    const auto end_cycles{cycle_count()};
+    const auto end{clock::now()};
+    const std::chrono::duration<double, std::nano> elapsed{end - begin};
+    ns.push_back(elapsed.count() / elements);
+    if (begin_cycles and end_cycles) {
+      cycles.push_back(static_cast<double>(*end_cycles - *begin_cycles) / elements);
+    }
+  }
+  std::ranges::sort(ns);
+  std::ranges::sort(cycles);
+  measurement m{
+      .name = std::string(name),
+      .elements = n,
+      .min_ns = ns.front(),
+      .p10_ns = percentile(ns, 0.1),
+      .median_ns = percentile(ns, 0.5),
+      .p90_ns = percentile(ns, 0.9),
+      .max_ns = ns.back(),
+  };
+  if (not cycles.empty()) {
+    m.median_cycles = percentile(cycles, 0.5);
+  }
+  std::println(
+      "{:<56} {:>10.3f} ns/element  p10 {:>10.3f}  p90 {:>10.3f}  {:>8.2f} cycles",
+      m.name,
+      m.median_ns,
+      m.p10_ns,
+      m.p90_ns,
+      m.median_cycles.value_or(std::nan(""))
+  );
+  results.push_back(std::move(m));
+}
+
+void write_json(const std::string& path) {
+  auto quoted{[](std::string_view s) {
+    std::string res{'"'};
+    for (char ch : s) {
+      if (ch == '"' or ch == '\\') {
+        res += '\\';
+      }
+      res += ch;
+    }
+    return res + '"';
+  }};
+  std::string json{
+      std::format("{{\n  \"repeats\": {},\n  \"results\": [\n", options.repeats)
+  };
+  for (std::size_t i{}; i < results.size(); ++i) {
+    const measurement& m{results[i]};
+    std::format_to(
+        std::back_inserter(json),
+        "    {{\"name\": {}, \"elements\": {}, \"min_ns\": {}, \"p10_ns\": {}, "
+        "\"median_ns\": {}, \"p90_ns\": {}, \"max_ns\": {}, \"median_cycles\": {}}}{}\n",
+        quoted(m.name),
+        m.elements,
+        m.min_ns,
+        m.p10_ns,
+        m.median_ns,
+        m.p90_ns,
+        m.max_ns,
+        m.median_cycles ? std::format("{}", *m.median_cycles) : "null",
+        i + 1 < results.size() ? "," : ""
+    );
+  }
+  json += "  ]\n}\n";
+  std::ofstream os(path);
+  os << json;
+  if (not os) {
+    throw std::runtime_error("cannot write " + path);
+  }
+}
+
+[[nodiscard]] std::optional<bench_options> parse_args(int argc, char** argv) {
+  bench_options res;
+  for (int i{1}; i < argc; ++i) {
+    const std::string_view arg{argv[i]};
+    if (i + 1 == argc) {
+      return std::nullopt;
+    }
+    const std::string_view value{argv[++i]};
+    if (arg == "--filter") {
+      res.filter = value;
+    } else if (arg == "--json") {
+      res.json_path = value;
+    } else if (arg == "--repeats") {
+      const auto [end, ec]{std::from_chars(value.begin(), value.end(), res.repeats)};
+      if (ec != std::errc{} or end != value.end() or res.repeats < 1) {
+        return std::nullopt;
+      }
+    } else {
+      return std::nullopt;
+    }
+  }
+  return res;
+}
+
+template <typename Vec> std::vector<Vec> random_points(std::size_t n, std::mt19937& rng) {
+  using T = Vec::value_type;
+  std::vector<Vec> points(n);
+  auto sample{[&rng] {
+    if constexpr (std::integral<T>) {
+      return std::uniform_int_distribution<T>(-1000, 1000)(rng);
+    } else {
+      return std::uniform_real_distribution<T>(-1000, 1000)(rng);
+    }
+  }};
+  for (Vec& p : points) {
+    p.apply([&](T) { return sample(); });
+  }
+  return points;
+}
+
+template <typename T> [[nodiscard]] constexpr std::string_view type_name() {
+  if constexpr (std::same_as<T, short>) {
+    return "short";
+  } else if constexpr (std::same_as<T, int>) {
+    return "int";
+  } else if constexpr (std::same_as<T, long>) {
+    return "long";
+  } else if constexpr (std::same_as<T, long long>) {
+    return "long long";
+  } else if constexpr (std::same_as<T, float>) {
+    return "float";
+  } else if constexpr (std::same_as<T, double>) {
+    return "double";
+  } else {
+    return "long double";
+  }
+}
+
+// Every member and free function of Vec over n pairs of random vectors, with small
+// values so that no product overflows and nonzero divisors.
+template <typename Vec> void bench_members(std::size_t n) {
+  using T = Vec::value_type;
+  const std::string vec_name{std::format("vec{}<{}>", Vec::ndim, type_name<T>())};
+  std::mt19937 rng(n + Vec::ndim);
+  std::vector<Vec> lhs{random_points<Vec>(n, rng)};
+  std::vector<Vec> rhs{random_points<Vec>(n, rng)};
+  for (Vec& p : lhs) {
+    p.apply([](T x) { return static_cast<T>(x / 10); });
+  }
+  for (Vec& p : rhs) {
+    p.apply([](T x) { return static_cast<T>(x / 10 + (x < 0 ? -1 : 1)); });
+  }
+
+  auto each{[&](std::string_view op, auto fn) {
+    using R = std::remove_cvref_t<decltype(fn(lhs[0], rhs[0]))>;
+    std::vector<R> out(n);
+    measure(std::format("{} {}", vec_name, op), n, [&] {
+      for (std::size_t i{}; i < n; ++i) {
+        out[i] = fn(lhs[i], rhs[i]);
+      }
+      do_not_optimize(out.data());
+    });
+  }};
+  each("operator+", [](const Vec& a, const Vec& b) { return a + b; });
+  each("operator-", [](const Vec& a, const Vec& b) { return a - b; });
+  each("operator*", [](const Vec& a, const Vec& b) { return a * b; });
+  each("operator/", [](const Vec& a, const Vec& b) { return a / b; });
+  each("operator+=", [](Vec a, const Vec& b) { return a += b; });
+  each("operator-=", [](Vec a, const Vec& b) { return a -= b; });
+  each("operator*=", [](Vec a, const Vec& b) { return a *= b; });
+  each("operator/=", [](Vec a, const Vec& b) { return a /= b; });
+  each("operator==", [](const Vec& a, const Vec& b) { return int{a == b}; });
+  each("operator<=>", [](const Vec& a, const Vec& b) { return int{(a <=> b) < 0}; });
+  each("min(Vec)", [](const Vec& a, const Vec& b) { return a.min(b); });
+  each("max(Vec)", [](const Vec& a, const Vec& b) { return a.max(b); });
+  each("min()", [](const Vec& a, const Vec&) { return a.min(); });
+  each("max()", [](const Vec& a, const Vec&) { return a.max(); });
+  each("abs", [](const Vec& a, const Vec&) { return a.abs(); });
+  each("signum", [](const Vec& a, const Vec&) { return a.signum(); });
+  each("sum", [](const Vec& a, const Vec&) { return a.sum(); });
+  each("prod", [](const Vec& a, const Vec&) { return a.prod(); });
+  each("distance", [](const Vec& a, const Vec& b) { return a.distance(b); });
+  each("dot", [](const Vec& a, const Vec& b) { return a.dot(b); });
+  if constexpr (Vec::ndim == 3) {
+    each("cross", [](const Vec& a, const Vec& b) { return a.cross(b); });
+  }
+  if constexpr (Vec::ndim == 2) {
+    each("rotate_left", [](Vec a, const Vec&) { return a.rotate_left(); });
+    each("rotate_right", [](Vec a, const Vec&) { return a.rotate_right(); });
+  }
+  if constexpr (Vec::ndim == 2 or Vec::ndim == 3) {
+    each("adjacent", [](const Vec& a, const Vec&) { return a.adjacent(); });
+  }
+  if constexpr (std::integral<T>) {
+    each("std::hash", [](const Vec& a, const Vec&) { return std::hash<Vec>{}(a); });
+  }
+
+  std::string formatted;
+  measure(vec_name + " std::formatter", n, [&] {
+    formatted.clear();
+    for (const Vec& p : lhs) {
+      std::format_to(std::back_inserter(formatted), "{}\n", p);
+    }
+    do_not_optimize(formatted.data());
+  });
+
+  std::string text;
+  for (const Vec& p : lhs) {
+    std::apply([&](auto... vs) { ((text += std::format("{} ", vs)), ...); }, p.values());
+    text += '\n';
+  }
+  measure(vec_name + " operator>>", n, [&] {
+    std::istringstream is(text);
+    std::size_t count{};
+    for (Vec p; is >> p;) {
+      ++count;
+    }
+    do_not_optimize(count);
+  });
+
+  // find_grid_corners from the README
+  measure(vec_name + " find_grid_corners", n, [&] {
+    Vec lo{lhs.front()}, hi{lhs.front()};
+    for (const Vec& p : lhs) {
+      lo = lo.min(p);
+      hi = hi.max(p);
+    }
+    do_not_optimize(lo);
+    do_not_optimize(hi);
+  });
+}
+
+template <typename... Ts> void bench_vec_members(std::size_t n) {
+  (bench_members<vec1<Ts>>(n), ...);
+  (bench_members<vec2<Ts>>(n), ...);
+  (bench_members<vec3<Ts>>(n), ...);
+  (bench_members<vec4<Ts>>(n), ...);
+}
+
+// a + b * c - d with and without the intermediate ndvecs
+template <typename Vec> void bench_expr(std::string_view vec_name, std::size_t n) {
+  std::mt19937 rng(n);
+  const std::vector<Vec> a{random_points<Vec>(n, rng)};
+  const std::vector<Vec> b{random_points<Vec>(n, rng)};
+  const std::vector<Vec> c{random_points<Vec>(n, rng)};
+  const std::vector<Vec> d{random_points<Vec>(n, rng)};
+  std::vector<Vec> out(n);
+  measure(std::format("{} eager a + b * c - d", vec_name), n, [&] {
+    for (std::size_t i{}; i < n; ++i) {
+      out[i] = a[i] + b[i] * c[i] - d[i];
+    }
+    do_not_optimize(out.data());
+  });
+  measure(std::format("{} lazy a + b * c - d", vec_name), n, [&] {
+    for (std::size_t i{}; i < n; ++i) {
+      out[i] = lazy(a[i]) + lazy(b[i]) * c[i] - d[i];
+    }
+    do_not_optimize(out.data());
+  });
+  measure(std::format("{} eager (a + b * c - d).sum()", vec_name), n, [&] {
+    typename Vec::value_type sum{};
+    for (std::size_t i{}; i < n; ++i) {
+      sum += (a[i] + b[i] * c[i] - d[i]).sum();
+    }
+    do_not_optimize(sum);
+  });
+  measure(std::format("{} lazy (a + b * c - d).sum()", vec_name), n, [&] {
+    typename Vec::value_type sum{};
+    for (std::size_t i{}; i < n; ++i) {
+      sum += (lazy(a[i]) + lazy(b[i]) * c[i] - d[i]).sum();
+    }
+    do_not_optimize(sum);
+  });
+}
+
+// Bounding box, sum and centroid of n points, against the serial folds of the README.
+template <typename Vec> void bench_reduce(std::string_view vec_name, std::size_t n) {
+  using T = Vec::value_type;
+  std::mt19937 rng(n);
+  const std::vector<Vec> points{random_points<Vec>(n, rng)};
+  const soa_vector<Vec> soa(points);
+  measure(std::format("{} serial min/max fold", vec_name), n, [&] {
+    Vec lo{points.front()}, hi{points.front()};
+    for (const Vec& p : points) {
+      lo = lo.min(p);
+      hi = hi.max(p);
+    }
+    do_not_optimize(lo);
+    do_not_optimize(hi);
+  });
+  measure(std::format("{} reduce::bounds", vec_name), n, [&] {
+    do_not_optimize(reduce::bounds(points));
+  });
+  measure(std::format("{} reduce::bounds SoA", vec_name), n, [&] {
+    do_not_optimize(reduce::bounds(soa));
+  });
+  measure(std::format("{} reduce::minmax_by_axis", vec_name), n, [&] {
+    do_not_optimize(reduce::minmax_by_axis(points));
+  });
+  measure(std::format("{} serial sum", vec_name), n, [&] {
+    do_not_optimize(std::accumulate(points.begin(), points.end(), Vec()));
+  });
+  measure(std::format("{} reduce::sum", vec_name), n, [&] {
+    do_not_optimize(reduce::sum(points));
+  });
+  if constexpr (std::floating_point<T>) {
+    measure(std::format("{} reduce::sum compensated", vec_name), n, [&] {
+      do_not_optimize(reduce::sum(points, reduce::summation::compensated));
+    });
+  }
+  measure(std::format("{} reduce::centroid", vec_name), n, [&] {
+    do_not_optimize(reduce::centroid(points));
+  });
+}
+
+template <typename Vec> void bench_batch(std::string_view vec_name, std::size_t n) {
+  using T = Vec::value_type;
+  std::mt19937 rng(n);
+  const std::vector<Vec> aos{random_points<Vec>(n, rng)};
+  const soa_vector<Vec> soa(aos);
+  const Vec query{random_points<Vec>(1, rng).front()};
+  std::vector<T> out(n);
+
+  measure(
+      std::format("{} naive distance", vec_name),
+      n,
+      [&] {
+        for (std::size_t i{}; i < n; ++i) {
+          out[i] = aos[i].distance(query);
+        }
+        do_not_optimize(out.data());
+      }
+  );
+  measure(
+      std::format("{} batch::distance AoS", vec_name),
+      n,
+      [&] {
+        batch::distance(query, aos, out);
+        do_not_optimize(out.data());
+      }
+  );
+  measure(
+      std::format("{} batch::distance SoA", vec_name),
+      n,
+      [&] {
+        batch::distance(query, soa, out);
+        do_not_optimize(out.data());
+      }
+  );
+  measure(
+      std::format("{} naive dot", vec_name),
+      n,
+      [&] {
+        for (std::size_t i{}; i < n; ++i) {
+          out[i] = aos[i].dot(query);
+        }
+        do_not_optimize(out.data());
+      }
+  );
+  measure(
+      std::format("{} batch::dot SoA", vec_name),
+      n,
+      [&] {
+        batch::dot(query, soa, out);
+        do_not_optimize(out.data());
+      }
+  );
+  measure(
+      std::format("{} naive argmin distance", vec_name),
+      n,
+      [&] {
+        auto it{std::ranges::min_element(aos, {}, [&](const Vec& p) {
+          return p.distance(query);
+        })};
+        do_not_optimize(it);
+      }
+  );
+  measure(
+      std::format("{} batch::argmin_distance SoA", vec_name),
+      n,
+      [&] {
+        auto i{batch::argmin_distance(query, soa)};
+        do_not_optimize(i);
+      }
+  );
+}
+
+// The std::hash<ndvec> that was used before the mixing hash, kept for comparison.
+template <typename Vec> struct shift_xor_hash {
+  std::size_t operator()(const Vec& v) const noexcept {
+    using T = Vec::value_type;
+    constexpr auto slot_width{std::numeric_limits<std::size_t>::digits / Vec::ndim};
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      return (... ^ (std::hash<T>{}(v.template get<axes>()) << (slot_width * axes)));
+    }(typename Vec::axes_indices{});
+  }
+};
+
+// BFS over a box of the given side length with walls on every cell whose coordinates are
+// all odd, returns the number of visited cells. The visited set stores Key(vec).
+template <typename Vec, typename Set, typename Key = Vec>
+std::size_t bfs_visited(int side) {
+  Vec center;
+  center.apply([side](auto) { return side / 2; });
+  Set visited;
+  visited.insert(Key(center));
+  std::vector<Vec> frontier{center}, next;
+  while (not frontier.empty()) {
+    for (const Vec& p : frontier) {
+      for (const Vec& adj : p.adjacent()) {
+        const bool in_box{adj.min() >= 0 and adj.max() < side};
+        if (in_box and Vec(adj).apply([](auto v) { return v & 1; }).prod() == 0
+            and visited.insert(Key(adj)).second) {
+          next.push_back(adj);
+        }
+      }
+    }
+    frontier.swap(next);
+    next.clear();
+  }
+  return visited.size();
+}
+
+template <typename Vec, typename Packed>
+void bench_visited_sets(std::string_view vec_name, int side) {
+  const std::size_t n{bfs_visited<Vec, flat_set<Vec>>(side)};
+  measure(
+      std::format("{} BFS unordered_set shift-xor hash", vec_name),
+      n,
+      [&] {
+        using set = std::unordered_set<Vec, shift_xor_hash<Vec>>;
+        do_not_optimize(bfs_visited<Vec, set>(side));
+      }
+  );
+  measure(
+      std::format("{} BFS unordered_set", vec_name),
+      n,
+      [&] { do_not_optimize(bfs_visited<Vec, std::unordered_set<Vec>>(side)); }
+  );
+  measure(
+      std::format("{} BFS flat_set", vec_name),
+      n,
+      [&] { do_not_optimize(bfs_visited<Vec, flat_set<Vec>>(side)); }
+  );
+  measure(
+      std::format("{} BFS unordered_set packed_vec<{}>", vec_name, Packed::bits),
+      n,
+      [&] {
+        using set = std::unordered_set<Packed>;
+        do_not_optimize(bfs_visited<Vec, set, Packed>(side));
+      }
+  );
+  measure(
+      std::format("{} BFS flat_set packed_vec<{}>", vec_name, Packed::bits),
+      n,
+      [&] { do_not_optimize(bfs_visited<Vec, flat_set<Packed>, Packed>(side)); }
+  );
+}
+
+// Sums the grid cells at the given points, in random order and after sorting the points
+// along each curve.
+void bench_curve_order(int side, std::size_t n) {
+  using Vec = vec3<int>;
+  std::mt19937 rng(n);
+  grid<int, 3> cells(Vec(side, side, side));
+  for (int& cell : cells) {
+    cell = std::uniform_int_distribution<int>(0, 9)(rng);
+  }
+  std::vector<Vec> points(n);
+  for (Vec& p : points) {
+    p.apply([&](int) { return std::uniform_int_distribution<int>(0, side - 1)(rng); });
+  }
+  auto sum_cells{[&] {
+    long sum{};
+    for (const Vec& p : points) {
+      sum += cells[p];
+    }
+    do_not_optimize(sum);
+  }};
+  measure("vec3<int> grid lookup random order", n, sum_cells);
+  sort_by_curve(points, space_filling_curve::morton);
+  measure("vec3<int> grid lookup morton order", n, sum_cells);
+  sort_by_curve(points, space_filling_curve::hilbert);
+  measure("vec3<int> grid lookup hilbert order", n, sum_cells);
+  measure(
+      "vec3<int> sort_by_curve morton",
+      n,
+      [&] { sort_by_curve(points, space_filling_curve::morton); }
+  );
+  measure(
+      "vec3<int> sort_by_curve hilbert",
+      n,
+      [&] { sort_by_curve(points, space_filling_curve::hilbert); }
+  );
+}
+
+template <typename Vec> void bench_kdtree(std::string_view vec_name, std::size_t n) {
+  std::mt19937 rng(n);
+  const std::vector<Vec> points{random_points<Vec>(n, rng)};
+  const soa_vector<Vec> soa(points);
+  const std::vector<Vec> queries{random_points<Vec>(100, rng)};
+
+  measure(
+      std::format("{} kdtree build", vec_name),
+      n,
+      [&] { do_not_optimize(kdtree(points).size()); }
+  );
+  const kdtree tree(points);
+  measure(
+      std::format("{} naive nearest, per query", vec_name),
+      queries.size(),
+      [&] {
+        for (const Vec& q : queries) {
+          auto it{std::ranges::min_element(points, {}, [&](const Vec& p) {
+            return p.distance(q);
+          })};
+          do_not_optimize(it);
+        }
+      }
+  );
+  measure(
+      std::format("{} batch::argmin_distance, per query", vec_name),
+      queries.size(),
+      [&] {
+        for (const Vec& q : queries) {
+          do_not_optimize(batch::argmin_distance(q, soa));
+        }
+      }
+  );
+  measure(
+      std::format("{} kdtree nearest, per query", vec_name),
+      queries.size(),
+      [&] {
+        for (const Vec& q : queries) {
+          do_not_optimize(tree.nearest(q));
+        }
+      }
+  );
+  measure(
+      std::format("{} kdtree 10 nearest, per query", vec_name),
+      queries.size(),
+      [&] {
+        for (const Vec& q : queries) {
+          do_not_optimize(tree.nearest(q, 10).data());
+        }
+      }
+  );
+}
+
+// All neighbours within radius of every point, with density of about 30 points per cell.
+template <typename Vec> void bench_cell_list(std::string_view vec_name, std::size_t n) {
+  using T = Vec::value_type;
+  using Metric = metric::squared_euclidean;
+  std::mt19937 rng(n);
+  const T radius{1};
+  const T side{std::pow(T(n) / 30, T(1) / T(Vec::ndim))};
+  std::vector<Vec> points(n);
+  for (Vec& p : points) {
+    p.apply([&](T) { return std::uniform_real_distribution<T>(0, side)(rng); });
+  }
+
+  measure(
+      std::format("{} brute force neighbours, per point", vec_name),
+      n,
+      [&] {
+        std::size_t count{};
+        for (const Vec& p : points) {
+          for (const Vec& q : points) {
+            count += metric::distance<Metric>(p, q) <= radius;
+          }
+        }
+        do_not_optimize(count);
+      }
+  );
+  measure(
+      std::format("{} cell_list build, per point", vec_name),
+      n,
+      [&] { do_not_optimize(cell_list(points, radius).size()); }
+  );
+  cell_list cells(points, radius);
+  measure(
+      std::format("{} cell_list neighbours, per point", vec_name),
+      n,
+      [&] {
+        auto adjacency{cells.within_radius(points, radius, Metric{})};
+        do_not_optimize(adjacency.indices.data());
+      }
+  );
+  std::vector<Vec> moved{points};
+  for (Vec& p : moved) {
+    p.apply([&](T v) { return v + std::uniform_real_distribution<T>(-0.01, 0.01)(rng); });
+  }
+  measure(
+      std::format("{} cell_list update, per point", vec_name),
+      2 * n,
+      [&] {
+        cells.update(moved);
+        cells.update(points);
+      }
+  );
+}
+
+// Searches over a maze of walls and random step weights 1 to 9, from the center to every
+// reachable cell.
+template <typename Vec> void bench_search(std::string_view vec_name, int side) {
+  using T = Vec::value_type;
+  std::mt19937 rng(side);
+  Vec extent;
+  extent.apply([side](T) { return side; });
+  grid<int, Vec::ndim, T> costs(extent);
+  for (int& c : costs) {
+    c = std::uniform_int_distribution(0, 3)(rng) == 0 ? -1 : 1 + int(rng() % 9);
+  }
+  Vec start;
+  start.apply([side](T) { return side / 2; });
+  costs[start] = 1;
+  auto is_open{[&](const Vec& p) { return costs.contains(p) and costs[p] >= 0; }};
+  auto weight{[&](const Vec&, const Vec& to) -> std::optional<int> {
+    return is_open(to) ? std::optional<int>(costs[to]) : std::nullopt;
+  }};
+  search::dense_engine<Vec> dense(Vec(), extent);
+  search::hashed_engine<Vec> hashed;
+  std::size_t n{};
+  (void)dense.bfs(start, is_open, [&n](const Vec&, int) { ++n; });
+
+  measure(
+      std::format("{} BFS deque unordered_set, per node", vec_name),
+      n,
+      [&] {
+        std::unordered_set<Vec> visited;
+        int total{};
+        for (std::deque q{std::pair{start, 0}}; not q.empty(); q.pop_front()) {
+          auto [pos, len]{q.front()};
+          if (not is_open(pos)) {
+            continue;
+          }
+          if (visited.insert(pos).second) {
+            total += len;
+            for (const Vec& adj : pos.adjacent()) {
+              q.emplace_back(adj, len + 1);
+            }
+          }
+        }
+        do_not_optimize(total);
+      }
+  );
+  auto sum_bfs{[&](auto& engine) {
+    int total{};
+    (void)engine.bfs(start, is_open, [&total](const Vec&, int d) { total += d; });
+    do_not_optimize(total);
+  }};
+  measure(
+      std::format("{} BFS hashed engine, per node", vec_name),
+      n,
+      [&] { sum_bfs(hashed); }
+  );
+  measure(
+      std::format("{} BFS dense engine, per node", vec_name),
+      n,
+      [&] { sum_bfs(dense); }
+  );
+  measure(
+      std::format("{} Dijkstra priority_queue unordered_map, per node", vec_name),
+      n,
+      [&] {
+        using entry = std::pair<int, Vec>;
+        std::priority_queue<entry, std::vector<entry>, std::greater<>> queue;
+        std::unordered_map<Vec, int> dist{{start, 0}};
+        int total{};
+        for (queue.emplace(0, start); not queue.empty();) {
+          auto [d, pos]{queue.top()};
+          queue.pop();
+          if (d > dist[pos]) {
+            continue;
+          }
+          total += d;
+          for (const Vec& adj : pos.adjacent()) {
+            if (auto w{weight(pos, adj)}) {
+              auto [it, is_new]{dist.try_emplace(adj, d + *w)};
+              if (is_new or d + *w < it->second) {
+                it->second = d + *w;
+                queue.emplace(d + *w, adj);
+              }
+            }
+          }
+        }
+        do_not_optimize(total);
+      }
+  );
+  auto sum_dijkstra{[&](auto& engine) {
+    int total{};
+    (void)engine.dijkstra(start, weight, 9, [&total](const Vec&, int d) { total += d; });
+    do_not_optimize(total);
+  }};
+  measure(
+      std::format("{} Dijkstra hashed engine, per node", vec_name),
+      n,
+      [&] { sum_dijkstra(hashed); }
+  );
+  measure(
+      std::format("{} Dijkstra dense engine, per node", vec_name),
+      n,
+      [&] { sum_dijkstra(dense); }
+  );
+}
+
+enum class forest : std::uint8_t { open, tree, yard };
+
+// Generations of the 2018 day 18 lumber collection rule on random boards.
+void bench_automaton(int side, int map_side) {
+  using Vec = vec2<int>;
+  std::mt19937 rng(side);
+  auto lumber{[](forest f, int trees, int yards) {
+    switch (f) {
+      case forest::open:
+        return trees >= 3 ? forest::tree : f;
+      case forest::tree:
+        return yards >= 3 ? forest::yard : f;
+      case forest::yard:
+        return yards > 0 and trees > 0 ? f : forest::open;
+    }
+    return f;
+  }};
+
+  std::map<Vec, forest> tiles;
+  for (Vec p; p.y() < map_side; p.y() += 1) {
+    for (p.x() = 0; p.x() < map_side; p.x() += 1) {
+      tiles[p] = forest(rng() % 3);
+    }
+  }
+  auto count_adjacent{[&](const Vec& center, forest f) {
+    int n{};
+    for (Vec d(-1, -1); d.x() <= 1; d.x() += 1) {
+      for (d.y() = -1; d.y() <= 1; d.y() += 1) {
+        if (Vec p{center + d}; p != center and tiles.contains(p) and tiles.at(p) == f) {
+          n += 1;
+        }
+      }
+    }
+    return n;
+  }};
+  measure(
+      std::format("{}x{} automaton std::map step, per cell", map_side, map_side),
+      tiles.size(),
+      [&] {
+        auto after{tiles};
+        for (auto&& [p, f] : tiles) {
+          const int trees{count_adjacent(p, forest::tree)};
+          const int yards{count_adjacent(p, forest::yard)};
+          after[p] = lumber(f, trees, yards);
+        }
+        tiles.swap(after);
+      }
+  );
+
+  grid<forest, 2> cells(Vec(side, side));
+  for (forest& f : cells) {
+    f = forest(rng() % 3);
+  }
+  automaton life(cells);
+  auto rule{[&](forest f, auto counts) {
+    return lumber(f, counts.count(forest::tree), counts.count(forest::yard));
+  }};
+  measure(
+      std::format("{}x{} automaton step, per cell", side, side),
+      cells.size(),
+      [&] { life.step(rule); }
+  );
+}
+
+// Parsing n whitespace-separated points and a side x side grid of digits.
+void bench_parse(std::size_t n, int side) {
+  using Vec = vec3<int>;
+  std::mt19937 rng(n);
+  std::string text;
+  for (std::size_t i{}; i < n; ++i) {
+    auto value{[&rng] { return std::uniform_int_distribution(-100'000, 100'000)(rng); }};
+    text += std::format("{} {} {}\n", value(), value(), value());
+  }
+  measure(
+      "vec3<int> istream operator>>, per point",
+      n,
+      [&] {
+        std::istringstream is(text);
+        std::vector<Vec> points;
+        for (Vec p; is >> p;) {
+          points.push_back(p);
+        }
+        do_not_optimize(points.data());
+      }
+  );
+  measure(
+      "vec3<int> parse_points, per point",
+      n,
+      [&] { do_not_optimize(parse_points<Vec>(text).data()); }
+  );
+
+  std::string digits;
+  for (int y{}; y < side; ++y) {
+    for (int x{}; x < side; ++x) {
+      digits += static_cast<char>('0' + rng() % 10);
+    }
+    digits += '\n';
+  }
+  const std::size_t cells{static_cast<std::size_t>(side) * side};
+  measure(
+      std::format("{}x{} README parse_grid, per cell", side, side),
+      cells,
+      [&] {
+        std::istringstream is(digits);
+        std::unordered_map<vec2<int>, int> g;
+        vec2<int> p;
+        for (std::string line; std::getline(is, line); p.y() += 1) {
+          for (p.x() = 0; unsigned char ch : line) {
+            g[p] = ch - '0';
+            p.x() += 1;
+          }
+        }
+        do_not_optimize(g.size());
+      }
+  );
+  measure(
+      std::format("{}x{} parse_grid, per cell", side, side),
+      cells,
+      [&] {
+        auto g{parse_grid(digits, [](char c) { return c - '0'; })};
+        do_not_optimize(g.cells().data());
+      }
+  );
+}
+
+// Loading n points and summing them, from text and from binary point files.
+void bench_point_file(std::size_t n) {
+  using Vec = vec3<float>;
+  std::mt19937 rng(n);
+  const std::vector<Vec> points{random_points<Vec>(n, rng)};
+  std::string text;
+  for (const Vec& p : points) {
+    text += std::format("{} {} {}\n", p.x(), p.y(), p.z());
+  }
+  const auto dir{std::filesystem::temp_directory_path()};
+  const auto text_path{dir / "ndvec_bench_points.txt"};
+  const auto aos_path{dir / "ndvec_bench_points_aos.bin"};
+  const auto soa_path{dir / "ndvec_bench_points_soa.bin"};
+  std::ofstream(text_path) << text;
+  write_points(aos_path, points);
+  write_points(soa_path, points, point_layout::soa);
+
+  measure(
+      "vec3<float> parse_points_file and sum, per point",
+      n,
+      [&] {
+        const auto loaded{parse_points_file<Vec>(text_path)};
+        do_not_optimize(std::accumulate(loaded.begin(), loaded.end(), Vec()));
+      }
+  );
+  measure(
+      "vec3<float> point_file AoS read and sum, per point",
+      n,
+      [&] {
+        const auto loaded{point_file(aos_path).read<Vec>()};
+        do_not_optimize(std::accumulate(loaded.begin(), loaded.end(), Vec()));
+      }
+  );
+  measure(
+      "vec3<float> point_file SoA axes sum, per point",
+      n,
+      [&] {
+        const point_file file(soa_path);
+        float sum{};
+        for (std::size_t axis{}; axis < Vec::ndim; ++axis) {
+          const std::span<const float> values{file.axis<float>(axis)};
+          sum += std::accumulate(values.begin(), values.end(), 0.0f);
+        }
+        do_not_optimize(sum);
+      }
+  );
+  std::filesystem::remove(text_path);
+  std::filesystem::remove(aos_path);
+  std::filesystem::remove(soa_path);
+}
+
+// Sum over the Moore neighbourhood of every inner cell of a 4D grid, with hand-written
+// loops over the offsets and with the unrolled neighbors().
+void bench_neighborhood(int side) {
+  using Vec = vec4<int>;
+  std::mt19937 rng(side);
+  grid<int, 4> cells(Vec(side, side, side, side));
+  for (int& c : cells) {
+    c = static_cast<int>(rng() % 100);
+  }
+  std::vector<Vec> inner;
+  for (std::size_t i{}; i < cells.size(); ++i) {
+    if (const Vec p{cells.position(i)}; p.min() > 0 and p.max() < side - 1) {
+      inner.push_back(p);
+    }
+  }
+  measure("4D moore stencil, nested loops", inner.size(), [&] {
+    long long total{};
+    for (const Vec& center : inner) {
+      for (Vec d(-1, -1, -1, -1); d.x() <= 1; d.x() += 1) {
+        for (d.y() = -1; d.y() <= 1; d.y() += 1) {
+          for (d.z() = -1; d.z() <= 1; d.z() += 1) {
+            for (d.w() = -1; d.w() <= 1; d.w() += 1) {
+              if (d != Vec()) {
+                total += cells[center + d];
+              }
+            }
+          }
+        }
+      }
+    }
+    do_not_optimize(total);
+  });
+  measure("4D moore stencil, moore_offsets loop", inner.size(), [&] {
+    long long total{};
+    for (const Vec& center : inner) {
+      for (const Vec& d : moore_offsets<Vec>()) {
+        total += cells[center + d];
+      }
+    }
+    do_not_optimize(total);
+  });
+  measure("4D moore stencil, neighbors", inner.size(), [&] {
+    long long total{};
+    for (const Vec& center : inner) {
+      for (const Vec& p : neighbors<neighborhood::moore>(center)) {
+        total += cells[p];
+      }
+    }
+    do_not_optimize(total);
+  });
+}
+
+// All 24 orientations of a point cloud, with rotations computed from angles by
+// trigonometry as in the README and from the exact table of rotations.
+template <typename T> void bench_orientations(std::size_t n) {
+  using Vec = vec3<T>;
+  std::mt19937 rng(n);
+  const std::vector<Vec> cloud{random_points<Vec>(n, rng)};
+  std::vector<Vec> out(n);
+  const auto name{type_name<T>()};
+
+  // 24 combinations of quarter turns about the x, y and z axes
+  std::vector<std::array<int, 3>> turns;
+  for (int yaw{}; yaw < 4; ++yaw) {
+    for (int pitch{}; pitch < 4; ++pitch) {
+      for (int roll{}; roll < 4; ++roll) {
+        turns.push_back({yaw, pitch, roll});
+      }
+    }
+  }
+  turns.resize(24);
+  auto rotate{[](const Vec& p, const std::array<int, 3>& t) {
+    std::array<T, 3> v{p.x(), p.y(), p.z()};
+    for (std::size_t axis{}; axis < 3; ++axis) {
+      const double angle{t[axis] * std::numbers::pi / 2};
+      const auto cos{std::round(std::cos(angle))};
+      const auto sin{std::round(std::sin(angle))};
+      const std::size_t i{(axis + 1) % 3}, j{(axis + 2) % 3};
+      const auto vi{static_cast<T>(v[i] * cos - v[j] * sin)};
+      v[j] = static_cast<T>(v[i] * sin + v[j] * cos);
+      v[i] = vi;
+    }
+    return Vec(v[0], v[1], v[2]);
+  }};
+  measure(
+      std::format("vec3<{}> 24 orientations, trigonometry", name),
+      24 * n,
+      [&] {
+        for (const auto& t : turns) {
+          for (std::size_t i{}; i < n; ++i) {
+            out[i] = rotate(cloud[i], t);
+          }
+          do_not_optimize(out.data());
+        }
+      }
+  );
+  measure(
+      std::format("vec3<{}> 24 orientations, batch::transform AoS", name),
+      24 * n,
+      [&] {
+        for (const mat<T, 3>& r : rotations<T, 3>()) {
+          batch::transform(affine<T, 3>{r}, cloud, out);
+          do_not_optimize(out.data());
+        }
+      }
+  );
+  soa_vector<Vec> soa(cloud);
+  measure(
+      std::format("vec3<{}> 24 orientations, batch::transform SoA", name),
+      24 * n,
+      [&] {
+        for (const mat<T, 3>& r : rotations<T, 3>()) {
+          batch::transform(affine<T, 3>{r}, soa);
+          do_not_optimize(soa.axis_data(0).data());
+        }
+      }
+  );
+}
+
+// Sorting and deduplicating points with std::ranges::sort and with the radix sort.
+template <typename Vec> void bench_radix_sort(std::string_view vec_name, std::size_t n) {
+  std::mt19937 rng(n);
+  const std::vector<Vec> points{random_points<Vec>(n, rng)};
+  std::vector<Vec> work(n);
+  auto sorted{[&](std::string_view what, auto&& sort) {
+    measure(std::format("{} {}", vec_name, what), n, [&] {
+      work = points;
+      sort(work);
+      do_not_optimize(work.data());
+    });
+  }};
+  sorted("copy only", [](auto&) {});
+  sorted("std::ranges::sort", [](auto& w) { std::ranges::sort(w); });
+  sorted("radix_sort", [](auto& w) { radix_sort(w); });
+  sorted("std::ranges::sort + unique", [](auto& w) {
+    std::ranges::sort(w);
+    w.erase(std::ranges::unique(w).begin(), w.end());
+  });
+  sorted("sort_unique", [](auto& w) { w.resize(sort_unique(w)); });
+  sorted("sort_by_curve morton", [](auto& w) { sort_by_curve(w); });
+  sorted("radix_sort morton", [](auto& w) { radix_sort<sort_order::morton>(w); });
+}
+
+// BFS over a box where a quarter of the cells are walls, with dense_engine and with
+// parallel_bfs in each direction.
+template <typename Vec> void bench_parallel_bfs(std::string_view vec_name, int side) {
+  using T = Vec::value_type;
+  std::mt19937 rng(side);
+  Vec extent;
+  extent.apply([side](T) { return side; });
+  grid<std::uint8_t, Vec::ndim, T> walls(extent);
+  for (std::uint8_t& w : walls) {
+    w = rng() % 4 == 0;
+  }
+  Vec start;
+  start.apply([side](T) { return side / 2; });
+  walls[start] = 0;
+  auto is_open{[&](const Vec& p) { return walls[p] == 0; }};
+  search::dense_engine<Vec> dense(Vec(), extent);
+  std::size_t n{};
+  (void)dense.bfs(start, is_open, [&n](const Vec&, int) { ++n; });
+  measure(std::format("{} {} BFS dense_engine, per node", side, vec_name), n, [&] {
+    int total{};
+    (void)dense.bfs(start, is_open, [&total](const Vec&, int d) { total += d; });
+    do_not_optimize(total);
+  });
+  search::parallel_bfs<Vec> bfs(Vec(), extent);
+  for (auto [direction, name] : {
+           std::pair{search::bfs_direction::automatic, "automatic"},
+           std::pair{search::bfs_direction::top_down, "top-down"},
+           std::pair{search::bfs_direction::bottom_up, "bottom-up"},
+       }) {
+    measure(
+        std::format("{} {} BFS parallel_bfs {}, per node", side, vec_name, name),
+        n,
+        [&] { do_not_optimize(bfs.run(start, is_open, {.direction = direction})); }
+    );
+  }
+}
+
+// Game of life steps on a side x side board with automaton and with bitgrid.
+void bench_bitgrid(int side, int automaton_side) {
+  using Vec = vec2<int>;
+  std::mt19937 rng(side);
+  grid<std::uint8_t, 2> cells(Vec(automaton_side, automaton_side));
+  for (std::uint8_t& c : cells) {
+    c = rng() % 2;
+  }
+  automaton life(cells);
+  measure(
+      std::format("{0}x{0} game of life automaton step, per cell", automaton_side),
+      cells.size(),
+      [&] {
+        life.step([](std::uint8_t alive, auto counts) -> std::uint8_t {
+          const int n{counts.count(1)};
+          return n == 3 or (alive and n == 2);
+        });
+      }
+  );
+  bitgrid<2> board(Vec(side, side));
+  for (Vec p; p.y() < side; p.y() += 1) {
+    for (p.x() = 0; p.x() < side; p.x() += 1) {
+      board.set(p, rng() % 2);
+    }
+  }
+  measure(
+      std::format("{0}x{0} game of life bitgrid step, per cell", side),
+      board.size(),
+      [&] { board.step(); }
+  );
+  measure(
+      std::format("{0}x{0} highlife bitgrid step, per cell", side),
+      board.size(),
+      [&] { board.step({.birth = (1 << 3) | (1 << 6), .survive = (1 << 2) | (1 << 3)}); }
+  );
+  measure(
+      std::format("{0}x{0} bitgrid count quarter, per cell", side),
+      board.size() / 4,
+      [&] { do_not_optimize(board.count(Vec(), Vec(side / 2 - 1, side / 2 - 1))); }
+  );
+}
+
+// Hashing a side x side grid of the lumber automaton from scratch and updating the hash
+// of a zobrist_grid one write at a time.
+void bench_zobrist(int side, std::size_t writes) {
+  using Vec = vec2<int>;
+  std::mt19937 rng(side);
+  grid<forest, 2> cells(Vec(side, side));
+  for (forest& f : cells) {
+    f = forest(rng() % 3);
+  }
+  measure(std::format("{0}x{0} zobrist_hash, per cell", side), cells.size(), [&] {
+    do_not_optimize(zobrist_hash(cells));
+  });
+  std::vector<std::pair<Vec, forest>> updates(writes);
+  for (auto& [p, f] : updates) {
+    p = cells.position(rng() % cells.size());
+    f = forest(rng() % 3);
+  }
+  zobrist_grid z(cells);
+  measure(std::format("{0}x{0} zobrist_grid set, per write", side), writes, [&] {
+    for (const auto& [p, f] : updates) {
+      z.set(p, f);
+    }
+    do_not_optimize(z.hash());
+  });
+}
+
+// A random walk of n steps that counts the visits of each cell and reads the cell to
+// its left, like a spreading simulation on an unbounded grid.
+template <typename Map> int walk_counts(std::size_t n, std::uint64_t seed) {
+  using Vec = vec2<int>;
+  constexpr std::array<Vec, 4> dirs{Vec(1, 0), Vec(-1, 0), Vec(0, 1), Vec(0, -1)};
+  std::mt19937_64 rng(seed);
+  Map visits;
+  Vec p;
+  int sum{};
+  for (std::size_t step{}; step < n; ++step) {
+    p += dirs[rng() % dirs.size()];
+    ++visits[p];
+    sum += visits[p - Vec(1, 0)];
+  }
+  return sum;
+}
+
+void bench_sparse_grid(std::size_t n) {
+  using Vec = vec2<int>;
+  measure("vec2<int> random walk std::map", n, [&] {
+    do_not_optimize(walk_counts<std::map<Vec, int>>(n, n));
+  });
+  measure("vec2<int> random walk unordered_map", n, [&] {
+    do_not_optimize(walk_counts<std::unordered_map<Vec, int>>(n, n));
+  });
+  measure("vec2<int> random walk flat_map", n, [&] {
+    do_not_optimize(walk_counts<flat_map<Vec, int>>(n, n));
+  });
+  measure("vec2<int> random walk sparse_grid<int, 2>", n, [&] {
+    do_not_optimize(walk_counts<sparse_grid<int, 2>>(n, n));
+  });
+}
+
+int main(int argc, char** argv) {
+  if (const auto parsed{parse_args(argc, argv)}) {
+    options = *parsed;
+  } else {
+    std::println(
+        stderr,
+        "usage: {} [--filter SUBSTRING] [--repeats N] [--json PATH]",
+        argv[0]
+    );
+    return 2;
+  }
+  constexpr std::size_t n{1'000'000};
+  bench_vec_members<short, int, long, long long, float, double, long double>(1 << 14);
+  bench_expr<vecn<int, 6>>("vec6<int>", 1 << 16);
+  bench_expr<vec4<float>>("vec4<float>", 1 << 16);
+  bench_expr<vecn<double, 6>>("vec6<double>", 1 << 16);
+  bench_batch<vec2<int>>("vec2<int>", n);
+  bench_batch<vec3<int>>("vec3<int>", n);
+  bench_batch<vec3<float>>("vec3<float>", n);
+  bench_batch<vec4<double>>("vec4<double>", n);
+  bench_visited_sets<vec2<int>, packed_vec<15, 2>>("vec2<int>", 500);
+  bench_visited_sets<vec3<int>, packed_vec<20, 3>>("vec3<int>", 60);
+  bench_curve_order(128, n);
+  bench_kdtree<vec3<int>>("vec3<int>", n);
+  bench_kdtree<vec3<float>>("vec3<float>", n);
+  bench_cell_list<vec2<double>>("vec2<double>", 10'000);
+  bench_cell_list<vec3<double>>("vec3<double>", 10'000);
+  bench_search<vec2<int>>("vec2<int>", 500);
+  bench_search<vec3<int>>("vec3<int>", 60);
+  bench_parallel_bfs<vec2<int>>("vec2<int>", 4000);
+  bench_parallel_bfs<vec3<int>>("vec3<int>", 250);
+  bench_automaton(1000, 200);
+  bench_bitgrid(10'000, 1000);
+  bench_zobrist(1000, n);
+  bench_parse(n, 1000);
+  bench_point_file(n);
+  bench_reduce<vec2<int>>("vec2<int>", 10 * n);
+  bench_reduce<vec3<float>>("vec3<float>", 10 * n);
+  bench_reduce<vec4<double>>("vec4<double>", 10 * n);
+  bench_neighborhood(24);
+  bench_orientations<int>(4096);
+  bench_orientations<float>(4096);
+  bench_radix_sort<vec2<int>>("vec2<int>", 10 * n);
+  bench_radix_sort<vec3<int>>("vec3<int>", 10 * n);
+  bench_sparse_grid(n);
+  if (not options.json_path.empty()) {
+    write_json(options.json_path);
+  }
+  return 0;
+}
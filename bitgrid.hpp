@@ -0,0 +1,349 @@
+#ifndef NDVEC_BITGRID_HEADER_INCLUDED
+#define NDVEC_BITGRID_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "grid.hpp"
+#include "ndvec.hpp"
+#include "parallel.hpp"
+
+namespace ndvec {
+
+// Birth and survival conditions of a life-like automaton on the Moore neighbourhood: a
+// dead cell with n live neighbours becomes alive if bit n of birth is set, and a live
+// cell stays alive if bit n of survive is set.
+struct life_rule {
+  std::uint16_t birth{};
+  std::uint16_t survive{};
+
+  // B3/S23
+  [[nodiscard]] static constexpr life_rule conway() noexcept {
+    return {.birth = 1 << 3, .survive = (1 << 2) | (1 << 3)};
+  }
+
+  [[nodiscard]] constexpr bool operator==(const life_rule&) const = default;
+};
+
+// Dense grid of bits covering the box [origin, origin + extent), one bit per cell. Every
+// row along axis 0 is stored in 64-bit words, bit b of word j being the cell at
+// x = 64 * j + b, and the rows are ordered like the cells of grid. Each row is followed
+// by a zero guard word and the rows are framed by zero guard rows, so that a word's
+// neighbours can be read without bounds checks. The unused bits of the last word of a
+// row are always zero.
+//
+// step() computes the neighbour counts of 64 cells at once with bit-sliced adders: the
+// 8 neighbour rows, shifted so that each neighbour lines up with its cell, are added
+// into 4 bit planes holding the binary digits of the counts. The loop over the words of
+// a row has no branches or loop-carried dependencies, so with AVX2 it is vectorized to
+// 256 cells per instruction. Rows are stepped in parallel.
+template <std::size_t ndim, std::integral T = int>
+  requires(ndim > 0)
+class bitgrid {
+public:
+  using vec = vecn<T, ndim>;
+  using size_type = std::size_t;
+  using word_type = std::uint64_t;
+
+  static constexpr size_type word_bits{64};
+
+private:
+  using unsigned_type = std::make_unsigned_t<T>;
+  using coords_type = std::array<T, ndim>;
+
+  static constexpr size_type min_rows_per_thread{64};
+
+  vec origin_{};
+  vec extent_{};
+  size_type row_words_{};
+  size_type rows_{};
+  std::vector<word_type> words_{};
+  // the next generation, allocated by the first step
+  std::vector<word_type> next_{};
+
+  [[nodiscard]] static constexpr coords_type coords(const vec& v) noexcept {
+    return std::apply([](auto... vs) { return coords_type{vs...}; }, v.values());
+  }
+
+  [[nodiscard]] static constexpr size_type length(const vec& extent, std::size_t axis) {
+    return static_cast<size_type>(coords(extent)[axis]);
+  }
+
+  static constexpr size_type row_count(const vec& extent) {
+    if (extent.min() < 0) {
+      throw std::invalid_argument("bitgrid extent must be non-negative along every axis");
+    }
+    size_type rows{1};
+    for (std::size_t axis{1}; axis < ndim; ++axis) {
+      rows *= length(extent, axis);
+    }
+    return rows;
+  }
+
+  [[nodiscard]] constexpr size_type row_stride() const noexcept { return row_words_ + 1; }
+
+  // Index of word j of row r, for r in [-1, rows] and j in [-1, row_words].
+  [[nodiscard]] constexpr size_type word_index(size_type r, size_type j) const noexcept {
+    return (r + 1) * row_stride() + 1 + j;
+  }
+
+  [[nodiscard]] constexpr size_type row_of(const coords_type& offset) const noexcept {
+    const coords_type extent{coords(extent_)};
+    size_type row{};
+    size_type stride{1};
+    for (std::size_t axis{1}; axis < ndim; ++axis) {
+      row += static_cast<size_type>(offset[axis]) * stride;
+      stride *= static_cast<size_type>(extent[axis]);
+    }
+    return row;
+  }
+
+  // Mask of the used bits of the last word of a row.
+  [[nodiscard]] constexpr word_type tail_mask() const noexcept {
+    const size_type used{length(extent_, 0) % word_bits};
+    return used == 0 ? ~word_type{} : (word_type{1} << used) - 1;
+  }
+
+  // Mask of the bits [lo, hi) of a word, for lo < hi <= 64.
+  [[nodiscard]] static constexpr word_type
+  bit_range(size_type lo, size_type hi) noexcept {
+    const word_type below_hi{hi == word_bits ? ~word_type{} : (word_type{1} << hi) - 1};
+    return below_hi & ~((word_type{1} << lo) - 1);
+  }
+
+  [[nodiscard]] constexpr std::pair<size_type, word_type>
+  locate(const vec& p) const noexcept {
+    const vec offset{p - origin_};
+    const auto x{static_cast<size_type>(offset.x())};
+    return {
+        word_index(row_of(coords(offset)), x / word_bits),
+        word_type{1} << (x % word_bits),
+    };
+  }
+
+  // Sum of 3 bit planes, as the low digit and the carry.
+  static constexpr std::pair<word_type, word_type>
+  full_add(word_type a, word_type b, word_type c) noexcept {
+    const word_type ab{a ^ b};
+    return {ab ^ c, (a & b) | (ab & c)};
+  }
+
+  template <bool is_conway>
+  void step_rows(life_rule rule, size_type row_begin, size_type row_end) noexcept {
+    const size_type n{row_words_};
+    const word_type last_mask{tail_mask()};
+    for (size_type r{row_begin}; r < row_end; ++r) {
+      // the guard words before rows r - 1, r and r + 1, so word j of a row is at j + 1
+      const word_type* const above{words_.data() + r * row_stride()};
+      const word_type* const row{above + row_stride()};
+      const word_type* const below{row + row_stride()};
+      word_type* const out{next_.data() + word_index(r, 0)};
+      for (size_type j{}; j < n; ++j) {
+        // the neighbours at x - 1 and x + 1, shifted into the bit of x
+        auto left{[j](const word_type* w) { return (w[j + 1] << 1) | (w[j] >> 63); }};
+        auto right{[j](const word_type* w) {
+          return (w[j + 1] >> 1) | (w[j + 2] << 63);
+        }};
+        const auto [s0, c0]{full_add(left(above), above[j + 1], right(above))};
+        const auto [s1, c1]{full_add(left(below), below[j + 1], right(below))};
+        const word_type l{left(row)}, rt{right(row)};
+        const word_type s2{l ^ rt}, c2{l & rt};
+        // digits of weight 1, 2 and 4 of the count
+        const auto [b0, c3]{full_add(s0, s1, s2)};
+        const auto [t, d0]{full_add(c0, c1, c2)};
+        const word_type b1{t ^ c3};
+        const word_type d1{t & c3};
+        const word_type b2{d0 ^ d1};
+        const word_type b3{d0 & d1};
+        const word_type alive{row[j + 1]};
+        word_type next{};
+        if constexpr (is_conway) {
+          // a count of 3, or 2 for a live cell
+          next = b1 & ~b2 & ~b3 & (b0 | alive);
+        } else {
+          word_type born{}, survives{};
+          for (unsigned count{}; count <= 8; ++count) {
+            const word_type is_count{
+                (count & 1 ? b0 : ~b0) & (count & 2 ? b1 : ~b1) & (count & 4 ? b2 : ~b2)
+                & (count & 8 ? b3 : ~b3)
+            };
+            born |= is_count & (word_type{} - ((rule.birth >> count) & 1));
+            survives |= is_count & (word_type{} - ((rule.survive >> count) & 1));
+          }
+          next = (alive & survives) | (~alive & born);
+        }
+        out[j] = next;
+      }
+      if (n > 0) {
+        out[n - 1] &= last_mask;
+      }
+    }
+  }
+
+public:
+  constexpr bitgrid() = default;
+
+  constexpr explicit bitgrid(const vec& extent) : bitgrid(vec(), extent) {}
+
+  constexpr bitgrid(const vec& origin, const vec& extent)
+      : origin_{origin},
+        extent_{extent},
+        row_words_{(length(extent, 0) + word_bits - 1) / word_bits},
+        rows_{row_count(extent)},
+        words_((rows_ + 2) * (row_words_ + 1) + 1) {}
+
+  // The cells of g for which alive(cell) is true.
+  template <typename Cell, std::predicate<const Cell&> Pred>
+  [[nodiscard]] static constexpr bitgrid
+  from_grid(const grid<Cell, ndim, T>& g, Pred alive) {
+    bitgrid bits(g.origin(), g.extent());
+    for (size_type i{}; i < g.size(); ++i) {
+      if (std::invoke(alive, g[i])) {
+        bits.set(g.position(i));
+      }
+    }
+    return bits;
+  }
+
+  [[nodiscard]] constexpr const vec& origin() const noexcept { return origin_; }
+  [[nodiscard]] constexpr const vec& extent() const noexcept { return extent_; }
+  [[nodiscard]] constexpr size_type size() const noexcept {
+    return rows_ * length(extent_, 0);
+  }
+  [[nodiscard]] constexpr bool empty() const noexcept { return size() == 0; }
+
+  // Number of rows along axis 0 and number of words in each.
+  [[nodiscard]] constexpr size_type rows() const noexcept { return rows_; }
+  [[nodiscard]] constexpr size_type row_words() const noexcept { return row_words_; }
+
+  // The words of row r, in 2D the cells at offsets (x, r) from the origin.
+  [[nodiscard]] constexpr std::span<const word_type> row(size_type r) const noexcept {
+    return {words_.data() + word_index(r, 0), row_words_};
+  }
+
+  [[nodiscard]] constexpr bool contains(const vec& p) const noexcept {
+    const vec offset{p - origin_};
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      return (
+          ...
+          & (static_cast<unsigned_type>(offset.template get<axes>())
+             < static_cast<unsigned_type>(extent_.template get<axes>()))
+      );
+    }(typename vec::axes_indices{});
+  }
+
+  [[nodiscard]] constexpr bool test(const vec& p) const noexcept {
+    const auto [i, bit]{locate(p)};
+    return (words_[i] & bit) != 0;
+  }
+
+  constexpr void set(const vec& p, bool value = true) noexcept {
+    const auto [i, bit]{locate(p)};
+    words_[i] = value ? words_[i] | bit : words_[i] & ~bit;
+  }
+
+  constexpr void reset(const vec& p) noexcept { set(p, false); }
+
+  constexpr void flip(const vec& p) noexcept {
+    const auto [i, bit]{locate(p)};
+    words_[i] ^= bit;
+  }
+
+  constexpr void clear() noexcept { std::ranges::fill(words_, word_type{}); }
+
+  // Number of set cells.
+  [[nodiscard]] constexpr size_type count() const noexcept {
+    size_type n{};
+    for (const word_type w : words_) {
+      n += static_cast<size_type>(std::popcount(w));
+    }
+    return n;
+  }
+
+  // Number of set cells in the closed box [lo, hi], clipped to the grid.
+  [[nodiscard]] constexpr size_type count(const vec& lo, const vec& hi) const noexcept {
+    vec one;
+    one.apply([](T) { return T{1}; });
+    const vec first{(lo - origin_).max(vec())};
+    const vec last{(hi - origin_ + one).min(extent_)};
+    if (empty() or (last - first).min() <= 0) {
+      return 0;
+    }
+    const auto x0{static_cast<size_type>(first.x())};
+    const auto x1{static_cast<size_type>(last.x())};
+    const size_type j0{x0 / word_bits}, j1{(x1 - 1) / word_bits};
+    size_type n{};
+    auto count_row{[&](size_type r) {
+      const word_type* const w{words_.data() + word_index(r, 0)};
+      if (j0 == j1) {
+        n += std::popcount(w[j0] & bit_range(x0 % word_bits, (x1 - 1) % word_bits + 1));
+        return;
+      }
+      n += std::popcount(w[j0] & bit_range(x0 % word_bits, word_bits));
+      for (size_type j{j0 + 1}; j < j1; ++j) {
+        n += std::popcount(w[j]);
+      }
+      n += std::popcount(w[j1] & bit_range(0, (x1 - 1) % word_bits + 1));
+    }};
+    // visit the rows of the box along axes 1, ..., ndim - 1 like an odometer
+    const coords_type begin{coords(first)}, end{coords(last)};
+    coords_type offset{begin};
+    while (true) {
+      count_row(row_of(offset));
+      std::size_t axis{1};
+      for (; axis < ndim; ++axis) {
+        if (++offset[axis] < end[axis]) {
+          break;
+        }
+        offset[axis] = begin[axis];
+      }
+      if (axis == ndim) {
+        return n;
+      }
+    }
+  }
+
+  // Replaces the grid with its next generation under a life-like rule. Cells outside the
+  // grid are dead.
+  void step(life_rule rule = life_rule::conway())
+    requires(ndim == 2)
+  {
+    next_.resize(words_.size());
+    parallel::for_each_chunk(rows_, min_rows_per_thread, [&](size_type, auto b, auto e) {
+      if (rule == life_rule::conway()) {
+        step_rows<true>(rule, b, e);
+      } else {
+        step_rows<false>(rule, b, e);
+      }
+    });
+    std::swap(words_, next_);
+  }
+
+  void run(size_type generations, life_rule rule = life_rule::conway())
+    requires(ndim == 2)
+  {
+    for (size_type g{}; g < generations; ++g) {
+      step(rule);
+    }
+  }
+
+  [[nodiscard]] constexpr bool operator==(const bitgrid& other) const noexcept {
+    return origin_ == other.origin_ and extent_ == other.extent_
+           and words_ == other.words_;
+  }
+};
+
+} // namespace ndvec
+
+#endif // NDVEC_BITGRID_HEADER_INCLUDED
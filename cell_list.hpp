@@ -0,0 +1,394 @@
+#ifndef NDVEC_CELL_LIST_HEADER_INCLUDED
+#define NDVEC_CELL_LIST_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "metric.hpp"
+#include "ndvec.hpp"
+#include "parallel.hpp"
+
+namespace ndvec {
+
+namespace detail {
+
+// Offsets of the 3^ndim cells around and including the center cell, axis 0 fastest.
+template <std::size_t ndim> consteval auto cell_neighborhood() {
+  constexpr std::size_t count{[] {
+    std::size_t n{1};
+    for (std::size_t axis{}; axis < ndim; ++axis) {
+      n *= 3;
+    }
+    return n;
+  }()};
+  std::array<std::array<int, ndim>, count> offsets{};
+  for (std::size_t i{}; i < count; ++i) {
+    for (std::size_t axis{}, rest{i}; axis < ndim; ++axis, rest /= 3) {
+      offsets[i][axis] = static_cast<int>(rest % 3) - 1;
+    }
+  }
+  return offsets;
+}
+
+} // namespace detail
+
+// Uniform grid of cubic cells over the bounding box of a point set, for fixed-radius
+// neighbour search. Points are counting sorted by cell into one array, so the candidates
+// of a query are the contents of 3^ndim cell ranges. The grid has one layer of empty
+// padding cells on each side, which makes every neighbour cell of an inner cell valid.
+template <typename Vec> class cell_list {
+public:
+  using vec = Vec;
+  using value_type = Vec::value_type;
+  using size_type = std::size_t;
+
+  static constexpr std::size_t ndim{Vec::ndim};
+
+  // Neighbour lists of many queries, the neighbours of query i are
+  // indices[offsets[i], offsets[i + 1]).
+  struct adjacency {
+    std::vector<size_type> offsets{};
+    std::vector<size_type> indices{};
+
+    [[nodiscard]] std::span<const size_type> operator[](size_type i) const noexcept {
+      return std::span(indices).subspan(offsets[i], offsets[i + 1] - offsets[i]);
+    }
+  };
+
+private:
+  using coords_type = std::array<value_type, ndim>;
+  using cells_type = std::array<size_type, ndim>;
+
+  static constexpr auto neighborhood{detail::cell_neighborhood<ndim>()};
+  static constexpr size_type parallel_min_size{1 << 14};
+
+  value_type cell_size_{};
+  coords_type origin{};
+  cells_type extent{};
+  cells_type strides{};
+  std::array<std::ptrdiff_t, neighborhood.size()> neighbor_offsets{};
+
+  // cell_begin[c] is the first slot of cell c, cell_begin has one extra end entry
+  std::vector<size_type> cell_begin;
+  // points and input indices in cell order
+  std::vector<Vec> sorted_points;
+  std::vector<size_type> sorted_indices;
+  // cell and slot of each input point
+  std::vector<size_type> cell_of;
+  std::vector<size_type> slot_of;
+
+  [[nodiscard]] static constexpr coords_type coords(const Vec& v) noexcept {
+    return std::apply([](auto... vs) { return coords_type{vs...}; }, v.values());
+  }
+
+  // Padded cell coordinates of v, clamped into the grid. Queries outside the bounding
+  // box land in the padding or in the nearest border cell, whose candidates are then
+  // rejected by the distance check. NaN coordinates land in the padding as well. The cell
+  // is clamped before the conversion to size_type, which is undefined for far away
+  // coordinates.
+  [[nodiscard]] constexpr cells_type cell_coords(const Vec& v) const noexcept {
+    const coords_type c{coords(v)};
+    cells_type cells{};
+    for (std::size_t axis{}; axis < ndim; ++axis) {
+      if (not(c[axis] >= origin[axis])) {
+        continue;
+      }
+      const value_type cell{std::min(
+          (c[axis] - origin[axis]) / cell_size_,
+          static_cast<value_type>(extent[axis] - 2)
+      )};
+      cells[axis] = static_cast<size_type>(cell) + 1;
+    }
+    return cells;
+  }
+
+  [[nodiscard]] constexpr size_type cell_index(const cells_type& cells) const noexcept {
+    size_type index{};
+    for (std::size_t axis{}; axis < ndim; ++axis) {
+      index += cells[axis] * strides[axis];
+    }
+    return index;
+  }
+
+  [[nodiscard]] constexpr bool is_inner(const cells_type& cells) const noexcept {
+    bool inner{true};
+    for (std::size_t axis{}; axis < ndim; ++axis) {
+      inner = inner and 0 < cells[axis] and cells[axis] + 1 < extent[axis];
+    }
+    return inner;
+  }
+
+  // Fits the grid to the bounding box of the points. The cell count is checked against a
+  // bound that keeps the per-chunk counts of sort_by_cell addressable, so a cell size
+  // that is tiny compared to the box, or a NaN coordinate, throws std::length_error and
+  // leaves the grid as it was instead of wrapping the count.
+  void fit_grid(std::span<const Vec> points) {
+    Vec lo{points.empty() ? Vec() : points.front()}, hi{lo};
+    for (const Vec& p : points) {
+      lo = lo.min(p);
+      hi = hi.max(p);
+    }
+    const coords_type span_coords{coords(hi - lo)};
+    const size_type max_cells{cell_begin.max_size() / parallel::thread_count()};
+    cells_type new_extent{};
+    size_type cells{1};
+    for (std::size_t axis{}; axis < ndim; ++axis) {
+      const value_type axis_cells{span_coords[axis] / cell_size_};
+      const auto limit{static_cast<long double>(max_cells)};
+      if (not(static_cast<long double>(axis_cells) < limit)) {
+        throw std::length_error("cell_list grid has too many cells");
+      }
+      new_extent[axis] = static_cast<size_type>(axis_cells) + 3;
+      if (new_extent[axis] > max_cells / cells) {
+        throw std::length_error("cell_list grid has too many cells");
+      }
+      cells *= new_extent[axis];
+    }
+    cell_begin.assign(cells + 1, 0);
+    origin = coords(lo);
+    extent = new_extent;
+    std::exclusive_scan(
+        extent.begin(),
+        extent.end(),
+        strides.begin(),
+        1uz,
+        std::multiplies{}
+    );
+    for (std::size_t i{}; i < neighborhood.size(); ++i) {
+      neighbor_offsets[i] = 0;
+      for (std::size_t axis{}; axis < ndim; ++axis) {
+        const auto stride{static_cast<std::ptrdiff_t>(strides[axis])};
+        neighbor_offsets[i] += neighborhood[i][axis] * stride;
+      }
+    }
+  }
+
+  // Parallel counting sort of the points by cell_of: every chunk counts its points per
+  // cell, the counts are scanned cell by cell and chunk by chunk, and every chunk then
+  // scatters its points to their slots, which keeps equal cells in input order.
+  void sort_by_cell(std::span<const Vec> points) {
+    const size_type n{points.size()}, cells{cell_begin.size() - 1};
+    const size_type chunks{parallel::chunk_count(n, parallel_min_size)};
+    std::vector<size_type> counts(chunks * cells);
+    parallel::for_each_chunk(n, parallel_min_size, [&](size_type chunk, auto b, auto e) {
+      size_type* chunk_counts{counts.data() + chunk * cells};
+      for (size_type i{b}; i < e; ++i) {
+        ++chunk_counts[cell_of[i]];
+      }
+    });
+    size_type slot{};
+    for (size_type cell{}; cell < cells; ++cell) {
+      cell_begin[cell] = slot;
+      for (size_type chunk{}; chunk < chunks; ++chunk) {
+        slot += std::exchange(counts[chunk * cells + cell], slot);
+      }
+    }
+    cell_begin[cells] = slot;
+    sorted_points.resize(n);
+    sorted_indices.resize(n);
+    slot_of.resize(n);
+    parallel::for_each_chunk(n, parallel_min_size, [&](size_type chunk, auto b, auto e) {
+      size_type* next_slot{counts.data() + chunk * cells};
+      for (size_type i{b}; i < e; ++i) {
+        const size_type s{next_slot[cell_of[i]]++};
+        sorted_points[s] = points[i];
+        sorted_indices[s] = i;
+        slot_of[i] = s;
+      }
+    });
+  }
+
+  struct assign_result {
+    bool all_inner{true};
+    bool any_moved{false};
+  };
+
+  // Recomputes cell_of, and reports whether all points are in inner cells and whether
+  // any point changed cell.
+  assign_result assign_cells(std::span<const Vec> points) {
+    const size_type n{points.size()};
+    cell_of.resize(n);
+    std::vector<assign_result> results(parallel::chunk_count(n, parallel_min_size));
+    parallel::for_each_chunk(n, parallel_min_size, [&](size_type chunk, auto b, auto e) {
+      assign_result res;
+      for (size_type i{b}; i < e; ++i) {
+        const cells_type cells{cell_coords(points[i])};
+        const size_type cell{cell_index(cells)};
+        res.all_inner = res.all_inner and is_inner(cells);
+        res.any_moved = res.any_moved or cell != cell_of[i];
+        cell_of[i] = cell;
+      }
+      results[chunk] = res;
+    });
+    return {
+        std::ranges::all_of(results, &assign_result::all_inner),
+        std::ranges::any_of(results, &assign_result::any_moved),
+    };
+  }
+
+  // Slot ranges of the 3^ndim cells around query, empty for cells outside the grid.
+  [[nodiscard]] auto candidate_slots(const Vec& query) const noexcept {
+    std::array<std::pair<size_type, size_type>, neighborhood.size()> slots{};
+    if (empty()) {
+      return slots;
+    }
+    const auto center{static_cast<std::ptrdiff_t>(cell_index(cell_coords(query)))};
+    for (std::size_t i{}; i < neighborhood.size(); ++i) {
+      // cells of an outside query may wrap to other rows, those are filtered by callers
+      const auto cell{static_cast<size_type>(center + neighbor_offsets[i])};
+      if (cell < cell_count()) {
+        slots[i] = {cell_begin[cell], cell_begin[cell + 1]};
+      }
+    }
+    return slots;
+  }
+
+  template <typename Metric> void check_radius(value_type radius) const {
+    if (Metric::axis_distance(cell_size_) < radius) {
+      throw std::invalid_argument("cell_list query radius is larger than the cell size");
+    }
+  }
+
+public:
+  // Cells are cubes with side cell_size, so queries support radii up to cell_size.
+  explicit cell_list(value_type cell_size) : cell_size_{cell_size} {
+    if (not(cell_size > value_type{})) {
+      throw std::invalid_argument("cell_list cell size must be positive");
+    }
+  }
+
+  cell_list(std::span<const Vec> points, value_type cell_size) : cell_list(cell_size) {
+    build(points);
+  }
+
+  [[nodiscard]] constexpr size_type size() const noexcept { return sorted_points.size(); }
+  [[nodiscard]] constexpr bool empty() const noexcept { return sorted_points.empty(); }
+  [[nodiscard]] constexpr value_type cell_size() const noexcept { return cell_size_; }
+  [[nodiscard]] constexpr size_type cell_count() const noexcept {
+    return cell_begin.empty() ? 0 : cell_begin.size() - 1;
+  }
+
+  void build(std::span<const Vec> points) {
+    fit_grid(points);
+    assign_cells(points);
+    sort_by_cell(points);
+  }
+
+  // Rebuilds after the points have moved, points[i] being the new position of the i-th
+  // point of the last build. If no point changed cell the positions are updated in
+  // place, if all points are still inside the grid only the counting sort is redone,
+  // otherwise the grid is refitted.
+  void update(std::span<const Vec> points) {
+    if (points.size() != size()) {
+      build(points);
+      return;
+    }
+    if (const assign_result res{assign_cells(points)}; not res.all_inner) {
+      build(points);
+    } else if (res.any_moved) {
+      sort_by_cell(points);
+    } else {
+      for (size_type i{}; i < points.size(); ++i) {
+        sorted_points[slot_of[i]] = points[i];
+      }
+    }
+  }
+
+  // Calls fn(index, point) for every point in the 3^ndim cells around query, a superset
+  // of the points within cell_size of query along every axis.
+  template <typename Fn> void for_each_candidate(const Vec& query, Fn&& fn) const {
+    for (auto [begin, end] : candidate_slots(query)) {
+      for (size_type s{begin}; s < end; ++s) {
+        fn(sorted_indices[s], sorted_points[s]);
+      }
+    }
+  }
+
+  // Calls fn(index, distance) for every point at most radius away from query.
+  template <metric::axis_metric Metric = metric::manhattan, typename Fn>
+  void for_each_within_radius(
+      const Vec& query,
+      value_type radius,
+      Fn&& fn,
+      Metric = {}
+  ) const {
+    check_radius<Metric>(radius);
+    for_each_candidate(query, [&](size_type index, const Vec& p) {
+      if (auto dist{metric::distance<Metric>(query, p)}; dist <= radius) {
+        fn(index, dist);
+      }
+    });
+  }
+
+  // Indices of all points at most radius away from query, in increasing order.
+  template <metric::axis_metric Metric = metric::manhattan>
+  [[nodiscard]] std::vector<size_type>
+  within_radius(const Vec& query, value_type radius, Metric m = {}) const {
+    std::vector<size_type> res;
+    auto collect{[&res](size_type i, value_type) { res.push_back(i); }};
+    for_each_within_radius(query, radius, collect, m);
+    std::ranges::sort(res);
+    return res;
+  }
+
+  // Neighbour lists of all queries, split across threads. The neighbours of each query
+  // are grouped by cell, and in increasing index order within a cell.
+  template <metric::axis_metric Metric = metric::manhattan>
+  [[nodiscard]] adjacency
+  within_radius(std::span<const Vec> queries, value_type radius, Metric = {}) const {
+    check_radius<Metric>(radius);
+    const size_type n{queries.size()};
+    std::vector<std::vector<size_type>> chunk_indices(parallel::chunk_count(n, 1024));
+    adjacency res;
+    res.offsets.resize(n + 1);
+    parallel::for_each_chunk(n, 1024, [&](size_type chunk, size_type b, size_type e) {
+      std::vector<size_type>& out{chunk_indices[chunk]};
+      size_type len{};
+      for (size_type q{b}; q < e; ++q) {
+        const Vec& query{queries[q]};
+        const auto slots{candidate_slots(query)};
+        size_type candidates{};
+        for (auto [begin, end] : slots) {
+          candidates += end - begin;
+        }
+        if (out.size() < len + candidates) {
+          out.resize(2 * (len + candidates));
+        }
+        // every candidate is written but only those within radius advance len, which
+        // avoids a hard to predict branch per candidate
+        const size_type first{len};
+        for (auto [begin, end] : slots) {
+          for (size_type s{begin}; s < end; ++s) {
+            out[len] = sorted_indices[s];
+            len += metric::distance<Metric>(query, sorted_points[s]) <= radius;
+          }
+        }
+        res.offsets[q + 1] = len - first;
+      }
+      out.resize(len);
+    });
+    std::inclusive_scan(res.offsets.begin(), res.offsets.end(), res.offsets.begin());
+    res.indices.reserve(res.offsets.back());
+    for (const std::vector<size_type>& out : chunk_indices) {
+      res.indices.insert(res.indices.end(), out.begin(), out.end());
+    }
+    return res;
+  }
+};
+
+template <std::ranges::contiguous_range R, typename T>
+cell_list(R&&, T) -> cell_list<std::ranges::range_value_t<R>>;
+
+} // namespace ndvec
+
+#endif // NDVEC_CELL_LIST_HEADER_INCLUDED
@@ -0,0 +1,50 @@
+#include "ndvec.hpp"
+
+// Kernels whose assembly `make codegen` checks for packed SIMD instructions, see
+// codegen.sh. They take pointers so that the values come from memory as in a loop over
+// an array of vecs.
+
+// vec3<float> padded to 16 bytes, specialized before any use, and this is the only
+// translation unit of the codegen build
+template <>
+struct ndvec::storage_alignment<float, 3> : std::integral_constant<std::size_t, 16> {};
+
+using ndvec::vec3;
+using ndvec::vec4;
+
+extern "C" {
+
+void add_vec4_float(const vec4<float>* lhs, const vec4<float>* rhs, vec4<float>* out) {
+  *out = *lhs + *rhs;
+}
+
+void add_vec4_int(const vec4<int>* lhs, const vec4<int>* rhs, vec4<int>* out) {
+  *out = *lhs + *rhs;
+}
+
+void add_vec3_float(const vec3<float>* lhs, const vec3<float>* rhs, vec3<float>* out) {
+  *out = *lhs + *rhs;
+}
+
+void min_vec4_float(const vec4<float>* lhs, const vec4<float>* rhs, vec4<float>* out) {
+  *out = lhs->min(*rhs);
+}
+
+void max_vec4_float(const vec4<float>* lhs, const vec4<float>* rhs, vec4<float>* out) {
+  *out = lhs->max(*rhs);
+}
+
+void min_vec4_int(const vec4<int>* lhs, const vec4<int>* rhs, vec4<int>* out) {
+  *out = lhs->min(*rhs);
+}
+
+void max_vec4_int(const vec4<int>* lhs, const vec4<int>* rhs, vec4<int>* out) {
+  *out = lhs->max(*rhs);
+}
+
+float dot_vec4_float(const vec4<float>* lhs, const vec4<float>* rhs) {
+  return lhs->dot(*rhs);
+}
+
+int dot_vec4_int(const vec4<int>* lhs, const vec4<int>* rhs) { return lhs->dot(*rhs); }
+}
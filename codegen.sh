@@ -0,0 +1,46 @@
+#!/usr/bin/env sh
+# Checks that the kernels in codegen.cpp compile to packed SIMD instructions.
+# usage: ./codegen.sh codegen.s
+set -ue
+
+asm="$1"
+arch="$(uname -m)"
+status=0
+
+# instructions of the function named $1
+body() {
+  awk -v label="$1:" '$1 == label { found = 1; next } found && /\.cfi_endproc/ { exit } found' "$asm"
+}
+
+# check FUNCTION X86_64_PATTERN AARCH64_PATTERN
+check() {
+  case "$arch" in
+    x86_64) pattern="$2" ;;
+    aarch64 | arm64) pattern="$3" ;;
+    *)
+      echo "codegen: no patterns for $arch"
+      exit 1
+      ;;
+  esac
+  if body "$1" | grep -Eq "$pattern"; then
+    echo "codegen: $1 ok"
+  else
+    echo "codegen: $1 does not match '$pattern'"
+    body "$1"
+    status=1
+  fi
+}
+
+v4s='[[:space:]]+v[0-9]+\.4s'
+
+check add_vec4_float 'v?addps' "fadd$v4s"
+check add_vec4_int 'v?paddd' "[[:space:]]add$v4s"
+check add_vec3_float 'v?addps' 'fadd[[:space:]]+v[0-9]+\.[24]s'
+check min_vec4_float 'v?minps' "(fcmgt|fcmge|fmin|fminnm)$v4s"
+check max_vec4_float 'v?maxps' "(fcmgt|fcmge|fmax|fmaxnm)$v4s"
+check min_vec4_int 'v?(pminsd|pcmpgtd)' "(smin|cmgt|cmge)$v4s"
+check max_vec4_int 'v?(pmaxsd|pcmpgtd)' "(smax|cmgt|cmge)$v4s"
+check dot_vec4_float 'v?mulps' 'fmul[[:space:]]+v[0-9]+\.[24]s'
+check dot_vec4_int 'v?(pmulld|pmuludq)' "[[:space:]]mul$v4s"
+
+exit "$status"
@@ -0,0 +1,262 @@
+#ifndef NDVEC_CURVE_HEADER_INCLUDED
+#define NDVEC_CURVE_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "ndvec.hpp"
+
+namespace ndvec {
+
+namespace detail {
+
+template <typename Vec>
+concept curve_vec = requires {
+  typename Vec::value_type;
+  requires std::same_as<Vec, vecn<typename Vec::value_type, Vec::ndim>>;
+  requires std::integral<typename Vec::value_type>;
+  requires not std::same_as<typename Vec::value_type, bool>;
+  requires 2 <= Vec::ndim and Vec::ndim <= 4;
+};
+
+// Bit i of the mask is set if i is a multiple of ndim and below bits * ndim.
+template <std::size_t ndim, int bits> consteval std::uint64_t interleave_mask() {
+  std::uint64_t mask{};
+  for (std::size_t i{}; i < bits * ndim; i += ndim) {
+    mask |= std::uint64_t{1} << i;
+  }
+  return mask;
+}
+
+// Moves bit i of x to bit i * ndim.
+template <std::size_t ndim, int bits>
+constexpr std::uint64_t spread(std::uint64_t x) noexcept {
+#if defined(__BMI2__)
+  if !consteval {
+    return _pdep_u64(x, interleave_mask<ndim, bits>());
+  }
+#endif
+  x &= (std::uint64_t{1} << bits) - 1;
+  if constexpr (ndim == 2) {
+    x = (x | x << 16) & 0x0000ffff0000ffff;
+    x = (x | x << 8) & 0x00ff00ff00ff00ff;
+    x = (x | x << 4) & 0x0f0f0f0f0f0f0f0f;
+    x = (x | x << 2) & 0x3333333333333333;
+    x = (x | x << 1) & 0x5555555555555555;
+  } else if constexpr (ndim == 3) {
+    x = (x | x << 32) & 0x001f00000000ffff;
+    x = (x | x << 16) & 0x001f0000ff0000ff;
+    x = (x | x << 8) & 0x100f00f00f00f00f;
+    x = (x | x << 4) & 0x10c30c30c30c30c3;
+    x = (x | x << 2) & 0x1249249249249249;
+  } else {
+    x = (x | x << 24) & 0x000000ff000000ff;
+    x = (x | x << 12) & 0x000f000f000f000f;
+    x = (x | x << 6) & 0x0303030303030303;
+    x = (x | x << 3) & 0x1111111111111111;
+  }
+  return x;
+}
+
+// Inverse of spread, moves bit i * ndim of x to bit i.
+template <std::size_t ndim, int bits>
+constexpr std::uint64_t compact(std::uint64_t x) noexcept {
+#if defined(__BMI2__)
+  if !consteval {
+    return _pext_u64(x, interleave_mask<ndim, bits>());
+  }
+#endif
+  if constexpr (ndim == 2) {
+    x &= 0x5555555555555555;
+    x = (x | x >> 1) & 0x3333333333333333;
+    x = (x | x >> 2) & 0x0f0f0f0f0f0f0f0f;
+    x = (x | x >> 4) & 0x00ff00ff00ff00ff;
+    x = (x | x >> 8) & 0x0000ffff0000ffff;
+    x = (x | x >> 16) & 0x00000000ffffffff;
+  } else if constexpr (ndim == 3) {
+    x &= 0x1249249249249249;
+    x = (x | x >> 2) & 0x10c30c30c30c30c3;
+    x = (x | x >> 4) & 0x100f00f00f00f00f;
+    x = (x | x >> 8) & 0x001f0000ff0000ff;
+    x = (x | x >> 16) & 0x001f00000000ffff;
+    x = (x | x >> 32) & 0x00000000001fffff;
+  } else {
+    x &= 0x1111111111111111;
+    x = (x | x >> 3) & 0x0303030303030303;
+    x = (x | x >> 6) & 0x000f000f000f000f;
+    x = (x | x >> 12) & 0x000000ff000000ff;
+    x = (x | x >> 24) & 0x000000000000ffff;
+  }
+  return x & ((std::uint64_t{1} << bits) - 1);
+}
+
+template <curve_vec Vec> struct curve_traits {
+  using T = Vec::value_type;
+  using U = std::make_unsigned_t<T>;
+  using axes_type = std::array<std::uint64_t, Vec::ndim>;
+
+  static constexpr int bits{std::min(
+      std::numeric_limits<U>::digits,
+      static_cast<int>(64 / Vec::ndim)
+  )};
+  static constexpr std::uint64_t low_bits{(std::uint64_t{1} << bits) - 1};
+  // signed axes are biased so that the curve order agrees with the numeric order
+  static constexpr std::uint64_t bias{
+      std::signed_integral<T> ? std::uint64_t{1} << (bits - 1) : 0
+  };
+
+  static constexpr axes_type to_unsigned(const Vec& v) noexcept {
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      return axes_type{
+          ((static_cast<std::uint64_t>(static_cast<U>(v.template get<axes>())) ^ bias)
+           & low_bits)...
+      };
+    }(typename Vec::axes_indices{});
+  }
+
+  static constexpr Vec from_unsigned(const axes_type& u) noexcept {
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      // subtracting the bias also sign-extends the low bits to the full width of T
+      return Vec(static_cast<T>(
+          static_cast<std::int64_t>(std::get<axes>(u)) - static_cast<std::int64_t>(bias)
+      )...);
+    }(typename Vec::axes_indices{});
+  }
+
+  template <std::size_t... axes>
+  static constexpr std::uint64_t
+  interleave(const axes_type& u, std::index_sequence<axes...>) noexcept {
+    return (... | (spread<Vec::ndim, bits>(u[axes]) << axes));
+  }
+
+  template <std::size_t... axes>
+  static constexpr axes_type
+  deinterleave(std::uint64_t code, std::index_sequence<axes...>) noexcept {
+    return {compact<Vec::ndim, bits>(code >> axes)...};
+  }
+};
+
+// One step of Skilling's transform at bit q: invert the low bits of x0 if xi has bit q
+// set, otherwise exchange the low bits of x0 and xi. Branchless because the bits are
+// close to random.
+constexpr void
+hilbert_step(std::uint64_t& x0, std::uint64_t& xi, std::uint64_t q) noexcept {
+  const std::uint64_t low{q - 1};
+  const std::uint64_t is_set{std::uint64_t{0} - ((xi & q) != 0)};
+  const std::uint64_t t{(x0 ^ xi) & low & ~is_set};
+  x0 ^= (low & is_set) | t;
+  xi ^= t;
+}
+
+} // namespace detail
+
+// Number of bits per axis that the curve codes of Vec keep. Signed axes must lie in
+// [-2^(bits-1), 2^(bits-1)) and unsigned axes in [0, 2^bits) to round-trip.
+template <detail::curve_vec Vec>
+inline constexpr int curve_bits{detail::curve_traits<Vec>::bits};
+
+// Z-order code with bit i of axis k at bit i * ndim + k.
+template <detail::curve_vec Vec>
+[[nodiscard]] constexpr std::uint64_t morton_encode(const Vec& v) noexcept {
+  using traits = detail::curve_traits<Vec>;
+  return traits::interleave(traits::to_unsigned(v), typename Vec::axes_indices{});
+}
+
+template <detail::curve_vec Vec>
+[[nodiscard]] constexpr Vec morton_decode(std::uint64_t code) noexcept {
+  using traits = detail::curve_traits<Vec>;
+  return traits::from_unsigned(traits::deinterleave(code, typename Vec::axes_indices{}));
+}
+
+// Hilbert code computed with Skilling's transpose algorithm, "Programming the Hilbert
+// curve", AIP Conference Proceedings 707, 2004. Consecutive codes decode to points at
+// distance 1 from each other.
+template <detail::curve_vec Vec>
+[[nodiscard]] constexpr std::uint64_t hilbert_encode(const Vec& v) noexcept {
+  using traits = detail::curve_traits<Vec>;
+  constexpr std::size_t n{Vec::ndim};
+  auto x{traits::to_unsigned(v)};
+  for (std::uint64_t q{std::uint64_t{1} << (traits::bits - 1)}; q > 1; q >>= 1) {
+    for (std::size_t i{}; i < n; ++i) {
+      detail::hilbert_step(x[0], x[i], q);
+    }
+  }
+  for (std::size_t i{1}; i < n; ++i) {
+    x[i] ^= x[i - 1];
+  }
+  std::uint64_t t{};
+  for (std::uint64_t q{std::uint64_t{1} << (traits::bits - 1)}; q > 1; q >>= 1) {
+    if (x[n - 1] & q) {
+      t ^= q - 1;
+    }
+  }
+  for (std::uint64_t& xi : x) {
+    xi ^= t;
+  }
+  // the transpose stores the most significant bit of each group in axis 0
+  std::ranges::reverse(x);
+  return traits::interleave(x, typename Vec::axes_indices{});
+}
+
+template <detail::curve_vec Vec>
+[[nodiscard]] constexpr Vec hilbert_decode(std::uint64_t code) noexcept {
+  using traits = detail::curve_traits<Vec>;
+  constexpr std::size_t n{Vec::ndim};
+  auto x{traits::deinterleave(code, typename Vec::axes_indices{})};
+  std::ranges::reverse(x);
+  const std::uint64_t t{x[n - 1] >> 1};
+  for (std::size_t i{n - 1}; i > 0; --i) {
+    x[i] ^= x[i - 1];
+  }
+  x[0] ^= t;
+  for (std::uint64_t q{2}; q != std::uint64_t{1} << traits::bits; q <<= 1) {
+    for (std::size_t i{n}; i-- > 0;) {
+      detail::hilbert_step(x[0], x[i], q);
+    }
+  }
+  return traits::from_unsigned(x);
+}
+
+enum class space_filling_curve {
+  morton,
+  hilbert,
+};
+
+// Reorders points along a space-filling curve so that points close in space end up close
+// in memory. Each code is computed once, the points are then sorted by code.
+template <std::ranges::forward_range R, typename Vec = std::ranges::range_value_t<R>>
+  requires(
+      detail::curve_vec<Vec> and std::indirectly_writable<std::ranges::iterator_t<R>, Vec>
+  )
+constexpr void
+sort_by_curve(R&& points, space_filling_curve curve = space_filling_curve::morton) {
+  std::vector<std::pair<std::uint64_t, Vec>> keyed;
+  if constexpr (std::ranges::sized_range<R>) {
+    keyed.reserve(std::ranges::size(points));
+  }
+  for (Vec p : points) {
+    const auto code{
+        curve == space_filling_curve::morton ? morton_encode(p) : hilbert_encode(p)
+    };
+    keyed.emplace_back(code, p);
+  }
+  std::ranges::sort(keyed, {}, &std::pair<std::uint64_t, Vec>::first);
+  std::ranges::copy(keyed | std::views::values, std::ranges::begin(points));
+}
+
+} // namespace ndvec
+
+#endif // NDVEC_CURVE_HEADER_INCLUDED
@@ -0,0 +1,257 @@
+#ifndef NDVEC_EXPR_HEADER_INCLUDED
+#define NDVEC_EXPR_HEADER_INCLUDED
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "ndvec.hpp"
+
+// Lazy ndvec arithmetic. ndvec::lazy(v) wraps an ndvec in an expression, and the
+// operators, abs, signum and the elementwise min and max of expressions return new
+// expressions instead of ndvecs. Nothing is computed until the expression is converted
+// to an ndvec or reduced with sum, prod, min, max, dot or distance, which then evaluate
+// the whole tree one axis at a time without any intermediate ndvec:
+//
+//   vec4<int> r{lazy(a) + lazy(b) * c - d};
+//   int len{(lazy(a) - b).abs().sum()};
+//
+// Every step is computed in value_type as by the eager operators, so both give the
+// same results. An operator of two plain ndvecs, e.g. b * c, is the eager one and creates
+// a temporary before any expression sees it. Expressions keep lvalue ndvecs by reference and everything else by
+// value, so an expression must not outlive the lvalues it was built from.
+namespace ndvec::expr {
+
+template <typename Vec, typename Fn, typename... Operands> class expression;
+
+namespace detail {
+
+template <typename T> struct is_ndvec : std::false_type {};
+template <typename... Ts> struct is_ndvec<ndvec<Ts...>> : std::true_type {};
+
+template <typename T> struct is_expression : std::false_type {};
+template <typename Vec, typename Fn, typename... Operands>
+struct is_expression<expression<Vec, Fn, Operands...>> : std::true_type {};
+
+template <typename T>
+concept vec = is_ndvec<std::remove_cvref_t<T>>::value;
+
+template <typename T>
+concept lazy_expression = is_expression<std::remove_cvref_t<T>>::value;
+
+template <typename T> struct vec_of {
+  using type = std::remove_cvref_t<T>;
+};
+template <lazy_expression T> struct vec_of<T> {
+  using type = std::remove_cvref_t<T>::vec_type;
+};
+
+// lvalue ndvecs are kept by reference, temporaries and expressions by value
+template <typename T>
+using stored_t = std::conditional_t<
+    vec<T> and std::is_lvalue_reference_v<T>,
+    const std::remove_cvref_t<T>&,
+    std::remove_cvref_t<T>>;
+
+struct identity_fn {
+  template <typename T> constexpr T operator()(T v) const noexcept { return v; }
+};
+
+struct abs_fn {
+  template <typename T> constexpr T operator()(T v) const noexcept {
+    return v < T{} ? -v : v;
+  }
+};
+
+struct signum_fn {
+  template <typename T> constexpr T operator()(T v) const noexcept {
+    return (T{} < v) - (v < T{});
+  }
+};
+
+struct min_fn {
+  template <typename T> constexpr T operator()(T a, T b) const noexcept {
+    return std::min(a, b);
+  }
+};
+
+struct max_fn {
+  template <typename T> constexpr T operator()(T a, T b) const noexcept {
+    return std::max(a, b);
+  }
+};
+
+template <typename Fn, typename... Operands>
+constexpr auto make_expression(Operands&&... operands) {
+  using Vec = std::common_type_t<typename vec_of<Operands>::type...>;
+  return expression<Vec, Fn, stored_t<Operands>...>(
+      std::in_place,
+      std::forward<Operands>(operands)...
+  );
+}
+
+} // namespace detail
+
+template <typename Vec, typename Fn, typename... Operands> class expression {
+public:
+  using vec_type = Vec;
+  using value_type = Vec::value_type;
+  using axes_indices = Vec::axes_indices;
+
+  static constexpr std::size_t ndim{Vec::ndim};
+
+private:
+  std::tuple<Operands...> operands;
+
+  template <typename Reduce> constexpr value_type reduce(Reduce&& reduce) const {
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      return static_cast<value_type>(reduce(get<axes>()...));
+    }(axes_indices{});
+  }
+
+public:
+  template <typename... Args>
+  constexpr explicit expression(std::in_place_t, Args&&... args)
+      : operands(std::forward<Args>(args)...) {}
+
+  // The value of one axis, computed from the same axis of every operand.
+  template <std::size_t axis>
+    requires(axis < ndim)
+  [[nodiscard]] constexpr value_type get() const noexcept {
+    return std::apply(
+        [](const auto&... operand) constexpr noexcept {
+          return static_cast<value_type>(Fn{}(operand.template get<axis>()...));
+        },
+        operands
+    );
+  }
+
+  [[nodiscard]] constexpr Vec eval() const noexcept {
+    return [this]<std::size_t... axes>(std::index_sequence<axes...>) {
+      return Vec(get<axes>()...);
+    }(axes_indices{});
+  }
+
+  constexpr operator Vec() const noexcept { return eval(); }
+
+  [[nodiscard]] constexpr auto abs() const noexcept {
+    return detail::make_expression<detail::abs_fn>(*this);
+  }
+
+  [[nodiscard]] constexpr auto signum() const noexcept {
+    return detail::make_expression<detail::signum_fn>(*this);
+  }
+
+  template <typename Rhs>
+    requires std::same_as<typename detail::vec_of<Rhs>::type, Vec>
+  [[nodiscard]] constexpr auto min(Rhs&& rhs) const noexcept {
+    return detail::make_expression<detail::min_fn>(*this, std::forward<Rhs>(rhs));
+  }
+
+  template <typename Rhs>
+    requires std::same_as<typename detail::vec_of<Rhs>::type, Vec>
+  [[nodiscard]] constexpr auto max(Rhs&& rhs) const noexcept {
+    return detail::make_expression<detail::max_fn>(*this, std::forward<Rhs>(rhs));
+  }
+
+  [[nodiscard]] constexpr value_type sum() const noexcept {
+    return reduce([](std::same_as<value_type> auto... vs) { return (... + vs); });
+  }
+
+  [[nodiscard]] constexpr value_type prod() const noexcept {
+    return reduce([](std::same_as<value_type> auto... vs) { return (... * vs); });
+  }
+
+  [[nodiscard]] constexpr value_type min() const noexcept {
+    return reduce([](std::same_as<value_type> auto... vs) {
+      return std::min(std::initializer_list<value_type>{vs...});
+    });
+  }
+
+  [[nodiscard]] constexpr value_type max() const noexcept {
+    return reduce([](std::same_as<value_type> auto... vs) {
+      return std::max(std::initializer_list<value_type>{vs...});
+    });
+  }
+
+  template <typename Rhs>
+    requires std::same_as<typename detail::vec_of<Rhs>::type, Vec>
+  [[nodiscard]] constexpr value_type dot(Rhs&& rhs) const noexcept {
+    using multiplies = ::ndvec::detail::wrapping_multiplies;
+    return detail::make_expression<multiplies>(*this, std::forward<Rhs>(rhs)).sum();
+  }
+
+  template <typename Rhs>
+    requires std::same_as<typename detail::vec_of<Rhs>::type, Vec>
+  [[nodiscard]] constexpr value_type distance(Rhs&& rhs) const noexcept {
+    return detail::make_expression<std::minus<>>(*this, std::forward<Rhs>(rhs))
+        .abs()
+        .sum();
+  }
+};
+
+// At least one operand is an expression, so that the eager operators of ndvec are used
+// for two ndvecs.
+template <typename Lhs, typename Rhs>
+concept operands = (detail::lazy_expression<Lhs> or detail::lazy_expression<Rhs>)
+                   and (detail::lazy_expression<Lhs> or detail::vec<Lhs>)
+                   and (detail::lazy_expression<Rhs> or detail::vec<Rhs>)
+                   and std::same_as<
+                       typename detail::vec_of<Lhs>::type,
+                       typename detail::vec_of<Rhs>::type>;
+
+template <typename Lhs, typename Rhs>
+  requires operands<Lhs, Rhs>
+[[nodiscard]] constexpr auto operator+(Lhs&& lhs, Rhs&& rhs) noexcept {
+  return detail::make_expression<std::plus<>>(
+      std::forward<Lhs>(lhs),
+      std::forward<Rhs>(rhs)
+  );
+}
+
+template <typename Lhs, typename Rhs>
+  requires operands<Lhs, Rhs>
+[[nodiscard]] constexpr auto operator-(Lhs&& lhs, Rhs&& rhs) noexcept {
+  return detail::make_expression<std::minus<>>(
+      std::forward<Lhs>(lhs),
+      std::forward<Rhs>(rhs)
+  );
+}
+
+template <typename Lhs, typename Rhs>
+  requires operands<Lhs, Rhs>
+[[nodiscard]] constexpr auto operator*(Lhs&& lhs, Rhs&& rhs) noexcept {
+  return detail::make_expression<::ndvec::detail::wrapping_multiplies>(
+      std::forward<Lhs>(lhs),
+      std::forward<Rhs>(rhs)
+  );
+}
+
+template <typename Lhs, typename Rhs>
+  requires operands<Lhs, Rhs>
+[[nodiscard]] constexpr auto operator/(Lhs&& lhs, Rhs&& rhs) noexcept {
+  return detail::make_expression<std::divides<>>(
+      std::forward<Lhs>(lhs),
+      std::forward<Rhs>(rhs)
+  );
+}
+
+} // namespace ndvec::expr
+
+namespace ndvec {
+
+// Wraps v in an expression. An lvalue is kept by reference and a temporary by value.
+template <typename Vec>
+  requires expr::detail::vec<Vec>
+[[nodiscard]] constexpr auto lazy(Vec&& v) noexcept {
+  return expr::detail::make_expression<expr::detail::identity_fn>(std::forward<Vec>(v));
+}
+
+} // namespace ndvec
+
+#endif // NDVEC_EXPR_HEADER_INCLUDED
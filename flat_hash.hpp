@@ -0,0 +1,424 @@
+#ifndef NDVEC_FLAT_HASH_HEADER_INCLUDED
+#define NDVEC_FLAT_HASH_HEADER_INCLUDED
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ndvec.hpp"
+
+namespace ndvec {
+
+namespace detail {
+
+struct identity_key {
+  template <typename K> constexpr const K& operator()(const K& key) const noexcept {
+    return key;
+  }
+};
+
+struct first_key {
+  template <typename P> constexpr const auto& operator()(const P& pair) const noexcept {
+    return pair.first;
+  }
+};
+
+// Open-addressing hash table with linear probing and Robin Hood displacement. Values live
+// in one flat array next to a byte array of probe distances, where 0 marks an empty slot.
+// Meant for small, cheap to move keys such as ndvecs.
+template <typename Value, typename KeyOf, typename Hash, typename KeyEqual>
+class robin_hood_table {
+public:
+  using value_type = Value;
+  using key_type = std::remove_cvref_t<std::invoke_result_t<KeyOf, const Value&>>;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+private:
+  using distance_type = std::uint8_t;
+  static constexpr distance_type max_distance{255};
+  static constexpr size_type min_capacity{16};
+
+  std::vector<Value> slots{};
+  std::vector<distance_type> distances{};
+  std::vector<Value> overflow{};
+  size_type count{};
+  int shift{64};
+  [[no_unique_address]] Hash hash{};
+  [[no_unique_address]] KeyEqual equal{};
+  [[no_unique_address]] KeyOf key_of{};
+
+  // Fibonacci hashing takes the high bits of the product, so weak hashes still spread.
+  [[nodiscard]] constexpr size_type home(const key_type& key) const noexcept {
+    return (static_cast<std::uint64_t>(hash(key)) * 0x9e3779b97f4a7c15) >> shift;
+  }
+
+  [[nodiscard]] constexpr size_type mask() const noexcept { return slots.size() - 1; }
+
+  [[nodiscard]] constexpr bool needs_grow() const noexcept {
+    return 8 * (count + 1) > 7 * slots.size();
+  }
+
+  template <bool is_const> class iterator_impl {
+    friend robin_hood_table;
+    friend iterator_impl<not is_const>;
+
+    using table = std::conditional_t<is_const, const robin_hood_table, robin_hood_table>;
+
+    table* self{};
+    size_type index{};
+
+    constexpr iterator_impl(table* self, size_type index) noexcept
+        : self{self}, index{index} {
+      skip_empty();
+    }
+
+    constexpr void skip_empty() noexcept {
+      while (index < self->slots.size() and self->distances[index] == 0) {
+        ++index;
+      }
+    }
+
+  public:
+    using value_type = Value;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<is_const, const Value&, Value&>;
+    using pointer = std::conditional_t<is_const, const Value*, Value*>;
+    using iterator_category = std::forward_iterator_tag;
+
+    constexpr iterator_impl() noexcept = default;
+
+    constexpr operator iterator_impl<true>() const noexcept { return {self, index}; }
+
+    constexpr reference operator*() const noexcept { return self->slots[index]; }
+    constexpr pointer operator->() const noexcept { return &self->slots[index]; }
+
+    constexpr iterator_impl& operator++() noexcept {
+      ++index;
+      skip_empty();
+      return *this;
+    }
+
+    constexpr iterator_impl operator++(int) noexcept {
+      iterator_impl it{*this};
+      ++*this;
+      return it;
+    }
+
+    friend constexpr bool
+    operator==(const iterator_impl& lhs, const iterator_impl& rhs) noexcept {
+      return lhs.index == rhs.index;
+    }
+  };
+
+public:
+  using iterator = iterator_impl<false>;
+  using const_iterator = iterator_impl<true>;
+
+  constexpr robin_hood_table() = default;
+
+  constexpr explicit robin_hood_table(size_type n) { reserve(n); }
+
+  [[nodiscard]] constexpr size_type size() const noexcept { return count; }
+  [[nodiscard]] constexpr bool empty() const noexcept { return count == 0; }
+  [[nodiscard]] constexpr size_type capacity() const noexcept { return slots.size(); }
+
+  [[nodiscard]] constexpr iterator begin() noexcept { return {this, 0}; }
+  [[nodiscard]] constexpr iterator end() noexcept { return {this, slots.size()}; }
+  [[nodiscard]] constexpr const_iterator begin() const noexcept { return {this, 0}; }
+  [[nodiscard]] constexpr const_iterator end() const noexcept {
+    return {this, slots.size()};
+  }
+
+  constexpr void clear() {
+    std::ranges::fill(distances, distance_type{});
+    std::ranges::fill(slots, Value{});
+    count = 0;
+  }
+
+  constexpr void reserve(size_type n) {
+    if (8 * n > 7 * slots.size()) {
+      grow(std::bit_ceil(std::max(min_capacity, (8 * n + 6) / 7)));
+    }
+  }
+
+  [[nodiscard]] constexpr size_type find_index(const key_type& key) const noexcept {
+    if (slots.empty()) {
+      return 0;
+    }
+    size_type i{home(key)};
+    for (distance_type dist{1}; distances[i] >= dist; ++dist, i = (i + 1) & mask()) {
+      if (distances[i] == dist and equal(key_of(slots[i]), key)) {
+        return i;
+      }
+    }
+    return slots.size();
+  }
+
+  [[nodiscard]] constexpr iterator find(const key_type& key) noexcept {
+    return {this, find_index(key)};
+  }
+
+  [[nodiscard]] constexpr const_iterator find(const key_type& key) const noexcept {
+    return {this, find_index(key)};
+  }
+
+  [[nodiscard]] constexpr bool contains(const key_type& key) const noexcept {
+    return find_index(key) != slots.size();
+  }
+
+  // Throws std::overflow_error if the hash is too weak for the key to fit, and leaves the
+  // table as it was.
+  constexpr std::pair<iterator, bool> insert(Value value) {
+    if (needs_grow()) {
+      grow(std::max(min_capacity, 2 * slots.size()));
+    }
+    const key_type key{key_of(value)};
+    auto [i, dist]{probe(key)};
+    if (distances[i] == dist and equal(key_of(slots[i]), key)) {
+      return {{this, i}, false};
+    }
+    if (not place(value, i, dist)) {
+      grow(2 * slots.size(), &key);
+      std::tie(i, dist) = probe(key);
+      place(value, i, dist);
+    }
+    ++count;
+    return {{this, i}, true};
+  }
+
+  template <typename... Args>
+  constexpr std::pair<iterator, bool> emplace(Args&&... args) {
+    return insert(Value(std::forward<Args>(args)...));
+  }
+
+  constexpr size_type erase(const key_type& key) {
+    const size_type i{find_index(key)};
+    if (i == slots.size()) {
+      return 0;
+    }
+    erase_slot(i);
+    --count;
+    return 1;
+  }
+
+  [[nodiscard]] constexpr bool operator==(const robin_hood_table& other) const {
+    if (size() != other.size()) {
+      return false;
+    }
+    for (const Value& value : *this) {
+      if (auto it{other.find(key_of(value))}; it == other.end() or not(*it == value)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  // The slot of key and its probe distance there, or if key is absent, the slot and
+  // distance at which place inserts it.
+  [[nodiscard]] constexpr std::pair<size_type, distance_type>
+  probe(const key_type& key) const noexcept {
+    size_type i{home(key)};
+    distance_type dist{1};
+    for (; distances[i] >= dist; ++dist, i = (i + 1) & mask()) {
+      if (distances[i] == dist and equal(key_of(slots[i]), key)) {
+        break;
+      }
+    }
+    return {i, dist};
+  }
+
+  // Backward shift deletion, the values after slot i move one slot closer to their homes.
+  constexpr void erase_slot(size_type i) {
+    for (size_type next{(i + 1) & mask()}; distances[next] > 1;
+         i = next, next = (next + 1) & mask()) {
+      slots[i] = std::move(slots[next]);
+      distances[i] = distances[next] - 1;
+    }
+    slots[i] = Value{};
+    distances[i] = 0;
+  }
+
+  // Whether place(value, i, dist) keeps every probe distance below max_distance, found by
+  // following the distances of the displaced values without moving them.
+  [[nodiscard]] constexpr bool fits(size_type i, distance_type dist) const noexcept {
+    for (;; ++dist, i = (i + 1) & mask()) {
+      if (dist == max_distance) {
+        return false;
+      }
+      if (distances[i] == 0) {
+        return true;
+      }
+      dist = std::min(dist, distances[i]);
+    }
+  }
+
+  // Robin Hood insertion of a value known to be absent, starting at slot i with probe
+  // distance dist. Returns false, with value and the table unchanged, if a probe distance
+  // would overflow. The slots then hold a valid table of the old values but one, plus
+  // value, so erasing value and placing the displaced value again undoes the insertion,
+  // since Robin Hood probe distances only depend on the homes of the values.
+  constexpr bool place(Value& value, size_type i, distance_type dist) {
+    size_type landed{slots.size()};
+    for (;; ++dist, i = (i + 1) & mask()) {
+      if (dist == max_distance) {
+        if (landed != slots.size()) {
+          Value displaced{std::exchange(value, std::move(slots[landed]))};
+          erase_slot(landed);
+          place(displaced, home(key_of(displaced)), 1);
+        }
+        return false;
+      }
+      if (distances[i] == 0) {
+        slots[i] = std::move(value);
+        distances[i] = dist;
+        return true;
+      }
+      if (distances[i] < dist) {
+        landed = landed == slots.size() ? i : landed;
+        std::swap(slots[i], value);
+        std::swap(distances[i], dist);
+      }
+    }
+  }
+
+  // Moves every value, including those kept aside, into new_capacity slots. Values whose
+  // probe distance would overflow are kept aside, and false is returned if there are any.
+  constexpr bool rehash(size_type new_capacity) {
+    std::vector<Value> old_slots(new_capacity);
+    std::vector<distance_type> old_distances(new_capacity);
+    std::vector<Value> old_overflow;
+    old_slots.swap(slots);
+    old_distances.swap(distances);
+    old_overflow.swap(overflow);
+    shift = 64 - std::countr_zero(new_capacity);
+    auto insert_absent{[this](Value& value) {
+      if (not place(value, home(key_of(value)), 1)) {
+        overflow.push_back(std::move(value));
+      }
+    }};
+    for (size_type i{}; i < old_slots.size(); ++i) {
+      if (old_distances[i] != 0) {
+        insert_absent(old_slots[i]);
+      }
+    }
+    for (Value& value : old_overflow) {
+      insert_absent(value);
+    }
+    return overflow.empty();
+  }
+
+  // Rehashes into capacity slots, doubled while a probe distance overflows, counting the
+  // absent key if there is one. Throws std::overflow_error if that would take more than
+  // 64 slots per value, after rehashing back to the old capacity. The Robin Hood probe
+  // distances only depend on the homes of the values, so they all fit there again.
+  constexpr void grow(size_type capacity, const key_type* key = nullptr) {
+    const size_type old_capacity{slots.size()};
+    auto key_fits{[this, key] {
+      if (key == nullptr) {
+        return true;
+      }
+      const auto [i, dist]{probe(*key)};
+      return fits(i, dist);
+    }};
+    while (not rehash(capacity) or not key_fits()) {
+      capacity *= 2;
+      if (capacity > 64 * (count + 1)) {
+        rehash(old_capacity);
+        throw std::overflow_error("flat hash table probe distance overflow, weak hash");
+      }
+    }
+  }
+};
+
+} // namespace detail
+
+template <
+    typename Key,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>>
+class flat_set
+    : public detail::robin_hood_table<Key, detail::identity_key, Hash, KeyEqual> {
+  using base = detail::robin_hood_table<Key, detail::identity_key, Hash, KeyEqual>;
+
+public:
+  using key_type = Key;
+  using base::base;
+
+  constexpr flat_set() = default;
+
+  template <std::ranges::input_range R>
+    requires(
+        std::convertible_to<std::ranges::range_reference_t<R>, Key>
+        and not std::same_as<std::remove_cvref_t<R>, flat_set>
+    )
+  constexpr explicit flat_set(R&& keys) {
+    if constexpr (std::ranges::sized_range<R>) {
+      this->reserve(std::ranges::size(keys));
+    }
+    for (const Key& key : keys) {
+      this->insert(key);
+    }
+  }
+};
+
+template <
+    typename Key,
+    typename T,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>>
+class flat_map : public detail::robin_hood_table<
+                     std::pair<Key, T>,
+                     detail::first_key,
+                     Hash,
+                     KeyEqual> {
+  using base =
+      detail::robin_hood_table<std::pair<Key, T>, detail::first_key, Hash, KeyEqual>;
+
+public:
+  using key_type = Key;
+  using mapped_type = T;
+  using base::base;
+
+  template <typename... Args>
+  constexpr std::pair<typename base::iterator, bool>
+  try_emplace(const Key& key, Args&&... args) {
+    if (auto it{this->find(key)}; it != this->end()) {
+      return {it, false};
+    }
+    return this->insert(std::pair<Key, T>(key, T(std::forward<Args>(args)...)));
+  }
+
+  [[nodiscard]] constexpr T& operator[](const Key& key) {
+    return try_emplace(key).first->second;
+  }
+
+  [[nodiscard]] constexpr T& at(const Key& key) {
+    if (auto it{this->find(key)}; it != this->end()) {
+      return it->second;
+    }
+    throw std::out_of_range("flat_map::at key not found");
+  }
+
+  [[nodiscard]] constexpr const T& at(const Key& key) const {
+    if (auto it{this->find(key)}; it != this->end()) {
+      return it->second;
+    }
+    throw std::out_of_range("flat_map::at key not found");
+  }
+};
+
+} // namespace ndvec
+
+#endif // NDVEC_FLAT_HASH_HEADER_INCLUDED
@@ -0,0 +1,208 @@
+#ifndef NDVEC_GRID_HEADER_INCLUDED
+#define NDVEC_GRID_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ndvec.hpp"
+
+namespace ndvec {
+
+// Dense, row-major grid of cells covering the box [origin, origin + extent).
+// Axis 0 varies fastest, so for 2D grids x is the column and y the row.
+template <typename Cell, std::size_t ndim, std::integral T = int> class grid {
+public:
+  using vec = vecn<T, ndim>;
+  using value_type = Cell;
+  using size_type = std::size_t;
+  using iterator = std::vector<Cell>::iterator;
+  using const_iterator = std::vector<Cell>::const_iterator;
+
+  struct adjacent_indices {
+    std::array<size_type, 2 * ndim> indices{};
+    size_type count{};
+
+    [[nodiscard]] constexpr auto begin() const noexcept { return indices.begin(); }
+    [[nodiscard]] constexpr auto end() const noexcept { return indices.begin() + count; }
+    [[nodiscard]] constexpr size_type size() const noexcept { return count; }
+  };
+
+private:
+  using unsigned_type = std::make_unsigned_t<T>;
+  using strides_type = std::array<size_type, ndim>;
+
+  vec origin_{};
+  vec extent_{};
+  strides_type strides_{};
+  std::vector<Cell> cells_{};
+
+  // The strides and the cell count are size_type, because a grid of small T can have
+  // more cells than T can count. cell_count checks the product, so the strides of a
+  // constructed grid do not wrap.
+  static constexpr strides_type make_strides(const vec& extent) noexcept {
+    strides_type strides;
+    size_type stride{1};
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      ((strides[axes] = stride,
+        stride *= static_cast<size_type>(extent.template get<axes>())),
+       ...);
+    }(typename vec::axes_indices{});
+    return strides;
+  }
+
+  static constexpr size_type checked_multiply(size_type count, T axis_extent) {
+    const auto n{static_cast<size_type>(axis_extent)};
+    if (count > std::numeric_limits<size_type>::max() / n) {
+      throw std::length_error("grid cell count does not fit in size_type");
+    }
+    return count * n;
+  }
+
+  static constexpr size_type cell_count(const vec& extent) {
+    if (extent.min() < 0) {
+      throw std::invalid_argument("grid extent must be non-negative along every axis");
+    }
+    if (extent.min() == 0) {
+      return 0;
+    }
+    size_type count{1};
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      ((count = checked_multiply(count, extent.template get<axes>())), ...);
+    }(typename vec::axes_indices{});
+    return count;
+  }
+
+  template <std::size_t... axes>
+  constexpr bool
+  contains_impl(const vec& offset, std::index_sequence<axes...>) const noexcept {
+    return (
+        ...
+        & (static_cast<unsigned_type>(offset.template get<axes>())
+           < static_cast<unsigned_type>(extent_.template get<axes>()))
+    );
+  }
+
+public:
+  constexpr grid() = default;
+
+  constexpr explicit grid(const vec& extent, const Cell& fill = {})
+      : grid(vec(), extent, fill) {}
+
+  constexpr grid(const vec& origin, const vec& extent, const Cell& fill = {})
+      : origin_{origin},
+        extent_{extent},
+        strides_{make_strides(extent)},
+        cells_(cell_count(extent), fill) {}
+
+  // Grid covering the closed box [lo, hi], e.g. corners found with min/max over points.
+  [[nodiscard]] static constexpr grid
+  from_bounds(const vec& lo, const vec& hi, const Cell& fill = {}) {
+    vec one;
+    one.apply([](T) { return T{1}; });
+    return grid(lo, hi - lo + one, fill);
+  }
+
+  [[nodiscard]] constexpr const vec& origin() const noexcept { return origin_; }
+  [[nodiscard]] constexpr const vec& extent() const noexcept { return extent_; }
+  [[nodiscard]] constexpr const strides_type& strides() const noexcept {
+    return strides_;
+  }
+  [[nodiscard]] constexpr size_type size() const noexcept { return cells_.size(); }
+  [[nodiscard]] constexpr bool empty() const noexcept { return cells_.empty(); }
+
+  [[nodiscard]] constexpr std::span<Cell> cells() noexcept { return cells_; }
+  [[nodiscard]] constexpr std::span<const Cell> cells() const noexcept { return cells_; }
+
+  [[nodiscard]] constexpr iterator begin() noexcept { return cells_.begin(); }
+  [[nodiscard]] constexpr iterator end() noexcept { return cells_.end(); }
+  [[nodiscard]] constexpr const_iterator begin() const noexcept { return cells_.begin(); }
+  [[nodiscard]] constexpr const_iterator end() const noexcept { return cells_.end(); }
+
+  [[nodiscard]] constexpr bool contains(const vec& p) const noexcept {
+    return contains_impl(p - origin_, typename vec::axes_indices{});
+  }
+
+  [[nodiscard]] constexpr size_type index(const vec& p) const noexcept {
+    const vec offset{p - origin_};
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      return (
+          ... + (static_cast<size_type>(offset.template get<axes>()) * strides_[axes])
+      );
+    }(typename vec::axes_indices{});
+  }
+
+  [[nodiscard]] constexpr vec position(size_type i) const noexcept {
+    vec p;
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      ((p.template get<axes>() = static_cast<T>(i % extent_.template get<axes>()),
+        i /= extent_.template get<axes>()),
+       ...);
+    }(typename vec::axes_indices{});
+    return p + origin_;
+  }
+
+  [[nodiscard]] constexpr Cell& operator[](const vec& p) noexcept {
+    return cells_[index(p)];
+  }
+  [[nodiscard]] constexpr const Cell& operator[](const vec& p) const noexcept {
+    return cells_[index(p)];
+  }
+
+  [[nodiscard]] constexpr Cell& operator[](size_type i) noexcept { return cells_[i]; }
+  [[nodiscard]] constexpr const Cell& operator[](size_type i) const noexcept {
+    return cells_[i];
+  }
+
+  [[nodiscard]] constexpr Cell& at(const vec& p) {
+    if (not contains(p)) {
+      throw std::out_of_range("grid::at position out of bounds");
+    }
+    return (*this)[p];
+  }
+
+  [[nodiscard]] constexpr const Cell& at(const vec& p) const {
+    if (not contains(p)) {
+      throw std::out_of_range("grid::at position out of bounds");
+    }
+    return (*this)[p];
+  }
+
+  constexpr void fill(const Cell& value) { std::ranges::fill(cells_, value); }
+
+  // Linear indices of the in-bounds axis-aligned neighbours of p, in increasing order.
+  // Every neighbour is written and the count is advanced by its bounds check, so there is
+  // no branch per axis.
+  [[nodiscard]] constexpr adjacent_indices adjacent(const vec& p) const noexcept {
+    const vec offset{p - origin_};
+    const size_type center{index(p)};
+    adjacent_indices adj;
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      constexpr std::size_t last{ndim - 1};
+      ((adj.indices[adj.count] = center - strides_[last - axes],
+        adj.count += offset.template get<last - axes>() > 0),
+       ...);
+      ((adj.indices[adj.count] = center + strides_[axes],
+        adj.count += offset.template get<axes>() + 1 < extent_.template get<axes>()),
+       ...);
+    }(typename vec::axes_indices{});
+    return adj;
+  }
+
+  [[nodiscard]] constexpr adjacent_indices adjacent(size_type i) const noexcept {
+    return adjacent(position(i));
+  }
+
+  [[nodiscard]] constexpr bool operator==(const grid&) const = default;
+};
+
+} // namespace ndvec
+
+#endif // NDVEC_GRID_HEADER_INCLUDED
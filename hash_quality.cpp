@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <limits>
+#include <print>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "hash_quality.hpp"
+#include "ndvec.hpp"
+
+// Prints the hash_quality statistics of std::hash for dense boxes, lines, random points,
+// clusters and adjacent() frontiers of a few vec types, and exits with 1 if any of them
+// is outside hash_quality::limits.
+
+using namespace ndvec;
+
+constexpr std::size_t sample_size{1 << 17};
+
+bool all_acceptable{true};
+
+template <typename Vec>
+void print_report(std::string_view type, std::string_view set, std::vector<Vec> points) {
+  const hash_quality::report r{hash_quality::analyze(std::move(points))};
+  const bool ok{hash_quality::acceptable(r)};
+  all_acceptable = all_acceptable and ok;
+  hash_quality::bucket_stats worst{};
+  for (const hash_quality::bucket_stats& table : r.tables) {
+    if (std::abs(table.z_score) >= std::abs(worst.z_score)) {
+      worst = table;
+    }
+  }
+  std::println(
+      "{:<16} {:<9} {:>8} {:>5} {:>13} {:>9.4f} {:>8.2f} {:>7} {:>11} {:>7}  {}",
+      type,
+      set,
+      r.keys,
+      r.full.collisions,
+      std::format("{} ({:.1f})", r.low.collisions, r.low.expected),
+      r.avalanche.max_bias,
+      worst.z_score,
+      worst.buckets,
+      std::format("{:.3f}/{:.3f}", r.probes.mean, r.probes.expected),
+      r.probes.longest,
+      ok ? "ok" : "FAIL"
+  );
+}
+
+// Boxes of side points per axis, clusters of about 1024 points within radius of their
+// centers, and lines and random points of sample_size points, as far as T can hold them.
+template <typename Vec>
+void report_vec(
+    std::string_view type,
+    typename Vec::value_type side,
+    typename Vec::value_type radius
+) {
+  using T = Vec::value_type;
+  constexpr T lowest{std::numeric_limits<T>::lowest()};
+  constexpr T highest{std::numeric_limits<T>::max()};
+  constexpr T stride{64};
+  auto all{[](T value) {
+    Vec v;
+    v.apply([value](T) { return value; });
+    return v;
+  }};
+  auto centered{[&all](std::size_t n, T step) {
+    return all(static_cast<T>(-static_cast<T>(n / 2) * step));
+  }};
+  const std::size_t diagonal{std::min<std::size_t>(sample_size, highest)};
+  const std::size_t strided{std::min<std::size_t>(sample_size, highest / stride)};
+  const auto spread{static_cast<T>(std::min<long long>(highest / 2, 1 << 20))};
+  const std::vector<Vec> clustered{hash_quality::clusters(
+      sample_size / 1024,
+      1024,
+      radius,
+      all(static_cast<T>(-spread)),
+      all(spread)
+  )};
+
+  print_report(
+      type,
+      "box",
+      hash_quality::dense_box(all(static_cast<T>(-side / 2)), all(side))
+  );
+  print_report(
+      type,
+      "diagonal",
+      hash_quality::line(centered(diagonal, 1), all(1), diagonal)
+  );
+  print_report(
+      type,
+      "strided",
+      hash_quality::line(centered(strided, stride), all(stride), strided)
+  );
+  print_report(
+      type,
+      "random",
+      hash_quality::random_points(sample_size, all(lowest), all(highest))
+  );
+  print_report(type, "clusters", clustered);
+  if constexpr (requires(const Vec& v) { v.adjacent(); }) {
+    print_report(type, "frontier", hash_quality::frontier(clustered));
+  }
+}
+
+int main() {
+  std::println(
+      "{:<16} {:<9} {:>8} {:>5} {:>13} {:>9} {:>8} {:>7} {:>11} {:>7}",
+      "type",
+      "points",
+      "keys",
+      "coll",
+      "low 32 coll",
+      "avalanche",
+      "worst z",
+      "buckets",
+      "probes",
+      "longest"
+  );
+  report_vec<vec2<short>>("vec2<short>", 128, 16);
+  report_vec<vec2<int>>("vec2<int>", 512, 16);
+  report_vec<vec3<int>>("vec3<int>", 64, 5);
+  report_vec<vec3<long long>>("vec3<long long>", 64, 5);
+  report_vec<vec4<short>>("vec4<short>", 12, 2);
+  return all_acceptable ? 0 : 1;
+}
@@ -0,0 +1,415 @@
+#ifndef NDVEC_HASH_QUALITY_HEADER_INCLUDED
+#define NDVEC_HASH_QUALITY_HEADER_INCLUDED
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "grid.hpp"
+#include "ndvec.hpp"
+#include "radix_sort.hpp"
+
+// Statistics of how evenly a hash function spreads sets of integral ndvecs: collisions,
+// avalanche, the distribution over hash table buckets and the lookup lengths of
+// std::unordered_set, together with generators of the coordinate sets programs hash.
+// Collisions are counted by sorting the hashes and buckets by counting them, so a
+// million points take a fraction of a second.
+namespace ndvec::hash_quality {
+
+namespace detail {
+
+template <typename Vec>
+concept hashable_vec = requires {
+  typename Vec::value_type;
+  requires std::same_as<Vec, vecn<typename Vec::value_type, Vec::ndim>>;
+  requires std::integral<typename Vec::value_type>;
+  requires not std::same_as<typename Vec::value_type, bool>;
+};
+
+template <typename Hash, typename Vec>
+concept vec_hash = std::copy_constructible<Hash>
+                   and std::is_invocable_r_v<std::size_t, const Hash&, const Vec&>;
+
+template <typename Vec>
+[[nodiscard]] constexpr Vec filled(typename Vec::value_type value) noexcept {
+  Vec v;
+  v.apply([value](Vec::value_type) { return value; });
+  return v;
+}
+
+// v with one bit of the two's complement value of one axis flipped
+template <typename Vec>
+[[nodiscard]] constexpr Vec flip_bit(Vec v, std::size_t axis, std::size_t bit) noexcept {
+  using T = Vec::value_type;
+  using U = std::make_unsigned_t<T>;
+  auto flip{[bit](T& value) {
+    value = static_cast<T>(static_cast<U>(value) ^ static_cast<U>(U{1} << bit));
+  }};
+  [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+    ((axes == axis ? flip(v.template get<axes>()) : void()), ...);
+  }(typename Vec::axes_indices{});
+  return v;
+}
+
+template <typename Vec, typename Hash>
+[[nodiscard]] std::vector<std::uint64_t>
+hashes_of(std::span<const Vec> points, const Hash& hash) {
+  std::vector<std::uint64_t> res(points.size());
+  std::ranges::transform(points, res.begin(), [&hash](const Vec& p) -> std::uint64_t {
+    return std::invoke(hash, p);
+  });
+  return res;
+}
+
+[[nodiscard]] constexpr bool is_prime(std::size_t n) noexcept {
+  if (n < 4) {
+    return n > 1;
+  }
+  if (n % 2 == 0) {
+    return false;
+  }
+  for (std::size_t d{3}; d * d <= n; d += 2) {
+    if (n % d == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace detail
+
+using detail::hashable_vec;
+using detail::vec_hash;
+
+// Every point of the box [origin, origin + extent).
+template <hashable_vec Vec>
+[[nodiscard]] std::vector<Vec> dense_box(const Vec& origin, const Vec& extent) {
+  const grid<std::uint8_t, Vec::ndim, typename Vec::value_type> box(origin, extent);
+  std::vector<Vec> points(box.size());
+  for (std::size_t i{}; i < points.size(); ++i) {
+    points[i] = box.position(i);
+  }
+  return points;
+}
+
+// The n points start, start + step, start + 2 * step and so on, e.g. a diagonal for a
+// step of ones. The points must not overflow.
+template <hashable_vec Vec>
+[[nodiscard]] std::vector<Vec> line(Vec start, const Vec& step, std::size_t n) {
+  std::vector<Vec> points;
+  points.reserve(n);
+  for (std::size_t i{}; i < n; ++i, start += step) {
+    points.push_back(start);
+  }
+  return points;
+}
+
+// n points drawn uniformly from the box [lo, hi], both inclusive.
+template <hashable_vec Vec>
+[[nodiscard]] std::vector<Vec>
+random_points(std::size_t n, const Vec& lo, const Vec& hi, std::uint64_t seed = 1) {
+  using T = Vec::value_type;
+  // uniform_int_distribution is not defined for char types
+  using Wide = std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>;
+  std::mt19937_64 rng(seed);
+  auto sample{[&rng](T a, T b) {
+    return static_cast<T>(std::uniform_int_distribution<Wide>(a, b)(rng));
+  }};
+  std::vector<Vec> points(n);
+  for (Vec& p : points) {
+    p = [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      // braces sample the axes in order
+      return Vec{sample(lo.template get<axes>(), hi.template get<axes>())...};
+    }(typename Vec::axes_indices{});
+  }
+  return points;
+}
+
+// per_cluster points within radius of each of n_clusters centers drawn from [lo, hi] on
+// every axis, like the particles of a simulation. The points must not overflow.
+template <hashable_vec Vec>
+[[nodiscard]] std::vector<Vec> clusters(
+    std::size_t n_clusters,
+    std::size_t per_cluster,
+    typename Vec::value_type radius,
+    const Vec& lo,
+    const Vec& hi,
+    std::uint64_t seed = 1
+) {
+  const std::vector<Vec> centers{random_points(n_clusters, lo, hi, seed)};
+  std::vector<Vec> points{random_points(
+      n_clusters * per_cluster,
+      detail::filled<Vec>(static_cast<Vec::value_type>(-radius)),
+      detail::filled<Vec>(radius),
+      seed + 1
+  )};
+  for (std::size_t i{}; i < points.size(); ++i) {
+    points[i] += centers[i / per_cluster];
+  }
+  return points;
+}
+
+// The adjacent() points of the points that are not among them, e.g. the frontier of a
+// flood fill that has visited the points. The neighbours must not overflow.
+template <hashable_vec Vec>
+  requires requires(const Vec& v) { v.adjacent(); }
+[[nodiscard]] std::vector<Vec> frontier(std::vector<Vec> points) {
+  points.resize(::ndvec::sort_unique(points));
+  std::vector<Vec> res;
+  for (const Vec& p : points) {
+    for (const Vec& adj : p.adjacent()) {
+      if (not std::ranges::binary_search(points, adj)) {
+        res.push_back(adj);
+      }
+    }
+  }
+  res.resize(::ndvec::sort_unique(res));
+  return res;
+}
+
+struct collision_stats {
+  std::size_t keys{};
+  // keys whose truncated hash is the same as that of another key before them
+  std::size_t collisions{};
+  // mean of collisions for uniformly random hashes
+  double expected{};
+};
+
+// Collisions of the low bits of the hashes of distinct keys, e.g. 32 for the collisions a
+// table of 2^32 buckets would see.
+[[nodiscard]] inline collision_stats
+collisions(std::vector<std::uint64_t> hashes, int bits = 64) {
+  if (bits < 1 or bits > 64) {
+    throw std::invalid_argument("hash bits must be in [1, 64]");
+  }
+  const std::uint64_t mask{~std::uint64_t{} >> (64 - bits)};
+  for (std::uint64_t& h : hashes) {
+    h &= mask;
+  }
+  std::ranges::sort(hashes);
+  const auto distinct{std::ranges::unique(hashes).begin() - hashes.begin()};
+  const auto n{static_cast<double>(hashes.size())};
+  const double m{std::ldexp(1.0, bits)};
+  return {
+      .keys = hashes.size(),
+      .collisions = hashes.size() - static_cast<std::size_t>(distinct),
+      // n minus the expected number of distinct values in n draws from m
+      .expected = n + m * std::expm1(n * std::log1p(-1 / m)),
+  };
+}
+
+struct bucket_stats {
+  std::size_t buckets{};
+  // Pearson's chi-square statistic of the bucket sizes against equal sizes
+  double chi_square{};
+  // chi_square minus its mean over its standard deviation for uniformly random hashes,
+  // which is about standard normal, so beyond +-4 it is unlikely to be chance
+  double z_score{};
+};
+
+// Distribution of the hashes over a table of the given number of buckets, with the hash
+// modulo the size as the bucket like std::unordered_set, i.e. the low bits of the hash
+// for power-of-two sizes.
+[[nodiscard]] inline bucket_stats
+bucket_distribution(std::span<const std::uint64_t> hashes, std::size_t buckets) {
+  if (buckets < 2) {
+    throw std::invalid_argument("bucket_distribution needs at least 2 buckets");
+  }
+  bucket_stats res{.buckets = buckets};
+  if (hashes.empty()) {
+    return res;
+  }
+  std::vector<std::size_t> sizes(buckets);
+  for (const std::uint64_t h : hashes) {
+    ++sizes[h % buckets];
+  }
+  const auto n{static_cast<double>(hashes.size())};
+  const double expected{n / static_cast<double>(buckets)};
+  double squares{};
+  for (const std::size_t size : sizes) {
+    squares += static_cast<double>(size) * static_cast<double>(size);
+  }
+  const auto freedom{static_cast<double>(buckets - 1)};
+  res.chi_square = squares / expected - n;
+  res.z_score = (res.chi_square - freedom) / std::sqrt(2 * freedom);
+  return res;
+}
+
+struct avalanche_stats {
+  std::size_t samples{};
+  // largest and mean distance from 1/2 of the probability that flipping an input bit
+  // flips an output bit, over all pairs of input and output bits
+  double max_bias{};
+  double mean_bias{};
+  // mean number of hash bits flipped by flipping one input bit, half of the hash width
+  // for an ideal hash
+  double mean_flipped{};
+};
+
+// Flips every bit of every axis of every point and counts the hash bits that change.
+// The biases of an ideal hash have a standard deviation of 0.5 / sqrt(points.size())
+// from sampling alone.
+template <hashable_vec Vec, vec_hash<Vec> Hash = std::hash<Vec>>
+[[nodiscard]] avalanche_stats
+avalanche(std::span<const Vec> points, const Hash& hash = {}) {
+  using U = std::make_unsigned_t<typename Vec::value_type>;
+  constexpr std::size_t axis_bits{std::numeric_limits<U>::digits};
+  constexpr std::size_t input_bits{Vec::ndim * axis_bits};
+  constexpr std::size_t output_bits{std::numeric_limits<std::size_t>::digits};
+  avalanche_stats res{.samples = points.size()};
+  if (points.empty()) {
+    return res;
+  }
+  std::vector<std::size_t> flips(input_bits * output_bits);
+  for (const Vec& p : points) {
+    const std::size_t h{std::invoke(hash, p)};
+    for (std::size_t bit{}; bit < input_bits; ++bit) {
+      const Vec flipped{detail::flip_bit(p, bit / axis_bits, bit % axis_bits)};
+      std::size_t diff{h ^ std::invoke(hash, flipped)};
+      for (; diff != 0; diff &= diff - 1) {
+        ++flips[bit * output_bits + static_cast<std::size_t>(std::countr_zero(diff))];
+      }
+    }
+  }
+  const auto n{static_cast<double>(points.size())};
+  double total{};
+  for (const std::size_t f : flips) {
+    const double bias{std::abs(static_cast<double>(f) / n - 0.5)};
+    res.max_bias = std::max(res.max_bias, bias);
+    res.mean_bias += bias;
+    total += static_cast<double>(f);
+  }
+  res.mean_bias /= static_cast<double>(flips.size());
+  res.mean_flipped = total / (n * input_bits);
+  return res;
+}
+
+struct probe_stats {
+  std::size_t buckets{};
+  // mean number of keys a lookup of every key walks through in its bucket
+  double mean{};
+  // the same for uniformly random hashes, 1 + (keys - 1) / (2 * buckets)
+  double expected{};
+  // keys in the largest bucket
+  std::size_t longest{};
+};
+
+// Lookup lengths of the distinct points in a std::unordered_set at its default load
+// factor.
+template <hashable_vec Vec, vec_hash<Vec> Hash = std::hash<Vec>>
+[[nodiscard]] probe_stats
+probe_lengths(std::span<const Vec> points, const Hash& hash = {}) {
+  const std::unordered_set<Vec, Hash> set(points.begin(), points.end(), 0, hash);
+  probe_stats res{.buckets = set.bucket_count()};
+  double walked{};
+  for (std::size_t b{}; b < res.buckets; ++b) {
+    const std::size_t size{set.bucket_size(b)};
+    walked += static_cast<double>(size) * static_cast<double>(size + 1) / 2;
+    res.longest = std::max(res.longest, size);
+  }
+  if (not set.empty()) {
+    const auto n{static_cast<double>(set.size())};
+    res.mean = walked / n;
+    res.expected = 1 + (n - 1) / (2 * static_cast<double>(res.buckets));
+  }
+  return res;
+}
+
+// Powers of two and primes around keys and keys / 16, i.e. tables at load factors of
+// about 1 and 16.
+[[nodiscard]] inline std::vector<std::size_t> table_sizes(std::size_t keys) {
+  std::vector<std::size_t> sizes;
+  for (const std::size_t target : {keys / 16, keys}) {
+    if (target < 2) {
+      continue;
+    }
+    sizes.push_back(std::bit_floor(target));
+    std::size_t prime{target};
+    while (not detail::is_prime(prime)) {
+      ++prime;
+    }
+    sizes.push_back(prime);
+  }
+  return sizes;
+}
+
+// Points used for avalanche by analyze, spread evenly over the sorted points.
+inline constexpr std::size_t avalanche_samples{1024};
+
+struct report {
+  std::size_t keys{};
+  collision_stats full{};
+  collision_stats low{};
+  avalanche_stats avalanche{};
+  std::vector<bucket_stats> tables{};
+  probe_stats probes{};
+};
+
+// Removes duplicate points and measures the collisions of the full hashes and of their
+// low 32 bits, the avalanche, the bucket distributions for table_sizes and the
+// std::unordered_set lookup lengths.
+template <hashable_vec Vec, vec_hash<Vec> Hash = std::hash<Vec>>
+[[nodiscard]] report analyze(std::vector<Vec> points, const Hash& hash = {}) {
+  points.resize(::ndvec::sort_unique(points));
+  const std::span<const Vec> keys(points);
+  const std::vector<std::uint64_t> hashes{detail::hashes_of(keys, hash)};
+  report res{
+      .keys = keys.size(),
+      .full = collisions(hashes, 64),
+      .low = collisions(hashes, 32),
+  };
+  std::vector<Vec> sampled;
+  const std::size_t stride{std::max(1uz, keys.size() / avalanche_samples)};
+  for (std::size_t i{}; i < keys.size(); i += stride) {
+    sampled.push_back(keys[i]);
+  }
+  res.avalanche = avalanche(std::span<const Vec>(sampled), hash);
+  for (const std::size_t size : table_sizes(keys.size())) {
+    res.tables.push_back(bucket_distribution(hashes, size));
+  }
+  res.probes = probe_lengths(keys, hash);
+  return res;
+}
+
+struct limits {
+  // largest |z_score| of any table size
+  double z_score{6};
+  // largest avalanche max_bias in standard deviations of the sampling noise of an ideal
+  // hash, which is about 4 for 1024 points of a vec3<int>
+  double avalanche_deviations{6.5};
+  // largest ratio of the mean to the expected unordered_set lookup length
+  double probe_ratio{1.25};
+};
+
+// True if the report is within the limits and both collision counts are within four
+// standard deviations of their mean, as for uniformly random hashes.
+[[nodiscard]] inline bool acceptable(const report& r, const limits& lim = {}) {
+  auto few_collisions{[](const collision_stats& c) {
+    const double deviation{std::sqrt(c.expected)};
+    return static_cast<double>(c.collisions) <= c.expected + 4 * deviation + 1;
+  }};
+  return few_collisions(r.full) and few_collisions(r.low)
+         and r.avalanche.max_bias * std::sqrt(static_cast<double>(r.avalanche.samples))
+                 <= 0.5 * lim.avalanche_deviations
+         and std::ranges::all_of(
+             r.tables,
+             [&lim](const bucket_stats& t) { return std::abs(t.z_score) <= lim.z_score; }
+         )
+         and r.probes.mean <= lim.probe_ratio * r.probes.expected;
+}
+
+} // namespace ndvec::hash_quality
+
+#endif // NDVEC_HASH_QUALITY_HEADER_INCLUDED
@@ -0,0 +1,281 @@
+#ifndef NDVEC_INSTRUMENT_HEADER_INCLUDED
+#define NDVEC_INSTRUMENT_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Operation counters for the NDVEC_INSTRUMENT build mode, in which ndvec.hpp counts its
+// operations here. Every thread increments its own counters, which are summed over all
+// threads, including the ones that have exited, when they are read.
+namespace ndvec::instrument {
+
+enum class op : std::uint8_t {
+  // element-wise operators, min, max, abs, signum, cross and rotations
+  arithmetic,
+  // sum, prod, min, max, distance and dot over the axes
+  reduction,
+  // ndvec results returned by value from the non-mutating operators
+  temporary,
+  // calls to std::hash<ndvec>
+  hash,
+  // calls to std::formatter<ndvec>, including operator<<
+  format,
+  // calls to operator>>
+  parse,
+};
+
+inline constexpr std::size_t op_count{6};
+
+inline constexpr std::array<std::string_view, op_count> op_names{
+    "arithmetic",
+    "reductions",
+    "temporaries",
+    "hashes",
+    "formats",
+    "parses",
+};
+
+struct counters {
+  std::array<std::uint64_t, op_count> values{};
+
+  [[nodiscard]] constexpr std::uint64_t operator[](op o) const noexcept {
+    return values[std::to_underlying(o)];
+  }
+
+  constexpr counters& operator+=(const counters& rhs) noexcept {
+    for (std::size_t i{}; i < op_count; ++i) {
+      values[i] += rhs.values[i];
+    }
+    return *this;
+  }
+
+  [[nodiscard]] constexpr counters operator-(const counters& rhs) const noexcept {
+    counters res{*this};
+    for (std::size_t i{}; i < op_count; ++i) {
+      res.values[i] -= rhs.values[i];
+    }
+    return res;
+  }
+
+  [[nodiscard]] constexpr bool operator==(const counters&) const = default;
+};
+
+namespace detail {
+
+struct thread_counters;
+
+struct registry {
+  std::mutex mutex;
+  std::vector<thread_counters*> live;
+  // counts of the threads that have exited
+  counters retired;
+  // totals of every named region, in the order the names first completed
+  std::vector<std::pair<std::string, counters>> regions;
+  // number of resets, so that open regions notice them
+  std::uint64_t epoch{};
+};
+
+inline registry& global() {
+  static registry r;
+  return r;
+}
+
+// Only the owning thread writes its counters, so an increment is a relaxed load and
+// store instead of a locked read-modify-write.
+struct thread_counters {
+  std::array<std::atomic<std::uint64_t>, op_count> values{};
+
+  thread_counters() {
+    registry& r{global()};
+    std::scoped_lock lock(r.mutex);
+    r.live.push_back(this);
+  }
+
+  thread_counters(const thread_counters&) = delete;
+  thread_counters& operator=(const thread_counters&) = delete;
+
+  ~thread_counters() {
+    registry& r{global()};
+    std::scoped_lock lock(r.mutex);
+    r.retired += load();
+    std::erase(r.live, this);
+  }
+
+  [[nodiscard]] counters load() const noexcept {
+    counters res;
+    for (std::size_t i{}; i < op_count; ++i) {
+      res.values[i] = values[i].load(std::memory_order_relaxed);
+    }
+    return res;
+  }
+};
+
+inline thread_counters& local() {
+  thread_local thread_counters c;
+  return c;
+}
+
+inline void increment(op o) noexcept {
+  std::atomic<std::uint64_t>& c{local().values[std::to_underlying(o)]};
+  c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// The counts of all threads, the caller holds r.mutex.
+inline counters total(const registry& r) noexcept {
+  counters res{r.retired};
+  for (const thread_counters* c : r.live) {
+    res += c->load();
+  }
+  return res;
+}
+
+inline void append_json(std::string& out, const counters& c) {
+  out += '{';
+  for (std::size_t i{}; i < op_count; ++i) {
+    std::format_to(
+        std::back_inserter(out),
+        "\"{}\": {}{}",
+        op_names[i],
+        c.values[i],
+        i + 1 < op_count ? ", " : ""
+    );
+  }
+  out += '}';
+}
+
+} // namespace detail
+
+// Counts one operation on the calling thread. Does nothing during constant evaluation,
+// so the counted operations stay constexpr.
+constexpr void count(op o) noexcept {
+  if !consteval {
+    detail::increment(o);
+  }
+}
+
+// The counts of all threads.
+[[nodiscard]] inline counters snapshot() {
+  detail::registry& r{detail::global()};
+  std::scoped_lock lock(r.mutex);
+  return detail::total(r);
+}
+
+// The total counts of every named region.
+[[nodiscard]] inline std::vector<std::pair<std::string, counters>> regions() {
+  detail::registry& r{detail::global()};
+  std::scoped_lock lock(r.mutex);
+  return r.regions;
+}
+
+// Zeroes all counters and forgets the regions. Counts made concurrently on other threads
+// may be lost, and open regions count from the reset.
+inline void reset() {
+  detail::registry& r{detail::global()};
+  std::scoped_lock lock(r.mutex);
+  ++r.epoch;
+  r.retired = {};
+  for (detail::thread_counters* c : r.live) {
+    for (std::atomic<std::uint64_t>& v : c->values) {
+      v.store(0, std::memory_order_relaxed);
+    }
+  }
+  r.regions.clear();
+}
+
+// Adds the operations counted by all threads between its construction and destruction to
+// the total of its name, e.g. one region for every phase of a job. Regions with the same
+// name accumulate, and nested regions both count the inner operations. A region that is
+// open during a reset() only counts the operations after the reset.
+class region {
+  std::string name_;
+  counters start_;
+  std::uint64_t epoch_{};
+
+public:
+  explicit region(std::string name) : name_{std::move(name)} {
+    detail::registry& r{detail::global()};
+    std::scoped_lock lock(r.mutex);
+    start_ = detail::total(r);
+    epoch_ = r.epoch;
+  }
+
+  region(const region&) = delete;
+  region& operator=(const region&) = delete;
+
+  ~region() {
+    detail::registry& r{detail::global()};
+    std::scoped_lock lock(r.mutex);
+    const counters delta{detail::total(r) - (r.epoch == epoch_ ? start_ : counters{})};
+    const auto it{std::ranges::find_if(r.regions, [this](const auto& named) {
+      return named.first == name_;
+    })};
+    if (it == r.regions.end()) {
+      r.regions.emplace_back(std::move(name_), delta);
+    } else {
+      it->second += delta;
+    }
+  }
+};
+
+// The totals and the regions as a JSON object:
+// {"total": {"arithmetic": 1, ...}, "regions": {"name": {...}, ...}}
+[[nodiscard]] inline std::string to_json() {
+  auto quoted{[](std::string_view s) {
+    std::string res{'"'};
+    for (char ch : s) {
+      if (ch == '"' or ch == '\\') {
+        res += '\\';
+      }
+      res += ch;
+    }
+    return res + '"';
+  }};
+  std::string json{"{\"total\": "};
+  detail::append_json(json, snapshot());
+  json += ", \"regions\": {";
+  const auto named{regions()};
+  for (std::size_t i{}; i < named.size(); ++i) {
+    json += quoted(named[i].first) + ": ";
+    detail::append_json(json, named[i].second);
+    json += i + 1 < named.size() ? ", " : "";
+  }
+  return json + "}}";
+}
+
+// The totals and the regions as an aligned table with one column per counter.
+[[nodiscard]] inline std::string report() {
+  const auto named{regions()};
+  std::size_t width{std::string_view{"total"}.size()};
+  for (const auto& [name, c] : named) {
+    width = std::max(width, name.size());
+  }
+  std::string out{std::format("{:{}}", "", width)};
+  for (std::string_view name : op_names) {
+    std::format_to(std::back_inserter(out), " {:>12}", name);
+  }
+  auto row{[&](std::string_view name, const counters& c) {
+    std::format_to(std::back_inserter(out), "\n{:{}}", name, width);
+    for (std::uint64_t v : c.values) {
+      std::format_to(std::back_inserter(out), " {:>12}", v);
+    }
+  }};
+  row("total", snapshot());
+  for (const auto& [name, c] : named) {
+    row(name, c);
+  }
+  return out + '\n';
+}
+
+} // namespace ndvec::instrument
+
+#endif // NDVEC_INSTRUMENT_HEADER_INCLUDED
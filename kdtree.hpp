@@ -0,0 +1,258 @@
+#ifndef NDVEC_KDTREE_HEADER_INCLUDED
+#define NDVEC_KDTREE_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <queue>
+#include <ranges>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "metric.hpp"
+#include "ndvec.hpp"
+#include "parallel.hpp"
+
+namespace ndvec {
+
+// Static k-d tree over a set of points. The nodes are stored in one array in the order
+// of an implicit balanced tree: the node of the subrange [lo, hi) sits at its middle
+// index, its left subtree in [lo, mid) and its right subtree in (mid, hi). Every node
+// splits on the axis where its subrange has the widest extent.
+template <typename Vec> class kdtree {
+public:
+  using vec = Vec;
+  using value_type = Vec::value_type;
+  using size_type = std::size_t;
+
+  struct neighbor {
+    value_type distance{};
+    // position of the point in the range the tree was built from
+    size_type index{};
+
+    [[nodiscard]] constexpr auto operator<=>(const neighbor&) const noexcept = default;
+  };
+
+private:
+  using coords_type = std::array<value_type, Vec::ndim>;
+
+  struct node {
+    Vec point{};
+    size_type index{};
+    std::uint8_t axis{};
+  };
+
+  // subranges smaller than this are built on the calling thread
+  static constexpr size_type parallel_build_min_size{1 << 14};
+
+  std::vector<node> nodes;
+
+  [[nodiscard]] static constexpr coords_type coords(const Vec& v) noexcept {
+    return std::apply([](auto... vs) { return coords_type{vs...}; }, v.values());
+  }
+
+  [[nodiscard]] static constexpr value_type
+  abs_diff(value_type lhs, value_type rhs) noexcept {
+    return lhs < rhs ? rhs - lhs : lhs - rhs;
+  }
+
+  void build(size_type lo, size_type hi, int spawn_depth) {
+    if (hi - lo <= 1) {
+      return;
+    }
+    auto begin{nodes.begin() + lo}, end{nodes.begin() + hi};
+    Vec min_point{begin->point}, max_point{begin->point};
+    for (auto it{begin}; it != end; ++it) {
+      min_point = min_point.min(it->point);
+      max_point = max_point.max(it->point);
+    }
+    const coords_type extent{coords(max_point - min_point)};
+    const auto axis{
+        static_cast<std::uint8_t>(std::ranges::max_element(extent) - extent.begin())
+    };
+
+    const size_type mid{lo + (hi - lo) / 2};
+    auto axis_less{[axis](const node& a, const node& b) {
+      return coords(a.point)[axis] < coords(b.point)[axis];
+    }};
+    std::nth_element(begin, nodes.begin() + mid, end, axis_less);
+    nodes[mid].axis = axis;
+
+    if (spawn_depth > 0 and hi - lo >= parallel_build_min_size) {
+      std::thread left([this, lo, mid, spawn_depth] { build(lo, mid, spawn_depth - 1); });
+      build(mid + 1, hi, spawn_depth - 1);
+      left.join();
+    } else {
+      build(lo, mid, 0);
+      build(mid + 1, hi, 0);
+    }
+  }
+
+  template <typename Metric, typename Heap>
+  void nearest_impl(
+      const coords_type& q,
+      const Vec& query,
+      size_type k,
+      size_type lo,
+      size_type hi,
+      Heap& heap
+  ) const {
+    if (lo >= hi) {
+      return;
+    }
+    const size_type mid{lo + (hi - lo) / 2};
+    const node& n{nodes[mid]};
+    const neighbor candidate{metric::distance<Metric>(query, n.point), n.index};
+    if (heap.size() < k) {
+      heap.push(candidate);
+    } else if (candidate < heap.top()) {
+      heap.pop();
+      heap.push(candidate);
+    }
+    const value_type split{coords(n.point)[n.axis]};
+    const bool go_left{q[n.axis] < split};
+    if (go_left) {
+      nearest_impl<Metric>(q, query, k, lo, mid, heap);
+    } else {
+      nearest_impl<Metric>(q, query, k, mid + 1, hi, heap);
+    }
+    const value_type plane{Metric::axis_distance(abs_diff(q[n.axis], split))};
+    if (heap.size() < k or not(heap.top().distance < plane)) {
+      if (go_left) {
+        nearest_impl<Metric>(q, query, k, mid + 1, hi, heap);
+      } else {
+        nearest_impl<Metric>(q, query, k, lo, mid, heap);
+      }
+    }
+  }
+
+  template <typename Metric>
+  void within_radius_impl(
+      const coords_type& q,
+      const Vec& query,
+      value_type radius,
+      size_type lo,
+      size_type hi,
+      std::vector<neighbor>& out
+  ) const {
+    if (lo >= hi) {
+      return;
+    }
+    const size_type mid{lo + (hi - lo) / 2};
+    const node& n{nodes[mid]};
+    if (auto dist{metric::distance<Metric>(query, n.point)}; not(radius < dist)) {
+      out.emplace_back(dist, n.index);
+    }
+    const value_type split{coords(n.point)[n.axis]};
+    const bool near_plane{
+        not(radius < Metric::axis_distance(abs_diff(q[n.axis], split)))
+    };
+    if (q[n.axis] < split or near_plane) {
+      within_radius_impl<Metric>(q, query, radius, lo, mid, out);
+    }
+    if (not(q[n.axis] < split) or near_plane) {
+      within_radius_impl<Metric>(q, query, radius, mid + 1, hi, out);
+    }
+  }
+
+  void within_box_impl(
+      const coords_type& lo_coords,
+      const coords_type& hi_coords,
+      size_type lo,
+      size_type hi,
+      std::vector<size_type>& out
+  ) const {
+    if (lo >= hi) {
+      return;
+    }
+    const size_type mid{lo + (hi - lo) / 2};
+    const node& n{nodes[mid]};
+    const coords_type p{coords(n.point)};
+    bool inside{true};
+    for (std::size_t axis{}; axis < Vec::ndim; ++axis) {
+      inside = inside and lo_coords[axis] <= p[axis] and p[axis] <= hi_coords[axis];
+    }
+    if (inside) {
+      out.push_back(n.index);
+    }
+    if (lo_coords[n.axis] <= p[n.axis]) {
+      within_box_impl(lo_coords, hi_coords, lo, mid, out);
+    }
+    if (p[n.axis] <= hi_coords[n.axis]) {
+      within_box_impl(lo_coords, hi_coords, mid + 1, hi, out);
+    }
+  }
+
+public:
+  kdtree() = default;
+
+  // Builds the tree in O(n log n). Large inputs are split across threads, up to about
+  // one subtree per hardware thread.
+  template <std::ranges::input_range R>
+    requires(
+        std::convertible_to<std::ranges::range_reference_t<R>, Vec>
+        and not std::same_as<std::remove_cvref_t<R>, kdtree>
+    )
+  explicit kdtree(R&& points) {
+    for (size_type i{}; const Vec& p : points) {
+      nodes.emplace_back(p, i++);
+    }
+    build(0, nodes.size(), std::bit_width(parallel::thread_count() - 1));
+  }
+
+  [[nodiscard]] constexpr size_type size() const noexcept { return nodes.size(); }
+  [[nodiscard]] constexpr bool empty() const noexcept { return nodes.empty(); }
+
+  // The k points closest to query, ordered by distance and then by index.
+  template <metric::axis_metric Metric = metric::manhattan>
+  [[nodiscard]] std::vector<neighbor>
+  nearest(const Vec& query, size_type k, Metric = {}) const {
+    std::priority_queue<neighbor> heap;
+    if (k > 0) {
+      nearest_impl<Metric>(coords(query), query, k, 0, nodes.size(), heap);
+    }
+    std::vector<neighbor> res(heap.size());
+    for (auto it{res.rbegin()}; it != res.rend(); ++it, heap.pop()) {
+      *it = heap.top();
+    }
+    return res;
+  }
+
+  template <metric::axis_metric Metric = metric::manhattan>
+  [[nodiscard]] std::optional<neighbor> nearest(const Vec& query, Metric m = {}) const {
+    if (auto res{nearest(query, 1, m)}; not res.empty()) {
+      return res.front();
+    }
+    return std::nullopt;
+  }
+
+  // All points at most radius away from query, ordered by distance and then by index.
+  template <metric::axis_metric Metric = metric::manhattan>
+  [[nodiscard]] std::vector<neighbor>
+  within_radius(const Vec& query, value_type radius, Metric = {}) const {
+    std::vector<neighbor> res;
+    within_radius_impl<Metric>(coords(query), query, radius, 0, nodes.size(), res);
+    std::ranges::sort(res);
+    return res;
+  }
+
+  // Indices of all points inside the closed box [lo, hi], in increasing order.
+  [[nodiscard]] std::vector<size_type> within_box(const Vec& lo, const Vec& hi) const {
+    std::vector<size_type> res;
+    within_box_impl(coords(lo), coords(hi), 0, nodes.size(), res);
+    std::ranges::sort(res);
+    return res;
+  }
+};
+
+template <std::ranges::input_range R>
+kdtree(R&&) -> kdtree<std::ranges::range_value_t<R>>;
+
+} // namespace ndvec
+
+#endif // NDVEC_KDTREE_HEADER_INCLUDED
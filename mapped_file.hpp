@@ -0,0 +1,116 @@
+#ifndef NDVEC_MAPPED_FILE_HEADER_INCLUDED
+#define NDVEC_MAPPED_FILE_HEADER_INCLUDED
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NDVEC_HAS_MMAP 1
+#endif
+
+namespace ndvec {
+
+// Read-only view of the contents of a whole file. The file is mapped into memory where
+// mmap is available, so the pages are read lazily and never copied, and read into a
+// buffer otherwise.
+class mapped_file {
+  const char* data_{};
+  std::size_t size_{};
+  // contents of the file where mmap is not available
+  std::string buffer;
+
+  [[noreturn]] static void fail(const std::filesystem::path& path, int error = errno) {
+    throw std::system_error(
+        error,
+        std::generic_category(),
+        "mapped_file cannot read " + path.string()
+    );
+  }
+
+  void unmap() noexcept {
+#ifdef NDVEC_HAS_MMAP
+    if (data_) {
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+  }
+
+  void take(mapped_file& other) noexcept {
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+#ifndef NDVEC_HAS_MMAP
+    buffer = std::move(other.buffer);
+    data_ = buffer.data();
+#endif
+  }
+
+public:
+  explicit mapped_file(const std::filesystem::path& path) {
+#ifdef NDVEC_HAS_MMAP
+    const int fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0) {
+      fail(path);
+    }
+    struct ::stat st{};
+    if (::fstat(fd, &st) != 0) {
+      const int error{errno};
+      ::close(fd);
+      fail(path, error);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ > 0) {
+      void* p{::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0)};
+      if (p == MAP_FAILED) {
+        const int error{errno};
+        ::close(fd);
+        fail(path, error);
+      }
+      ::madvise(p, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<const char*>(p);
+    }
+    ::close(fd);
+#else
+    std::ifstream is(path, std::ios::binary);
+    if (not is) {
+      fail(path);
+    }
+    buffer.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    data_ = buffer.data();
+    size_ = buffer.size();
+#endif
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  mapped_file(mapped_file&& other) noexcept { take(other); }
+
+  mapped_file& operator=(mapped_file&& other) noexcept {
+    if (this != &other) {
+      unmap();
+      take(other);
+    }
+    return *this;
+  }
+
+  ~mapped_file() { unmap(); }
+
+  [[nodiscard]] const char* data() const noexcept { return data_; }
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] std::string_view view() const noexcept { return {data_, size_}; }
+};
+
+} // namespace ndvec
+
+#endif // NDVEC_MAPPED_FILE_HEADER_INCLUDED
@@ -0,0 +1,242 @@
+#ifndef NDVEC_MAT_HEADER_INCLUDED
+#define NDVEC_MAT_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "ndvec.hpp"
+
+// Square matrices and affine transforms of vecn<T, N>, and the exact integer tables of
+// the rotations and reflections that map the axes onto each other, e.g. the 24
+// orientations of a 3D point cloud:
+//
+//   for (const mat<int, 3>& r : rotations<int, 3>()) {
+//     vec3<int> q{r * p};
+//   }
+//
+// Products round every step to T like the ndvec operators, so integer transforms are
+// exact as long as they do not overflow.
+namespace ndvec {
+
+template <typename T, std::size_t N>
+  requires(N > 0)
+class mat {
+public:
+  using value_type = T;
+  using vec_type = vecn<T, N>;
+  using row_type = std::array<T, N>;
+  using rows_type = std::array<row_type, N>;
+  using axes_indices = std::make_index_sequence<N>;
+
+  static constexpr std::size_t ndim{N};
+
+private:
+  rows_type data{};
+
+  template <std::size_t row>
+  [[nodiscard]] constexpr T row_dot(const vec_type& v) const noexcept {
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) -> T {
+      return (... + static_cast<T>(std::get<axes>(data[row]) * v.template get<axes>()));
+    }(axes_indices{});
+  }
+
+public:
+  // the zero matrix
+  constexpr mat() = default;
+
+  // e.g. mat<int, 2>({{{0, -1}, {1, 0}}}), a quarter turn counterclockwise
+  constexpr explicit mat(const rows_type& rows) : data{rows} {}
+
+  [[nodiscard]] static constexpr mat identity() noexcept {
+    mat m;
+    for (std::size_t i{}; i < N; ++i) {
+      m.data[i][i] = T{1};
+    }
+    return m;
+  }
+
+  [[nodiscard]] constexpr const rows_type& rows() const noexcept { return data; }
+
+  [[nodiscard]] constexpr T& operator()(std::size_t row, std::size_t col) noexcept {
+    return data[row][col];
+  }
+
+  [[nodiscard]] constexpr const T&
+  operator()(std::size_t row, std::size_t col) const noexcept {
+    return data[row][col];
+  }
+
+  [[nodiscard]] constexpr mat transpose() const noexcept {
+    mat t;
+    for (std::size_t i{}; i < N; ++i) {
+      for (std::size_t j{}; j < N; ++j) {
+        t.data[j][i] = data[i][j];
+      }
+    }
+    return t;
+  }
+
+  // Laplace expansion along the first row, exact for integers.
+  [[nodiscard]] constexpr T determinant() const noexcept {
+    if constexpr (N == 1) {
+      return data[0][0];
+    } else {
+      T det{};
+      for (std::size_t col{}; col < N; ++col) {
+        mat<T, N - 1> minor;
+        for (std::size_t i{1}; i < N; ++i) {
+          for (std::size_t j{}, k{}; j < N; ++j) {
+            if (j != col) {
+              minor(i - 1, k++) = data[i][j];
+            }
+          }
+        }
+        const auto term{static_cast<T>(data[0][col] * minor.determinant())};
+        det = static_cast<T>(col % 2 == 0 ? det + term : det - term);
+      }
+      return det;
+    }
+  }
+
+  // One dot product per row, unrolled over the axes.
+  [[nodiscard]] constexpr vec_type operator*(const vec_type& v) const noexcept {
+    return [&]<std::size_t... rows>(std::index_sequence<rows...>) {
+      return vec_type(row_dot<rows>(v)...);
+    }(axes_indices{});
+  }
+
+  [[nodiscard]] constexpr mat operator*(const mat& rhs) const noexcept {
+    mat res;
+    for (std::size_t i{}; i < N; ++i) {
+      for (std::size_t j{}; j < N; ++j) {
+        for (std::size_t k{}; k < N; ++k) {
+          res.data[i][k] = static_cast<T>(res.data[i][k] + data[i][j] * rhs.data[j][k]);
+        }
+      }
+    }
+    return res;
+  }
+
+  [[nodiscard]] constexpr bool operator==(const mat&) const noexcept = default;
+  [[nodiscard]] constexpr auto operator<=>(const mat&) const noexcept = default;
+};
+
+// v -> linear * v + translation
+template <typename T, std::size_t N> struct affine {
+  using value_type = T;
+  using vec_type = vecn<T, N>;
+
+  static constexpr std::size_t ndim{N};
+
+  mat<T, N> linear{mat<T, N>::identity()};
+  vec_type translation{};
+
+  [[nodiscard]] constexpr vec_type operator()(const vec_type& v) const noexcept {
+    return linear * v + translation;
+  }
+
+  // The transform that applies rhs first, (a * b)(v) == a(b(v)).
+  [[nodiscard]] constexpr affine operator*(const affine& rhs) const noexcept {
+    return {linear * rhs.linear, linear * rhs.translation + translation};
+  }
+
+  [[nodiscard]] constexpr bool operator==(const affine&) const noexcept = default;
+};
+
+// Counterclockwise rotation by quarter_turns times 90 degrees, e.g. quarter_turn<int>(-1)
+// is a right turn when the y axis points up.
+template <typename T>
+  requires std::is_signed_v<T>
+[[nodiscard]] constexpr mat<T, 2> quarter_turn(int quarter_turns) noexcept {
+  constexpr std::array<T, 4> sin{0, 1, 0, -1};
+  const auto turn{static_cast<std::size_t>(((quarter_turns % 4) + 4) % 4)};
+  const T s{sin[turn]};
+  const T c{sin[(turn + 1) % 4]};
+  return mat<T, 2>({{{c, static_cast<T>(-s)}, {s, c}}});
+}
+
+namespace detail {
+
+template <std::size_t N> consteval std::size_t signed_permutation_count() {
+  std::size_t n{1};
+  for (std::size_t i{1}; i <= N; ++i) {
+    n *= 2 * i;
+  }
+  return n;
+}
+
+// All matrices with one 1 or -1 in every row and column, sorted in decreasing order so
+// that the identity comes first.
+template <typename T, std::size_t N> consteval auto make_signed_permutations() {
+  std::array<mat<T, N>, signed_permutation_count<N>()> res{};
+  std::array<std::size_t, N> perm{};
+  for (std::size_t i{}; i < N; ++i) {
+    perm[i] = i;
+  }
+  std::size_t n{};
+  do {
+    for (std::size_t signs{}; signs < (std::size_t{1} << N); ++signs) {
+      for (std::size_t row{}; row < N; ++row) {
+        res[n](row, perm[row]) = ((signs >> row) & 1) != 0 ? T{-1} : T{1};
+      }
+      ++n;
+    }
+  } while (std::next_permutation(perm.begin(), perm.end()));
+  std::sort(res.begin(), res.end(), std::greater{});
+  return res;
+}
+
+template <typename T, std::size_t N> consteval auto make_rotations() {
+  constexpr auto all{make_signed_permutations<T, N>()};
+  std::array<mat<T, N>, all.size() / 2> res{};
+  std::copy_if(all.begin(), all.end(), res.begin(), [](const mat<T, N>& m) {
+    return m.determinant() == T{1};
+  });
+  return res;
+}
+
+template <typename T, std::size_t N>
+inline constexpr auto signed_permutations{make_signed_permutations<T, N>()};
+
+template <typename T, std::size_t N>
+inline constexpr auto rotations{make_rotations<T, N>()};
+
+} // namespace detail
+
+// The N! * 2^N rotations and reflections that map the axes onto the axes, e.g. 8 in 2D
+// and 48 in 3D, identity first.
+template <typename T, std::size_t N>
+  requires(std::is_signed_v<T> and N > 0)
+[[nodiscard]] consteval auto signed_permutations() {
+  return detail::signed_permutations<T, N>;
+}
+
+// The signed permutations with determinant 1, e.g. the 4 quarter turns in 2D and the 24
+// orientations in 3D, identity first.
+template <typename T, std::size_t N>
+  requires(std::is_signed_v<T> and N > 0)
+[[nodiscard]] consteval auto rotations() {
+  return detail::rotations<T, N>;
+}
+
+} // namespace ndvec
+
+template <std::formattable<char> T, std::size_t N>
+struct std::formatter<ndvec::mat<T, N>, char> {
+  template <typename ParseContext> constexpr auto parse(ParseContext& ctx) {
+    return ctx.begin();
+  }
+
+  template <typename FormatContext>
+  auto format(const ndvec::mat<T, N>& m, FormatContext& ctx) const {
+    return std::format_to(ctx.out(), "mat{}{}", N, m.rows());
+  }
+};
+
+#endif // NDVEC_MAT_HEADER_INCLUDED
@@ -0,0 +1,76 @@
+#ifndef NDVEC_METRIC_HEADER_INCLUDED
+#define NDVEC_METRIC_HEADER_INCLUDED
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <utility>
+
+#include "ndvec.hpp"
+
+namespace ndvec {
+
+// Distance functions for spatial queries. Each metric folds per-axis distances with
+// combine, and axis_distance(d) is a lower bound for the distance to any point that is d
+// away along one axis, which is what spatial indices use to prune the search.
+namespace metric {
+
+struct manhattan {
+  template <typename T> static constexpr T axis_distance(T abs_diff) noexcept {
+    return abs_diff;
+  }
+  template <typename T> static constexpr T combine(T lhs, T rhs) noexcept {
+    return lhs + rhs;
+  }
+};
+
+struct squared_euclidean {
+  template <typename T> static constexpr T axis_distance(T abs_diff) noexcept {
+    return abs_diff * abs_diff;
+  }
+  template <typename T> static constexpr T combine(T lhs, T rhs) noexcept {
+    return lhs + rhs;
+  }
+};
+
+struct chebyshev {
+  template <typename T> static constexpr T axis_distance(T abs_diff) noexcept {
+    return abs_diff;
+  }
+  template <typename T> static constexpr T combine(T lhs, T rhs) noexcept {
+    return std::max(lhs, rhs);
+  }
+};
+
+template <typename Metric>
+concept axis_metric = requires(int d) {
+  { Metric::axis_distance(d) } -> std::same_as<int>;
+  { Metric::combine(d, d) } -> std::same_as<int>;
+};
+
+template <axis_metric Metric, typename... Ts>
+[[nodiscard]] constexpr auto
+distance(const ndvec<Ts...>& lhs, const ndvec<Ts...>& rhs) noexcept {
+  return [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+    using T = ndvec<Ts...>::value_type;
+    T res{};
+    (
+        (res = Metric::combine(
+             res,
+             Metric::axis_distance(
+                 lhs.template get<axes>() < rhs.template get<axes>()
+                     ? static_cast<T>(rhs.template get<axes>() - lhs.template get<axes>())
+                     : static_cast<T>(lhs.template get<axes>() - rhs.template get<axes>())
+             )
+         )),
+        ...
+    );
+    return res;
+  }(typename ndvec<Ts...>::axes_indices{});
+}
+
+} // namespace metric
+
+} // namespace ndvec
+
+#endif // NDVEC_METRIC_HEADER_INCLUDED
@@ -2,7 +2,10 @@
 #define NDVEC_HEADER_INCLUDED
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <concepts>
+#include <cstdint>
 #include <format>
 #include <functional>
 #include <iostream>
@@ -11,8 +14,66 @@
 #include <type_traits>
 #include <utility>
 
+// With NDVEC_INSTRUMENT defined, the operations below count themselves in the counters of
+// instrument.hpp. Otherwise NDVEC_COUNT expands to nothing and the operations compile to
+// the same code as without it.
+#ifdef NDVEC_INSTRUMENT
+#include "instrument.hpp"
+#define NDVEC_COUNT(counter) ::ndvec::instrument::count(::ndvec::instrument::op::counter)
+#else
+#define NDVEC_COUNT(counter)
+#endif
+
 namespace ndvec {
 
+// Alignment of an ndvec with ndim values of type T. Specialize it to over-align the
+// ndvec type, e.g. to 16 for vec3<float>, which pads it to 16 bytes so that no vec in an
+// array straddles a 16-byte boundary. The specialization must be declared before any use
+// of the ndvec type, or the primary template is used silently, and every translation
+// unit of a program must see the same specialization, because a vec of a different
+// layout in another unit breaks the one definition rule without a diagnostic. Put it in
+// a header that is included right after ndvec.hpp everywhere.
+template <typename T, std::size_t ndim>
+struct storage_alignment : std::integral_constant<std::size_t, alignof(T)> {};
+
+namespace detail {
+
+// a * b rounded to T. Unsigned types narrower than int are promoted to int, where e.g.
+// 65535 * 65535 overflows, so they are multiplied as unsigned int instead.
+template <typename T> [[nodiscard]] constexpr T wrapping_mul(T a, T b) noexcept {
+  if constexpr (std::unsigned_integral<T> and sizeof(T) < sizeof(unsigned)) {
+    return static_cast<T>(static_cast<unsigned>(a) * static_cast<unsigned>(b));
+  } else {
+    return static_cast<T>(a * b);
+  }
+}
+
+// std::multiplies with the rounding of wrapping_mul, for the eager and lazy operator*.
+struct wrapping_multiplies {
+  template <typename T> [[nodiscard]] constexpr T operator()(T a, T b) const noexcept {
+    return wrapping_mul(a, b);
+  }
+};
+
+// murmur3 fmix64 finalizer, a bijection that spreads each input bit over the word. Used
+// by std::hash<ndvec> and zobrist_key.
+[[nodiscard]] constexpr std::uint64_t fmix64(std::uint64_t h) noexcept {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccd;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53;
+  h ^= h >> 33;
+  return h;
+}
+
+// |a - b| rounded to T like abs(a - b), so for unsigned T it is a - b modulo 2^n.
+template <typename T> [[nodiscard]] constexpr T wrapping_abs_diff(T a, T b) noexcept {
+  const auto d{static_cast<T>(a - b)};
+  return static_cast<T>(d < 0 ? -d : d);
+}
+
+} // namespace detail
+
 template <typename T, std::same_as<T>... Ts>
   requires(std::regular<T> and std::is_arithmetic_v<T>)
 class ndvec {
@@ -23,13 +84,17 @@ public:
   using values_type = std::tuple<T, Ts...>;
   using axes_indices = std::make_index_sequence<ndim>;
 
+  static constexpr std::size_t alignment{storage_alignment<T, ndim>::value};
+  static_assert(std::has_single_bit(alignment) and alignment >= alignof(T));
+
 private:
-  values_type data{};
+  // contiguous values, so that the folds over the axes compile to SIMD instructions
+  alignas(alignment) std::array<T, ndim> data{};
 
 public:
   constexpr ndvec() = default;
 
-  constexpr explicit ndvec(value_type x, Ts... rest) : data(x, rest...) {}
+  constexpr explicit ndvec(value_type x, Ts... rest) : data{x, rest...} {}
 
   template <std::size_t axis>
     requires(axis < ndim)
@@ -43,7 +108,9 @@ public:
     return std::get<axis>(data);
   }
 
-  constexpr const values_type& values() const noexcept { return data; }
+  constexpr values_type values() const noexcept {
+    return std::apply([](auto... vs) { return values_type{vs...}; }, data);
+  }
 
 private:
   template <std::size_t axis, typename Fn, typename... Args>
@@ -71,35 +138,45 @@ public:
   }
 
   constexpr ndvec& operator+=(const ndvec& rhs) noexcept {
+    NDVEC_COUNT(arithmetic);
     return apply(std::plus<value_type>{}, rhs);
   }
   constexpr ndvec& operator-=(const ndvec& rhs) noexcept {
+    NDVEC_COUNT(arithmetic);
     return apply(std::minus<value_type>{}, rhs);
   }
   constexpr ndvec& operator*=(const ndvec& rhs) noexcept {
-    return apply(std::multiplies<value_type>{}, rhs);
+    NDVEC_COUNT(arithmetic);
+    return apply(detail::wrapping_multiplies{}, rhs);
   }
   constexpr ndvec& operator/=(const ndvec& rhs) noexcept {
+    NDVEC_COUNT(arithmetic);
     return apply(std::divides<value_type>{}, rhs);
   }
 
   [[nodiscard]] constexpr ndvec operator+(const ndvec& rhs) const noexcept {
+    NDVEC_COUNT(temporary);
     ndvec lhs{*this};
     return lhs += rhs;
   }
   [[nodiscard]] constexpr ndvec operator-(const ndvec& rhs) const noexcept {
+    NDVEC_COUNT(temporary);
     ndvec lhs{*this};
     return lhs -= rhs;
   }
   [[nodiscard]] constexpr ndvec operator*(const ndvec& rhs) const noexcept {
+    NDVEC_COUNT(temporary);
     ndvec lhs{*this};
     return lhs *= rhs;
   }
   [[nodiscard]] constexpr ndvec operator/(const ndvec& rhs) const noexcept {
+    NDVEC_COUNT(temporary);
     ndvec lhs{*this};
     return lhs /= rhs;
   }
   [[nodiscard]] constexpr ndvec min(const ndvec& rhs) const noexcept {
+    NDVEC_COUNT(arithmetic);
+    NDVEC_COUNT(temporary);
     ndvec lhs{*this};
     return lhs.apply(
         [](value_type a, value_type b) constexpr noexcept -> value_type {
@@ -109,6 +186,8 @@ public:
     );
   }
   [[nodiscard]] constexpr ndvec max(const ndvec& rhs) const noexcept {
+    NDVEC_COUNT(arithmetic);
+    NDVEC_COUNT(temporary);
     ndvec lhs{*this};
     return lhs.apply(
         [](value_type a, value_type b) constexpr noexcept -> value_type {
@@ -119,6 +198,8 @@ public:
   }
 
   [[nodiscard]] constexpr ndvec abs() const noexcept {
+    NDVEC_COUNT(arithmetic);
+    NDVEC_COUNT(temporary);
     ndvec res{*this};
     return res.apply([](value_type val) constexpr noexcept -> value_type {
       // TODO
@@ -128,6 +209,8 @@ public:
   }
 
   [[nodiscard]] constexpr ndvec signum() const noexcept {
+    NDVEC_COUNT(arithmetic);
+    NDVEC_COUNT(temporary);
     ndvec res{*this};
     return res.apply([](value_type val) constexpr noexcept -> value_type {
       return (value_type{} < val) - (val < value_type{});
@@ -135,6 +218,7 @@ public:
   }
 
   [[nodiscard]] constexpr value_type sum() const noexcept {
+    NDVEC_COUNT(reduction);
     return std::apply(
         [](std::same_as<value_type> auto... vs) constexpr noexcept -> value_type {
           return (... + vs);
@@ -144,6 +228,7 @@ public:
   }
 
   [[nodiscard]] constexpr value_type prod() const noexcept {
+    NDVEC_COUNT(reduction);
     return std::apply(
         [](std::same_as<value_type> auto... vs) constexpr noexcept -> value_type {
           return (... * vs);
@@ -153,6 +238,7 @@ public:
   }
 
   [[nodiscard]] constexpr value_type min() const noexcept {
+    NDVEC_COUNT(reduction);
     return std::apply(
         [](std::same_as<value_type> auto... vs) constexpr noexcept -> value_type {
           return std::min(std::initializer_list<value_type>{vs...});
@@ -162,6 +248,7 @@ public:
   }
 
   [[nodiscard]] constexpr value_type max() const noexcept {
+    NDVEC_COUNT(reduction);
     return std::apply(
         [](std::same_as<value_type> auto... vs) constexpr noexcept -> value_type {
           return std::max(std::initializer_list<value_type>{vs...});
@@ -172,12 +259,20 @@ public:
 
   [[nodiscard]] constexpr auto operator<=>(const ndvec&) const noexcept = default;
 
+  // distance and dot fold over the axes without the intermediate ndvec of the
+  // differences or products, and round every step to value_type like the operators
   [[nodiscard]] constexpr value_type distance(const ndvec& rhs) const noexcept {
-    return (*this - rhs).abs().sum();
+    NDVEC_COUNT(reduction);
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) -> value_type {
+      return (... + detail::wrapping_abs_diff(get<axes>(), rhs.template get<axes>()));
+    }(axes_indices{});
   }
 
   [[nodiscard]] constexpr value_type dot(const ndvec& rhs) const noexcept {
-    return (*this * rhs).sum();
+    NDVEC_COUNT(reduction);
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) -> value_type {
+      return (... + detail::wrapping_mul(get<axes>(), rhs.template get<axes>()));
+    }(axes_indices{});
   }
 
   constexpr void swap(ndvec& other) noexcept { data.swap(other.data); }
@@ -190,6 +285,8 @@ public:
   constexpr ndvec cross(const ndvec& rhs) const noexcept
     requires(ndim == 3)
   {
+    NDVEC_COUNT(arithmetic);
+    NDVEC_COUNT(temporary);
     return ndvec(
         y() * rhs.z() - z() * rhs.y(),
         z() * rhs.x() - x() * rhs.z(),
@@ -200,6 +297,7 @@ public:
   constexpr ndvec& rotate_left() noexcept
     requires(ndim == 2)
   {
+    NDVEC_COUNT(arithmetic);
     x() = std::exchange(y(), -x());
     return *this;
   }
@@ -207,6 +305,7 @@ public:
   constexpr ndvec& rotate_right() noexcept
     requires(ndim == 2)
   {
+    NDVEC_COUNT(arithmetic);
     x() = -std::exchange(y(), x());
     return *this;
   }
@@ -241,22 +340,65 @@ template <typename T> using vec2 = ndvec<T, T>;
 template <typename T> using vec3 = ndvec<T, T, T>;
 template <typename T> using vec4 = ndvec<T, T, T, T>;
 
+namespace detail {
+template <typename T, typename axes> struct vecn_impl;
+template <typename T, std::size_t... axes>
+struct vecn_impl<T, std::index_sequence<axes...>> {
+  template <std::size_t> using axis_type = T;
+  using type = ndvec<axis_type<axes>...>;
+};
+} // namespace detail
+
+template <typename T, std::size_t n>
+  requires(n > 0)
+using vecn = detail::vecn_impl<T, std::make_index_sequence<n>>::type;
+
 } // namespace ndvec
 
+// structured bindings, e.g. auto [x, y] = vec2<int>(1, 2)
+template <typename... Ts>
+struct std::tuple_size<ndvec::ndvec<Ts...>>
+    : std::integral_constant<std::size_t, sizeof...(Ts)> {};
+
+template <std::size_t axis, typename... Ts>
+struct std::tuple_element<axis, ndvec::ndvec<Ts...>> {
+  using type = ndvec::ndvec<Ts...>::value_type;
+};
+
 template <std::integral... Ts> struct std::hash<ndvec::ndvec<Ts...>> {
 private:
   using vec = ndvec::ndvec<Ts...>;
   using axes = vec::axes_indices;
   using T = vec::value_type;
-  static constexpr auto slot_width{std::numeric_limits<std::size_t>::digits / vec::ndim};
+  using U = std::make_unsigned_t<
+      std::conditional_t<std::same_as<T, bool>, unsigned char, T>>;
+  static constexpr auto axis_width{std::numeric_limits<U>::digits};
 
   template <std::size_t... axes>
-  constexpr auto hash_impl(const vec& v, std::index_sequence<axes...>) const noexcept {
-    return (... ^ (std::hash<T>{}(v.template get<axes>()) << (slot_width * axes)));
+  static constexpr std::uint64_t
+  hash_impl(const vec& v, std::index_sequence<axes...>) noexcept {
+    if constexpr (axis_width * vec::ndim <= 64) {
+      // all axes fit in one word, so distinct vectors never collide before truncation
+      return ndvec::detail::fmix64(
+          (...
+           | (std::uint64_t{static_cast<U>(v.template get<axes>())}
+              << (axis_width * axes)))
+      );
+    } else {
+      std::uint64_t h{};
+      ((h = ndvec::detail::fmix64(
+            h * 0x9e3779b97f4a7c15 + static_cast<U>(v.template get<axes>())
+        )),
+       ...);
+      return h;
+    }
   }
 
 public:
-  constexpr auto operator()(const vec& v) const noexcept { return hash_impl(v, axes{}); }
+  constexpr std::size_t operator()(const vec& v) const noexcept {
+    NDVEC_COUNT(hash);
+    return static_cast<std::size_t>(hash_impl(v, axes{}));
+  }
 };
 
 template <std::formattable<char>... Ts> struct std::formatter<ndvec::ndvec<Ts...>, char> {
@@ -269,6 +411,7 @@ public:
   }
 
   template <typename FormatContext> auto format(const vec& v, FormatContext& ctx) const {
+    NDVEC_COUNT(format);
     return std::format_to(ctx.out(), "ndvec{}{}", vec::ndim, v.values());
   }
 };
@@ -277,6 +420,7 @@ template <typename... Ts>
 std::istream& operator>>(std::istream& is, ndvec::ndvec<Ts...>& v) {
   using vec = ndvec::ndvec<Ts...>;
   using axes = vec::axes_indices;
+  NDVEC_COUNT(parse);
   if (vec parsed;
       [&]<std::size_t... axis>(std::index_sequence<axis...>) -> std::istream& {
         return (is >> ... >> parsed.template get<axis>());
@@ -0,0 +1,151 @@
+#ifndef NDVEC_NEIGHBORHOOD_HEADER_INCLUDED
+#define NDVEC_NEIGHBORHOOD_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "ndvec.hpp"
+
+// Neighbourhoods of any radius in any number of dimensions, as tables of offsets that are
+// generated at compile time, e.g. the 80 cells around a cell of a 4D grid:
+//
+//   for (const vec4<int>& p : neighbors<neighborhood::moore>(center)) { ... }
+//
+// neighbors() adds every offset to the center in one unrolled expression, so there is
+// no loop over the axes and no check that skips the center. The offsets are sorted
+// lexicographically, axis 0 first, as signed integers.
+namespace ndvec {
+
+enum class neighborhood {
+  // the cells at a Chebyshev distance of at most radius, e.g. the 8 cells around the
+  // center in 2D
+  moore,
+  // the cells at a Manhattan distance of at most radius, e.g. the 4 cells sharing an
+  // edge with the center in 2D
+  von_neumann,
+  // the cells at a Manhattan distance of exactly radius, the same as von_neumann for a
+  // radius of 1
+  l1_shell,
+};
+
+namespace detail {
+
+template <typename Vec>
+concept neighborhood_vec = requires {
+  typename Vec::value_type;
+  requires std::same_as<Vec, vecn<typename Vec::value_type, Vec::ndim>>;
+  requires not std::same_as<typename Vec::value_type, bool>;
+};
+
+template <neighborhood kind, std::size_t ndim, std::size_t radius>
+constexpr bool in_neighborhood(const std::array<int, ndim>& d) {
+  int l1{};
+  int linf{};
+  for (int v : d) {
+    l1 += v < 0 ? -v : v;
+    linf = std::max(linf, v < 0 ? -v : v);
+  }
+  switch (kind) {
+    case neighborhood::moore:
+      return linf > 0;
+    case neighborhood::von_neumann:
+      return l1 > 0 and l1 <= static_cast<int>(radius);
+    case neighborhood::l1_shell:
+      return l1 == static_cast<int>(radius);
+  }
+  return false;
+}
+
+// Offset i of the cube [-radius, radius]^ndim, axis 0 slowest.
+template <std::size_t ndim, std::size_t radius>
+constexpr std::array<int, ndim> cube_offset(std::size_t i) {
+  constexpr std::size_t side{2 * radius + 1};
+  std::array<int, ndim> d{};
+  for (std::size_t axis{ndim}; axis-- > 0; i /= side) {
+    d[axis] = static_cast<int>(i % side) - static_cast<int>(radius);
+  }
+  return d;
+}
+
+template <neighborhood kind, std::size_t ndim, std::size_t radius>
+consteval auto int_offsets() {
+  constexpr std::size_t cube{[] {
+    std::size_t n{1};
+    for (std::size_t axis{}; axis < ndim; ++axis) {
+      n *= 2 * radius + 1;
+    }
+    return n;
+  }()};
+  constexpr std::size_t count{[] {
+    std::size_t n{};
+    for (std::size_t i{}; i < cube; ++i) {
+      n += in_neighborhood<kind, ndim, radius>(cube_offset<ndim, radius>(i));
+    }
+    return n;
+  }()};
+  std::array<std::array<int, ndim>, count> offsets{};
+  for (std::size_t i{}, n{}; i < cube; ++i) {
+    const auto d{cube_offset<ndim, radius>(i)};
+    if (in_neighborhood<kind, ndim, radius>(d)) {
+      offsets[n++] = d;
+    }
+  }
+  return offsets;
+}
+
+template <neighborhood_vec Vec, neighborhood kind, std::size_t radius>
+consteval auto make_offsets() {
+  using T = Vec::value_type;
+  constexpr auto ints{int_offsets<kind, Vec::ndim, radius>()};
+  std::array<Vec, ints.size()> offsets{};
+  for (std::size_t i{}; i < ints.size(); ++i) {
+    offsets[i] = [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      return Vec(static_cast<T>(ints[i][axes])...);
+    }(typename Vec::axes_indices{});
+  }
+  return offsets;
+}
+
+template <neighborhood_vec Vec, neighborhood kind, std::size_t radius>
+inline constexpr auto offsets{make_offsets<Vec, kind, radius>()};
+
+} // namespace detail
+
+// Offsets of the cells at a Manhattan distance of at most radius, without the center.
+template <detail::neighborhood_vec Vec, std::size_t radius = 1>
+  requires(radius > 0)
+[[nodiscard]] consteval auto von_neumann_offsets() {
+  return detail::offsets<Vec, neighborhood::von_neumann, radius>;
+}
+
+// Offsets of the cells at a Chebyshev distance of at most radius, without the center.
+template <detail::neighborhood_vec Vec, std::size_t radius = 1>
+  requires(radius > 0)
+[[nodiscard]] consteval auto moore_offsets() {
+  return detail::offsets<Vec, neighborhood::moore, radius>;
+}
+
+// Offsets of the cells at a Manhattan distance of exactly radius.
+template <detail::neighborhood_vec Vec, std::size_t radius = 1>
+  requires(radius > 0)
+[[nodiscard]] consteval auto l1_shell_offsets() {
+  return detail::offsets<Vec, neighborhood::l1_shell, radius>;
+}
+
+// All neighbours of p, in the order of the offsets.
+template <neighborhood kind, std::size_t radius = 1, detail::neighborhood_vec Vec>
+  requires(radius > 0)
+[[nodiscard]] constexpr auto neighbors(const Vec& p) noexcept {
+  constexpr auto& table{detail::offsets<Vec, kind, radius>};
+  return [&]<std::size_t... i>(std::index_sequence<i...>) {
+    return std::array<Vec, table.size()>{(p + table[i])...};
+  }(std::make_index_sequence<table.size()>{});
+}
+
+} // namespace ndvec
+
+#endif // NDVEC_NEIGHBORHOOD_HEADER_INCLUDED
@@ -0,0 +1,212 @@
+#ifndef NDVEC_PACKED_VEC_HEADER_INCLUDED
+#define NDVEC_PACKED_VEC_HEADER_INCLUDED
+
+#include <array>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "ndvec.hpp"
+
+namespace ndvec {
+
+// Vector of small signed integers packed into one 32 or 64-bit word, for hash set keys
+// and other large collections of points in a small box. Every axis is a lane of
+// axis_bits value bits and one guard bit above them, axis 0 in the highest lane. The
+// values are stored with a bias of 2^(axis_bits - 1), so the lanes are unsigned and the
+// word compares like the ndvec, and the arithmetic works on all lanes at once
+// (SIMD within a register): carries and borrows stop at the guard bits, which are always
+// zero between operations. Like the ndvec operators, results wrap around within
+// [min_value, max_value].
+template <std::size_t axis_bits, std::size_t dims>
+  requires(axis_bits > 0 and dims > 0 and (axis_bits + 1) * dims <= 64)
+class packed_vec {
+public:
+  static constexpr std::size_t ndim{dims};
+  static constexpr std::size_t bits{axis_bits};
+
+  using word_type = std::
+      conditional_t<(axis_bits + 1) * dims <= 32, std::uint32_t, std::uint64_t>;
+  // 32-bit lanes hold [-2^31, 2^31 - 1], whose bounds are computed from 2^31
+  using value_type = std::conditional_t<axis_bits < 32, std::int32_t, std::int64_t>;
+  using axes_indices = std::make_index_sequence<ndim>;
+
+  static constexpr value_type min_value{-(value_type{1} << (bits - 1))};
+  static constexpr value_type max_value{(value_type{1} << (bits - 1)) - 1};
+
+private:
+  static constexpr std::size_t lane_width{bits + 1};
+  static constexpr word_type lane_mask{(word_type{1} << bits) - 1};
+
+  static constexpr word_type lane_ones{[] {
+    word_type w{};
+    for (std::size_t lane{}; lane < ndim; ++lane) {
+      w |= word_type{1} << (lane * lane_width);
+    }
+    return w;
+  }()};
+  static constexpr word_type guards{lane_ones << bits};
+  static constexpr word_type bias{lane_ones << (bits - 1)};
+
+  template <std::size_t axis>
+  static constexpr std::size_t shift{(ndim - 1 - axis) * lane_width};
+
+  word_type data{bias};
+
+  static constexpr packed_vec from_word_unchecked(word_type w) noexcept {
+    packed_vec v;
+    v.data = w;
+    return v;
+  }
+
+  template <typename T>
+  static constexpr word_type pack_axis(T value, std::size_t offset) {
+    if (std::cmp_less(value, min_value) or std::cmp_greater(value, max_value)) {
+      throw std::out_of_range(
+          std::format("packed_vec axis {} outside [{}, {}]", value, min_value, max_value)
+      );
+    }
+    return static_cast<word_type>(static_cast<word_type>(value - min_value) << offset);
+  }
+
+  // Lanes where lhs >= rhs have all value bits set, the other lanes are zero.
+  static constexpr word_type greater_equal_mask(word_type lhs, word_type rhs) noexcept {
+    const word_type ge{((lhs | guards) - rhs) & guards};
+    return ge - (ge >> bits);
+  }
+
+public:
+  // the zero vector
+  constexpr packed_vec() = default;
+
+  // Throws std::out_of_range if a value is outside [min_value, max_value].
+  template <std::integral... Ts>
+    requires(sizeof...(Ts) == ndim)
+  constexpr explicit packed_vec(Ts... values) : data{} {
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      data = (... | pack_axis(values, shift<axes>));
+    }(axes_indices{});
+  }
+
+  template <std::integral T, typename... Ts>
+    requires(sizeof...(Ts) + 1 == ndim)
+  constexpr explicit packed_vec(const ndvec<T, Ts...>& v)
+      : packed_vec(std::make_from_tuple<packed_vec>(v.values())) {}
+
+  template <std::integral T, typename... Ts>
+    requires(sizeof...(Ts) + 1 == ndim)
+  [[nodiscard]] static constexpr bool representable(const ndvec<T, Ts...>& v) noexcept {
+    return std::apply(
+        [](auto... vs) {
+          return (... and (std::cmp_greater_equal(vs, min_value)
+                           and std::cmp_less_equal(vs, max_value)));
+        },
+        v.values()
+    );
+  }
+
+  // Throws std::invalid_argument if a guard bit or a bit above the lanes is set.
+  [[nodiscard]] static constexpr packed_vec from_word(word_type w) {
+    if ((w & ~(lane_ones * lane_mask)) != 0) {
+      throw std::invalid_argument(std::format("invalid packed_vec word {:#x}", w));
+    }
+    return from_word_unchecked(w);
+  }
+
+  [[nodiscard]] constexpr word_type word() const noexcept { return data; }
+
+  template <std::size_t axis>
+    requires(axis < ndim)
+  [[nodiscard]] constexpr value_type get() const noexcept {
+    return static_cast<value_type>(
+        static_cast<value_type>((data >> shift<axis>) & lane_mask) + min_value
+    );
+  }
+
+  template <std::integral T = value_type>
+  [[nodiscard]] constexpr vecn<T, ndim> unpack() const noexcept {
+    return [this]<std::size_t... axes>(std::index_sequence<axes...>) {
+      return vecn<T, ndim>(static_cast<T>(get<axes>())...);
+    }(axes_indices{});
+  }
+
+  // (x + y + 2 bias) - bias per lane, with the guard bits set before the subtraction so
+  // that it cannot borrow from the next lane
+  [[nodiscard]] constexpr packed_vec operator+(const packed_vec& rhs) const noexcept {
+    return from_word_unchecked((((data + rhs.data) | guards) - bias) & ~guards);
+  }
+
+  // (x - y) + bias per lane
+  [[nodiscard]] constexpr packed_vec operator-(const packed_vec& rhs) const noexcept {
+    const word_type diff{((data | guards) - rhs.data) & ~guards};
+    return from_word_unchecked((diff + bias) & ~guards);
+  }
+
+  constexpr packed_vec& operator+=(const packed_vec& rhs) noexcept {
+    return *this = *this + rhs;
+  }
+
+  constexpr packed_vec& operator-=(const packed_vec& rhs) noexcept {
+    return *this = *this - rhs;
+  }
+
+  [[nodiscard]] constexpr packed_vec min(const packed_vec& rhs) const noexcept {
+    const word_type ge{greater_equal_mask(data, rhs.data)};
+    return from_word_unchecked((rhs.data & ge) | (data & ~ge));
+  }
+
+  [[nodiscard]] constexpr packed_vec max(const packed_vec& rhs) const noexcept {
+    const word_type ge{greater_equal_mask(data, rhs.data)};
+    return from_word_unchecked((data & ge) | (rhs.data & ~ge));
+  }
+
+  // one integer comparison, lexicographic over the axes like ndvec
+  [[nodiscard]] constexpr bool operator==(const packed_vec&) const noexcept = default;
+  [[nodiscard]] constexpr auto operator<=>(const packed_vec&) const noexcept = default;
+
+  // The 2 * ndim axis-aligned neighbours in increasing order, the same as
+  // ndvec::adjacent() in 3D.
+  [[nodiscard]] constexpr std::array<packed_vec, 2 * ndim> adjacent() const noexcept {
+    return [this]<std::size_t... axes>(std::index_sequence<axes...>) {
+      auto unit{[](std::size_t axis) {
+        const std::size_t lane{ndim - 1 - axis};
+        return from_word_unchecked(bias + (word_type{1} << (lane * lane_width)));
+      }};
+      return std::array<packed_vec, 2 * ndim>{
+          *this - unit(axes)...,
+          *this + unit(ndim - 1 - axes)...,
+      };
+    }(axes_indices{});
+  }
+};
+
+} // namespace ndvec
+
+// the word itself, distinct vectors never collide
+template <std::size_t bits, std::size_t ndim>
+struct std::hash<ndvec::packed_vec<bits, ndim>> {
+  constexpr std::size_t
+  operator()(const ndvec::packed_vec<bits, ndim>& v) const noexcept {
+    return static_cast<std::size_t>(v.word());
+  }
+};
+
+template <std::size_t bits, std::size_t ndim>
+struct std::formatter<ndvec::packed_vec<bits, ndim>, char> {
+  template <typename ParseContext> constexpr auto parse(ParseContext& ctx) {
+    return ctx.begin();
+  }
+
+  template <typename FormatContext>
+  auto format(const ndvec::packed_vec<bits, ndim>& v, FormatContext& ctx) const {
+    return std::format_to(ctx.out(), "packed_vec{}{}", ndim, v.unpack().values());
+  }
+};
+
+#endif // NDVEC_PACKED_VEC_HEADER_INCLUDED
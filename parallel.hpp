@@ -0,0 +1,58 @@
+#ifndef NDVEC_PARALLEL_HEADER_INCLUDED
+#define NDVEC_PARALLEL_HEADER_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Fork-join helpers on top of std::thread, used by the containers that split bulk work
+// across cores. Every call starts its own threads and joins them before returning.
+namespace ndvec::parallel {
+
+[[nodiscard]] inline std::size_t thread_count() noexcept {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Number of chunks for_each_chunk splits n elements into, so that callers can allocate
+// per-chunk state up front.
+[[nodiscard]] inline std::size_t
+chunk_count(std::size_t n, std::size_t min_chunk) noexcept {
+  const std::size_t max_chunks{n / std::max(min_chunk, std::size_t{1})};
+  return std::clamp(max_chunks, std::size_t{1}, thread_count());
+}
+
+// Calls fn(chunk, begin, end) for chunk_count(n, min_chunk) contiguous subranges of
+// [0, n), each on its own thread except the last, which runs on the calling thread. The
+// first exception thrown by any chunk is rethrown after all threads have joined.
+template <typename Fn>
+void for_each_chunk(std::size_t n, std::size_t min_chunk, Fn&& fn) {
+  const std::size_t chunks{chunk_count(n, min_chunk)};
+  std::vector<std::exception_ptr> errors(chunks);
+  auto run{[&](std::size_t chunk) {
+    try {
+      fn(chunk, n * chunk / chunks, n * (chunk + 1) / chunks);
+    } catch (...) {
+      errors[chunk] = std::current_exception();
+    }
+  }};
+  std::vector<std::thread> threads;
+  threads.reserve(chunks - 1);
+  for (std::size_t chunk{}; chunk + 1 < chunks; ++chunk) {
+    threads.emplace_back(run, chunk);
+  }
+  run(chunks - 1);
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  for (const std::exception_ptr& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+} // namespace ndvec::parallel
+
+#endif // NDVEC_PARALLEL_HEADER_INCLUDED
@@ -0,0 +1,355 @@
+#ifndef NDVEC_PARALLEL_BFS_HEADER_INCLUDED
+#define NDVEC_PARALLEL_BFS_HEADER_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "grid.hpp"
+#include "ndvec.hpp"
+#include "parallel.hpp"
+#include "search.hpp"
+
+namespace ndvec::search {
+
+enum class bfs_direction : std::uint8_t { automatic, top_down, bottom_up };
+
+struct parallel_bfs_options {
+  bfs_direction direction{bfs_direction::automatic};
+  // record the parent of every reached node, for parallel_bfs::parent
+  bool parents{false};
+};
+
+// Level-synchronous breadth-first search over the open nodes of the box
+// [origin, origin + extent), on several threads.
+//
+// Nodes are numbered by their index in a dense grid of distances. Each level, the
+// threads take blocks of the frontier from a shared cursor, claim the neighbours of
+// the frontier nodes with an atomic test-and-set on a visited bitmap and append the
+// ones they claimed to their own output frontier. The output frontiers are then copied
+// to their offsets in the next frontier, so the threads never share a queue or a lock.
+// Closed nodes are marked visited on their first check, so is_open is called at most
+// once per node.
+//
+// When the frontier holds a large part of the unexplored nodes, the search switches to
+// bottom-up levels: the threads scan blocks of the visited bitmap and every unvisited
+// node looks for a neighbour in the frontier instead. It switches back to top-down once
+// the frontier shrinks.
+//
+// The distances are the same as those of engine::bfs for any number of threads and
+// either direction. The parent of a node is the neighbour with the smallest index in the
+// distance grid that is one step closer to a start, so the parents are deterministic
+// too.
+template <searchable Vec, std::integral Dist = int> class parallel_bfs {
+public:
+  using distance_grid = grid<Dist, Vec::ndim, typename Vec::value_type>;
+  using size_type = std::size_t;
+
+  static constexpr Dist unreached{std::numeric_limits<Dist>::max()};
+
+private:
+  static constexpr size_type no_parent{std::numeric_limits<size_type>::max()};
+  static constexpr size_type frontier_block{256};
+  static constexpr size_type word_block{64};
+  static constexpr size_type min_nodes_per_thread{1 << 14};
+  // bottom-up once the frontier is more than 1/alpha of the unexplored nodes, and
+  // top-down again once it shrinks below 1/beta of all nodes
+  static constexpr size_type alpha{14};
+  static constexpr size_type beta{24};
+
+  struct alignas(64) worker_state {
+    std::vector<size_type> next{};
+    size_type offset{};
+    // nodes this worker marked visited during the level, open or not
+    size_type examined{};
+    std::exception_ptr error{};
+  };
+
+  distance_grid distances_;
+  std::vector<std::uint64_t> visited_;
+  std::vector<size_type> parents_{};
+  std::vector<size_type> frontier_{};
+  std::vector<size_type> next_frontier_{};
+  std::vector<worker_state> workers_{};
+
+  // Marks node i visited and returns true if this call did it.
+  bool claim(size_type i) noexcept {
+    std::atomic_ref<std::uint64_t> word(visited_[i / 64]);
+    const std::uint64_t bit{std::uint64_t{1} << (i % 64)};
+    return not(word.load(std::memory_order_relaxed) & bit)
+           and not(word.fetch_or(bit, std::memory_order_relaxed) & bit);
+  }
+
+  [[nodiscard]] Dist load_distance(size_type i) noexcept {
+    return std::atomic_ref<Dist>(distances_[i]).load(std::memory_order_relaxed);
+  }
+
+  void store_distance(size_type i, Dist dist) noexcept {
+    std::atomic_ref<Dist>(distances_[i]).store(dist, std::memory_order_relaxed);
+  }
+
+  template <typename Open>
+  void expand_top_down(
+      worker_state& w,
+      std::atomic<size_type>& cursor,
+      Open& is_open,
+      Dist next_dist
+  ) {
+    const size_type n{frontier_.size()};
+    while (true) {
+      const size_type b{cursor.fetch_add(frontier_block, std::memory_order_relaxed)};
+      if (b >= n) {
+        return;
+      }
+      const size_type e{std::min(b + frontier_block, n)};
+      for (size_type f{b}; f < e; ++f) {
+        for (const size_type adj : distances_.adjacent(frontier_[f])) {
+          if (claim(adj)) {
+            ++w.examined;
+            if (std::invoke(is_open, distances_.position(adj))) {
+              store_distance(adj, next_dist);
+              w.next.push_back(adj);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Every block of bitmap words belongs to one worker, so only that worker sets their
+  // bits.
+  template <typename Open>
+  void expand_bottom_up(
+      worker_state& w,
+      std::atomic<size_type>& cursor,
+      Open& is_open,
+      Dist dist
+  ) {
+    const size_type n{visited_.size()};
+    while (true) {
+      const size_type b{cursor.fetch_add(word_block, std::memory_order_relaxed)};
+      if (b >= n) {
+        return;
+      }
+      const size_type e{std::min(b + word_block, n)};
+      for (size_type word_index{b}; word_index < e; ++word_index) {
+        std::atomic_ref<std::uint64_t> word(visited_[word_index]);
+        std::uint64_t unvisited{~word.load(std::memory_order_relaxed)};
+        std::uint64_t claimed{};
+        for (; unvisited != 0; unvisited &= unvisited - 1) {
+          const auto bit{static_cast<size_type>(std::countr_zero(unvisited))};
+          const size_type i{word_index * 64 + bit};
+          for (const size_type adj : distances_.adjacent(i)) {
+            if (load_distance(adj) == dist) {
+              claimed |= std::uint64_t{1} << bit;
+              ++w.examined;
+              if (std::invoke(is_open, distances_.position(i))) {
+                store_distance(i, dist + 1);
+                w.next.push_back(i);
+              }
+              break;
+            }
+          }
+        }
+        if (claimed != 0) {
+          word.fetch_or(claimed, std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+
+  // Clears the distances and the visited bitmap, with the bits past the last node set so
+  // that bottom-up levels skip them.
+  void reset() {
+    const size_type n{distances_.size()};
+    parallel::for_each_chunk(n, min_nodes_per_thread, [&](size_type, auto b, auto e) {
+      std::fill(distances_.begin() + b, distances_.begin() + e, unreached);
+    });
+    std::ranges::fill(visited_, std::uint64_t{});
+    if (n % 64 != 0) {
+      visited_.back() = ~std::uint64_t{} << (n % 64);
+    }
+    parents_.clear();
+  }
+
+  void record_parents() {
+    const size_type n{distances_.size()};
+    parents_.assign(n, no_parent);
+    parallel::for_each_chunk(n, min_nodes_per_thread, [&](size_type, auto b, auto e) {
+      for (size_type i{b}; i < e; ++i) {
+        const Dist dist{distances_[i]};
+        if (dist == unreached or dist == 0) {
+          continue;
+        }
+        for (const size_type adj : distances_.adjacent(i)) {
+          if (distances_[adj] == dist - 1) {
+            parents_[i] = adj;
+            break;
+          }
+        }
+      }
+    });
+  }
+
+public:
+  parallel_bfs(const Vec& origin, const Vec& extent)
+      : distances_(origin, extent, unreached), visited_((distances_.size() + 63) / 64) {}
+
+  // Searches from the open starts and returns the number of nodes reached. is_open is
+  // called concurrently from several threads. If it throws, the search stops at the end
+  // of the level and the exception is rethrown.
+  template <std::predicate<const Vec&> Open>
+  size_type run(
+      std::span<const Vec> starts,
+      Open&& is_open,
+      const parallel_bfs_options& opts = {}
+  ) {
+    reset();
+    frontier_.clear();
+    size_type examined{};
+    for (const Vec& s : starts) {
+      if (not distances_.contains(s)) {
+        continue;
+      }
+      if (const size_type i{distances_.index(s)}; claim(i)) {
+        ++examined;
+        if (std::invoke(is_open, s)) {
+          distances_[i] = 0;
+          frontier_.push_back(i);
+        }
+      }
+    }
+    size_type reached{frontier_.size()};
+    if (frontier_.empty()) {
+      return 0;
+    }
+
+    const size_type total{distances_.size()};
+    workers_.resize(parallel::chunk_count(total, min_nodes_per_thread));
+    for (worker_state& w : workers_) {
+      w.next.clear();
+      w.examined = 0;
+      w.error = nullptr;
+    }
+    std::atomic<size_type> cursor{};
+    Dist dist{};
+    bool bottom_up{opts.direction == bfs_direction::bottom_up};
+    bool done{false};
+    bool copied{true};
+    // runs on one thread after every worker has expanded the level, and again after
+    // every worker has copied its output frontier
+    auto end_phase{[&]() noexcept {
+      cursor.store(0, std::memory_order_relaxed);
+      copied = not copied;
+      if (copied) {
+        frontier_.swap(next_frontier_);
+        for (worker_state& w : workers_) {
+          w.next.clear();
+        }
+        ++dist;
+        return;
+      }
+      size_type next_size{};
+      for (worker_state& w : workers_) {
+        done = done or w.error != nullptr;
+        w.offset = next_size;
+        next_size += w.next.size();
+        examined += std::exchange(w.examined, 0);
+      }
+      reached += next_size;
+      done = done or next_size == 0;
+      if (not done) {
+        try {
+          next_frontier_.resize(next_size);
+        } catch (...) {
+          workers_.front().error = std::current_exception();
+          done = true;
+        }
+      }
+      if (opts.direction == bfs_direction::automatic) {
+        if (not bottom_up and next_size * alpha > total - examined) {
+          bottom_up = true;
+        } else if (bottom_up and next_size * beta < total
+                   and next_size < frontier_.size()) {
+          bottom_up = false;
+        }
+      }
+    }};
+    std::barrier sync(static_cast<std::ptrdiff_t>(workers_.size()), end_phase);
+    parallel::for_each_chunk(workers_.size(), 1, [&](size_type id, auto, auto) {
+      worker_state& w{workers_[id]};
+      while (true) {
+        try {
+          if (w.error == nullptr) {
+            if (bottom_up) {
+              expand_bottom_up(w, cursor, is_open, dist);
+            } else {
+              expand_top_down(w, cursor, is_open, dist + 1);
+            }
+          }
+        } catch (...) {
+          w.error = std::current_exception();
+        }
+        sync.arrive_and_wait();
+        if (done) {
+          return;
+        }
+        std::ranges::copy(w.next, next_frontier_.begin() + w.offset);
+        sync.arrive_and_wait();
+      }
+    });
+    for (const worker_state& w : workers_) {
+      if (w.error) {
+        std::rethrow_exception(w.error);
+      }
+    }
+    if (opts.parents) {
+      record_parents();
+    }
+    return reached;
+  }
+
+  template <std::predicate<const Vec&> Open>
+  size_type
+  run(const Vec& start, Open&& is_open, const parallel_bfs_options& opts = {}) {
+    return run(std::span(&start, 1), is_open, opts);
+  }
+
+  // Distances of the last run, unreached for nodes that were not reached.
+  [[nodiscard]] const distance_grid& distances() const noexcept { return distances_; }
+
+  [[nodiscard]] std::optional<Dist> distance(const Vec& p) const noexcept {
+    if (not distances_.contains(p) or distances_[p] == unreached) {
+      return std::nullopt;
+    }
+    return distances_[p];
+  }
+
+  // The parent of p in the last run with parents recorded, nullopt for starts and for
+  // nodes that were not reached.
+  [[nodiscard]] std::optional<Vec> parent(const Vec& p) const noexcept {
+    if (parents_.empty() or not distances_.contains(p)) {
+      return std::nullopt;
+    }
+    const size_type i{parents_[distances_.index(p)]};
+    if (i == no_parent) {
+      return std::nullopt;
+    }
+    return distances_.position(i);
+  }
+};
+
+} // namespace ndvec::search
+
+#endif // NDVEC_PARALLEL_BFS_HEADER_INCLUDED
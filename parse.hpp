@@ -0,0 +1,279 @@
+#ifndef NDVEC_PARSE_HEADER_INCLUDED
+#define NDVEC_PARSE_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "grid.hpp"
+#include "mapped_file.hpp"
+#include "ndvec.hpp"
+#include "parallel.hpp"
+
+namespace ndvec {
+
+struct parse_options {
+  // Characters that may appear around the values of a point, e.g. " ,xy=" for
+  // "x=1, y=-2". Every line holds zero or more whole points.
+  std::string_view separators{" \t\r,"};
+};
+
+namespace detail {
+
+using separator_table = std::array<bool, 256>;
+
+inline separator_table make_separator_table(std::string_view separators) {
+  separator_table table{};
+  for (unsigned char ch : separators) {
+    table[ch] = ch != '\n';
+  }
+  return table;
+}
+
+// Parses one value at the start of [first, last), like std::from_chars but also for
+// floating-point values where the standard library has no std::from_chars for them,
+// e.g. libc++ 18. There the values are parsed with strtod, which follows the C locale
+// of the program, so a program that calls setlocale with a locale that has a decimal
+// comma must set LC_NUMERIC back to "C" before parsing points.
+template <typename T>
+std::from_chars_result parse_value(const char* first, const char* last, T& value) {
+  if (first != last and *first == '+') {
+    ++first;
+  }
+#ifndef __cpp_lib_to_chars
+  if constexpr (std::floating_point<T>) {
+    // no floating-point std::from_chars, copy the token for strtod, on the stack unless
+    // it is very long
+    auto is_float_char{[](char ch) {
+      return ('0' <= ch and ch <= '9') or ch == '.' or ch == 'e' or ch == 'E' or ch == '-'
+             or ch == '+';
+    }};
+    const char* token_end{first};
+    while (token_end != last and is_float_char(*token_end)) {
+      ++token_end;
+    }
+    std::array<char, 64> short_token{};
+    std::string long_token;
+    char* token{short_token.data()};
+    if (static_cast<std::size_t>(token_end - first) < short_token.size()) {
+      std::copy(first, token_end, short_token.begin());
+    } else {
+      long_token.assign(first, token_end);
+      token = long_token.data();
+    }
+    char* stop{};
+    errno = 0;
+    if constexpr (std::same_as<T, float>) {
+      value = std::strtof(token, &stop);
+    } else if constexpr (std::same_as<T, double>) {
+      value = std::strtod(token, &stop);
+    } else {
+      value = std::strtold(token, &stop);
+    }
+    if (stop == token) {
+      return {first, std::errc::invalid_argument};
+    }
+    const char* end{first + (stop - token)};
+    if (errno == ERANGE) {
+      return {end, std::errc::result_out_of_range};
+    }
+    return {end, std::errc{}};
+  } else
+#endif
+  {
+    return std::from_chars(first, last, value);
+  }
+}
+
+// Parses the whole lines in text, which starts at offset in the input, and calls emit
+// with every point.
+template <typename Vec, typename Emit>
+void parse_lines(
+    std::string_view text,
+    std::size_t offset,
+    const separator_table& is_separator,
+    Emit&& emit
+) {
+  std::array<typename Vec::value_type, Vec::ndim> values{};
+  std::size_t axis{};
+  auto message{[&](std::string_view what, const char* at) {
+    return std::format(
+        "parse_points {} at offset {}",
+        what,
+        offset + static_cast<std::size_t>(at - text.data())
+    );
+  }};
+  const char* const last{text.data() + text.size()};
+  for (const char* p{text.data()}; p != last;) {
+    const auto ch{static_cast<unsigned char>(*p)};
+    if (ch == '\n') {
+      if (axis != 0) {
+        throw std::invalid_argument(message("incomplete point", p));
+      }
+      ++p;
+    } else if (is_separator[ch]) {
+      ++p;
+    } else {
+      const auto [end, ec]{parse_value(p, last, values[axis])};
+      if (ec == std::errc::result_out_of_range) {
+        throw std::out_of_range(message("value out of range", p));
+      }
+      if (ec != std::errc{}) {
+        throw std::invalid_argument(
+            message(std::format("unexpected character '{}'", *p), p)
+        );
+      }
+      p = end;
+      if (++axis == Vec::ndim) {
+        emit(std::apply([](auto... vs) { return Vec(vs...); }, values));
+        axis = 0;
+      }
+    }
+  }
+  if (axis != 0) {
+    throw std::invalid_argument(message("incomplete point", last));
+  }
+}
+
+} // namespace detail
+
+// Parses the points in input and appends them to out, which is e.g. a std::vector<Vec>
+// or a soa_vector<Vec>. Large inputs are split at line boundaries and the chunks are
+// parsed in parallel. Throws std::invalid_argument with the offset of the first
+// character that is not part of a value or a separator, and std::out_of_range for
+// values that do not fit in the value type.
+template <typename Vec, typename Out>
+  requires requires(Out& out, const Vec& v, std::size_t i) {
+    out.push_back(v);
+    out.resize(i);
+    out[i] = v;
+  }
+void parse_points(std::string_view input, Out& out, const parse_options& options = {}) {
+  constexpr std::size_t parallel_min_size{1 << 20};
+  const detail::separator_table is_separator{
+      detail::make_separator_table(options.separators)
+  };
+  const std::size_t chunks{parallel::chunk_count(input.size(), parallel_min_size)};
+  if (chunks == 1) {
+    detail::parse_lines<Vec>(input, 0, is_separator, [&out](const Vec& v) {
+      out.push_back(v);
+    });
+    return;
+  }
+
+  std::vector<std::size_t> bounds(chunks + 1, input.size());
+  bounds[0] = 0;
+  for (std::size_t chunk{1}; chunk < chunks; ++chunk) {
+    const std::size_t split{std::max(input.size() * chunk / chunks, bounds[chunk - 1])};
+    if (const std::size_t newline{input.find('\n', split)}; newline != input.npos) {
+      bounds[chunk] = newline + 1;
+    }
+  }
+  std::vector<std::vector<Vec>> parts(chunks);
+  parallel::for_each_chunk(chunks, 1, [&](std::size_t, auto b, auto e) {
+    for (std::size_t chunk{b}; chunk < e; ++chunk) {
+      detail::parse_lines<Vec>(
+          input.substr(bounds[chunk], bounds[chunk + 1] - bounds[chunk]),
+          bounds[chunk],
+          is_separator,
+          [&part = parts[chunk]](const Vec& v) { part.push_back(v); }
+      );
+    }
+  });
+
+  std::vector<std::size_t> part_begin(chunks + 1, out.size());
+  for (std::size_t chunk{}; chunk < chunks; ++chunk) {
+    part_begin[chunk + 1] = part_begin[chunk] + parts[chunk].size();
+  }
+  out.resize(part_begin[chunks]);
+  parallel::for_each_chunk(chunks, 1, [&](std::size_t, auto b, auto e) {
+    for (std::size_t chunk{b}; chunk < e; ++chunk) {
+      for (std::size_t i{part_begin[chunk]}; const Vec& v : parts[chunk]) {
+        out[i++] = v;
+      }
+    }
+  });
+}
+
+template <typename Vec>
+[[nodiscard]] std::vector<Vec>
+parse_points(std::string_view input, const parse_options& options = {}) {
+  std::vector<Vec> points;
+  parse_points<Vec>(input, points, options);
+  return points;
+}
+
+template <typename Vec>
+[[nodiscard]] std::vector<Vec>
+parse_points_file(const std::filesystem::path& path, const parse_options& options = {}) {
+  const mapped_file file(path);
+  return parse_points<Vec>(file.view(), options);
+}
+
+// Grid of the characters of a rectangular block of text, with x as the column and y as
+// the line. Each character is converted with to_cell, e.g. a digit to its value with
+// [](char c) { return c - '0'; }. A trailing newline and carriage returns at the ends
+// of lines are ignored, and lines of different lengths throw std::invalid_argument.
+template <std::integral T = int, typename ToCell = std::identity>
+[[nodiscard]] auto parse_grid(std::string_view input, ToCell&& to_cell = {}) {
+  using Cell = std::remove_cvref_t<std::invoke_result_t<ToCell&, char>>;
+  using vec = vec2<T>;
+  if (input.ends_with('\n')) {
+    input.remove_suffix(1);
+  }
+  if (input.empty()) {
+    return grid<Cell, 2, T>();
+  }
+  const std::size_t height{static_cast<std::size_t>(std::ranges::count(input, '\n')) + 1};
+  std::string_view first_line{input.substr(0, input.find('\n'))};
+  if (first_line.ends_with('\r')) {
+    first_line.remove_suffix(1);
+  }
+  const std::size_t width{first_line.size()};
+  grid<Cell, 2, T> g(vec(static_cast<T>(width), static_cast<T>(height)));
+  Cell* out{g.cells().data()};
+  for (std::size_t y{}; y < height; ++y, out += width) {
+    std::string_view line{input.substr(0, input.find('\n'))};
+    input.remove_prefix(std::min(line.size() + 1, input.size()));
+    if (line.ends_with('\r')) {
+      line.remove_suffix(1);
+    }
+    if (line.size() != width) {
+      throw std::invalid_argument(
+          std::format(
+              "parse_grid line {} has {} characters, expected {}",
+              y + 1,
+              line.size(),
+              width
+          )
+      );
+    }
+    std::ranges::transform(line, out, std::ref(to_cell));
+  }
+  return g;
+}
+
+template <std::integral T = int, typename ToCell = std::identity>
+[[nodiscard]] auto
+parse_grid_file(const std::filesystem::path& path, ToCell&& to_cell = {}) {
+  const mapped_file file(path);
+  return parse_grid<T>(file.view(), to_cell);
+}
+
+} // namespace ndvec
+
+#endif // NDVEC_PARSE_HEADER_INCLUDED
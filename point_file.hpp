@@ -0,0 +1,301 @@
+#ifndef NDVEC_POINT_FILE_HEADER_INCLUDED
+#define NDVEC_POINT_FILE_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "ndvec.hpp"
+
+// Binary files of points that are read without parsing or copying. A file is a 64-byte
+// header followed by the values of all points, either point by point with the axes in
+// order (AoS) or axis by axis with every column padded to a multiple of 64 bytes (SoA).
+// The values are in the byte order of the machine that wrote the file, and readers on
+// machines with the other byte order reject the file.
+namespace ndvec {
+
+enum class point_layout : std::uint8_t {
+  aos,
+  soa,
+};
+
+namespace detail {
+
+enum class value_kind : std::uint8_t {
+  signed_integer,
+  unsigned_integer,
+  floating_point,
+};
+
+template <typename T> consteval value_kind value_kind_of() {
+  if constexpr (std::floating_point<T>) {
+    return value_kind::floating_point;
+  } else if constexpr (std::is_signed_v<T>) {
+    return value_kind::signed_integer;
+  } else {
+    return value_kind::unsigned_integer;
+  }
+}
+
+struct point_file_header {
+  static constexpr std::array<char, 8> expected_magic{
+      'n', 'd', 'v', 'e', 'c', 'p', 't', 's'
+  };
+  static constexpr std::uint32_t current_version{1};
+
+  std::array<char, 8> magic{expected_magic};
+  std::uint32_t version{current_version};
+  std::uint8_t little_endian{std::endian::native == std::endian::little};
+  point_layout layout{};
+  std::uint8_t ndim{};
+  value_kind kind{};
+  std::uint8_t value_size{};
+  std::array<std::uint8_t, 7> reserved{};
+  std::uint64_t count{};
+  std::array<std::uint8_t, 32> padding{};
+};
+
+static_assert(sizeof(point_file_header) == 64);
+static_assert(std::is_trivially_copyable_v<point_file_header>);
+
+inline constexpr std::size_t point_file_alignment{64};
+
+[[nodiscard]] constexpr std::size_t padded_size(std::size_t bytes) noexcept {
+  return (bytes + point_file_alignment - 1) / point_file_alignment * point_file_alignment;
+}
+
+// True if the axes of Vec are stored in order without padding, so that an array of
+// values in AoS order is an array of Vec.
+template <typename Vec> [[nodiscard]] bool has_packed_layout() noexcept {
+  using T = Vec::value_type;
+  if constexpr (sizeof(Vec) != Vec::ndim * sizeof(T)
+                or not std::is_trivially_copyable_v<Vec>) {
+    return false;
+  } else {
+    const Vec v{};
+    const auto* base{reinterpret_cast<const std::byte*>(&v)};
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      return (
+          ...
+          and (reinterpret_cast<const std::byte*>(&v.template get<axes>()) - base
+               == static_cast<std::ptrdiff_t>(axes * sizeof(T)))
+      );
+    }(typename Vec::axes_indices{});
+  }
+}
+
+} // namespace detail
+
+// Writes points, any sized range of Vec such as a std::vector or a soa_vector, to a new
+// file at path.
+template <std::ranges::forward_range R>
+  requires std::ranges::sized_range<R>
+void write_points(
+    const std::filesystem::path& path,
+    const R& points,
+    point_layout layout = point_layout::aos
+) {
+  using Vec = std::remove_cvref_t<std::ranges::range_value_t<R>>;
+  using T = Vec::value_type;
+  const std::size_t count{static_cast<std::size_t>(std::ranges::size(points))};
+  detail::point_file_header header;
+  header.layout = layout;
+  header.ndim = static_cast<std::uint8_t>(Vec::ndim);
+  header.kind = detail::value_kind_of<T>();
+  header.value_size = static_cast<std::uint8_t>(sizeof(T));
+  header.count = count;
+
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  if (not os) {
+    throw std::system_error(
+        errno,
+        std::generic_category(),
+        "write_points cannot open " + path.string()
+    );
+  }
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  // values are staged in blocks so that the stream is written in large pieces
+  constexpr std::size_t block_size{1 << 14};
+  std::vector<T> block;
+  block.reserve(block_size);
+  auto flush{[&] {
+    os.write(
+        reinterpret_cast<const char*>(block.data()),
+        static_cast<std::streamsize>(block.size() * sizeof(T))
+    );
+    block.clear();
+  }};
+  auto pad_to_alignment{[&](std::size_t bytes) {
+    constexpr std::array<char, detail::point_file_alignment> zeros{};
+    os.write(
+        zeros.data(),
+        static_cast<std::streamsize>(detail::padded_size(bytes) - bytes)
+    );
+  }};
+  if (layout == point_layout::aos) {
+    for (const Vec& p : points) {
+      [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+        (block.push_back(p.template get<axes>()), ...);
+      }(typename Vec::axes_indices{});
+      if (block.size() >= block_size) {
+        flush();
+      }
+    }
+    flush();
+    pad_to_alignment(count * Vec::ndim * sizeof(T));
+  } else {
+    auto coords{[](const Vec& p) {
+      return std::apply(
+          [](auto... vs) { return std::array<T, Vec::ndim>{vs...}; },
+          p.values()
+      );
+    }};
+    for (std::size_t axis{}; axis < Vec::ndim; ++axis) {
+      for (const Vec& p : points) {
+        block.push_back(coords(p)[axis]);
+        if (block.size() >= block_size) {
+          flush();
+        }
+      }
+      flush();
+      pad_to_alignment(count * sizeof(T));
+    }
+  }
+  if (not os.flush()) {
+    throw std::system_error(
+        errno,
+        std::generic_category(),
+        "write_points cannot write " + path.string()
+    );
+  }
+}
+
+// Memory-mapped view of a file written by write_points. The points and axes are read
+// in place from the mapped pages, so opening a file costs a few system calls no matter
+// how large it is, and the data is paged in as it is first accessed.
+class point_file {
+  mapped_file file;
+  detail::point_file_header header;
+
+  template <typename T> void check_value_type() const {
+    if (header.kind != detail::value_kind_of<T>() or header.value_size != sizeof(T)) {
+      throw std::invalid_argument("point_file value type does not match the file");
+    }
+  }
+
+  template <typename T> [[nodiscard]] const T* values_at(std::size_t offset) const {
+    const char* p{file.data() + sizeof(header) + offset};
+    if (reinterpret_cast<std::uintptr_t>(p) % alignof(T) != 0) {
+      throw std::invalid_argument("point_file data is not aligned for the value type");
+    }
+    return reinterpret_cast<const T*>(p);
+  }
+
+public:
+  // Throws std::invalid_argument if path is not a point file of this version and byte
+  // order, or if it is shorter than its header says.
+  explicit point_file(const std::filesystem::path& path) : file(path) {
+    if (file.size() < sizeof(header)) {
+      throw std::invalid_argument("point_file is too short for a header");
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != detail::point_file_header::expected_magic) {
+      throw std::invalid_argument("point_file is not a point file");
+    }
+    if (header.version != detail::point_file_header::current_version) {
+      throw std::invalid_argument("point_file version is not supported");
+    }
+    if (header.little_endian != (std::endian::native == std::endian::little)) {
+      throw std::invalid_argument("point_file byte order does not match this machine");
+    }
+    if (header.layout != point_layout::aos and header.layout != point_layout::soa) {
+      throw std::invalid_argument("point_file layout is not supported");
+    }
+    if (header.ndim == 0 or header.value_size == 0
+        or header.count > file.size() / header.value_size / header.ndim) {
+      throw std::invalid_argument("point_file is truncated");
+    }
+    const std::size_t column_bytes{header.count * header.value_size};
+    const std::size_t payload{
+        header.layout == point_layout::aos
+            ? detail::padded_size(column_bytes * header.ndim)
+            : detail::padded_size(column_bytes) * header.ndim
+    };
+    if (file.size() < sizeof(header) + payload) {
+      throw std::invalid_argument("point_file is truncated");
+    }
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return header.count; }
+  [[nodiscard]] bool empty() const noexcept { return header.count == 0; }
+  [[nodiscard]] std::size_t ndim() const noexcept { return header.ndim; }
+  [[nodiscard]] point_layout layout() const noexcept { return header.layout; }
+
+  // The points of an AoS file. Throws std::invalid_argument if the file has another
+  // layout or value type, or if Vec does not store its axes in order without padding.
+  template <typename Vec> [[nodiscard]] std::span<const Vec> points() const {
+    check_value_type<typename Vec::value_type>();
+    if (header.layout != point_layout::aos or header.ndim != Vec::ndim) {
+      throw std::invalid_argument("point_file points require an AoS file of Vec");
+    }
+    if (not detail::has_packed_layout<Vec>()) {
+      throw std::invalid_argument("point_file points require a Vec with packed axes");
+    }
+    return {values_at<Vec>(0), size()};
+  }
+
+  // The values of one axis of an SoA file, 64-byte aligned. Throws std::invalid_argument
+  // if the file has another layout or value type.
+  template <typename T> [[nodiscard]] std::span<const T> axis(std::size_t axis) const {
+    check_value_type<T>();
+    if (header.layout != point_layout::soa or axis >= header.ndim) {
+      throw std::invalid_argument("point_file axis requires an SoA file with that axis");
+    }
+    return {values_at<T>(axis * detail::padded_size(size() * sizeof(T))), size()};
+  }
+
+  // Copies of all points, from a file of either layout.
+  template <typename Vec> [[nodiscard]] std::vector<Vec> read() const {
+    using T = Vec::value_type;
+    check_value_type<T>();
+    if (header.ndim != Vec::ndim) {
+      throw std::invalid_argument("point_file ndim does not match Vec");
+    }
+    std::vector<Vec> res(size());
+    if (header.layout == point_layout::aos) {
+      const T* values{values_at<T>(0)};
+      for (Vec& p : res) {
+        p.apply([&values](T) { return *values++; });
+      }
+    } else {
+      [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+        const std::array columns{axis<T>(axes)...};
+        for (std::size_t i{}; i < res.size(); ++i) {
+          ((res[i].template get<axes>() = columns[axes][i]), ...);
+        }
+      }(typename Vec::axes_indices{});
+    }
+    return res;
+  }
+};
+
+} // namespace ndvec
+
+#endif // NDVEC_POINT_FILE_HEADER_INCLUDED
@@ -0,0 +1,284 @@
+#ifndef NDVEC_RADIX_SORT_HEADER_INCLUDED
+#define NDVEC_RADIX_SORT_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "curve.hpp"
+#include "ndvec.hpp"
+#include "parallel.hpp"
+#include "reduce.hpp"
+#include "soa_vector.hpp"
+
+// Least significant digit radix sort of integral ndvecs, 8 bits per pass. Every pass
+// counts the digits of each chunk of points on its own thread, turns the counts into
+// per-chunk output offsets, and scatters the chunks in parallel, which keeps the sort
+// stable. Passes where all points share the same digit are skipped, and lexicographic
+// keys only cover the bounding box, so points in a small box take a few passes instead
+// of one per byte of the vec.
+namespace ndvec {
+
+enum class sort_order {
+  // the order of operator<=>, axis 0 first
+  lexicographic,
+  // the order of morton_encode, for the 2D, 3D and 4D vecs of curve_vec
+  morton,
+};
+
+namespace detail {
+
+template <typename Vec>
+concept radix_vec = requires {
+  typename Vec::value_type;
+  requires std::same_as<Vec, vecn<typename Vec::value_type, Vec::ndim>>;
+  requires std::integral<typename Vec::value_type>;
+  requires not std::same_as<typename Vec::value_type, bool>;
+};
+
+template <typename R>
+concept radix_range = std::ranges::contiguous_range<R> and std::ranges::sized_range<R>
+                      and radix_vec<std::ranges::range_value_t<R>>
+                      and not std::is_const_v<std::remove_reference_t<
+                          std::ranges::range_reference_t<R>>>;
+
+template <typename Vec, sort_order order>
+concept radix_sortable = radix_vec<Vec>
+                         and (order == sort_order::lexicographic or curve_vec<Vec>);
+
+inline constexpr std::size_t radix_min_chunk{1 << 16};
+inline constexpr std::size_t radix_buckets{256};
+
+// Stable sort of items by digit(item, pass) for pass in [0, passes), least significant
+// first. buffer must hold as many items as items, the result ends up in items.
+template <typename Item, typename Digit>
+void lsd_radix_sort(
+    std::span<Item> items,
+    std::span<Item> buffer,
+    std::size_t passes,
+    Digit digit
+) {
+  using counts_type = std::array<std::size_t, radix_buckets>;
+  const std::size_t n{items.size()};
+  const std::size_t chunks{parallel::chunk_count(n, radix_min_chunk)};
+  std::vector<counts_type> offsets(chunks);
+  std::span<Item> src{items}, dst{buffer};
+  for (std::size_t pass{}; pass < passes; ++pass) {
+    parallel::for_each_chunk(
+        n,
+        radix_min_chunk,
+        [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+          counts_type& counts{offsets[chunk]};
+          counts.fill(0);
+          for (std::size_t i{begin}; i < end; ++i) {
+            ++counts[digit(src[i], pass)];
+          }
+        }
+    );
+    // every chunk writes each digit after the same digit of the chunks before it
+    std::size_t total{};
+    bool trivial{false};
+    for (std::size_t bucket{}; bucket < radix_buckets; ++bucket) {
+      const std::size_t bucket_begin{total};
+      for (counts_type& counts : offsets) {
+        total += std::exchange(counts[bucket], total);
+      }
+      trivial |= total - bucket_begin == n;
+    }
+    if (trivial) {
+      continue;
+    }
+    parallel::for_each_chunk(
+        n,
+        radix_min_chunk,
+        [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+          counts_type& next{offsets[chunk]};
+          for (std::size_t i{begin}; i < end; ++i) {
+            dst[next[digit(src[i], pass)]++] = src[i];
+          }
+        }
+    );
+    std::swap(src, dst);
+  }
+  if (src.data() != items.data()) {
+    parallel::for_each_chunk(
+        n,
+        radix_min_chunk,
+        [&](std::size_t, std::size_t begin, std::size_t end) {
+          std::copy(src.begin() + begin, src.begin() + end, items.begin() + begin);
+        }
+    );
+  }
+}
+
+// Offset of one axis of v from the same axis of lo, where lo <= v on every axis.
+template <radix_vec Vec>
+[[nodiscard]] constexpr auto
+axis_offset(const Vec& v, const Vec& lo, std::size_t axis) noexcept {
+  using U = std::make_unsigned_t<typename Vec::value_type>;
+  U offset{};
+  [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+    ((offset = axes == axis ? static_cast<U>(
+                                  static_cast<U>(v.template get<axes>())
+                                  - static_cast<U>(lo.template get<axes>())
+                              )
+                            : offset),
+     ...);
+  }(typename Vec::axes_indices{});
+  return offset;
+}
+
+// One byte of the lexicographic key, the offset of an axis from its smallest value.
+struct lexicographic_pass {
+  std::size_t axis{};
+  std::size_t shift{};
+};
+
+// The passes of the lexicographic key, least significant first. Only the bytes in which
+// the offsets from the smallest value of each axis can differ are sorted, e.g. 2 bytes
+// per axis for points in [-1000, 1000].
+template <radix_vec Vec>
+[[nodiscard]] std::vector<lexicographic_pass>
+lexicographic_passes(const Vec& min, const Vec& max) {
+  std::vector<lexicographic_pass> passes;
+  for (std::size_t axis{Vec::ndim}; axis-- > 0;) {
+    const auto width{axis_offset(max, min, axis)};
+    for (std::size_t shift{}; shift < 8 * sizeof(width) and (width >> shift) != 0;
+         shift += 8) {
+      passes.push_back({axis, shift});
+    }
+  }
+  return passes;
+}
+
+template <sort_order order, radix_vec Vec>
+  requires radix_sortable<Vec, order>
+void radix_sort(std::span<Vec> points) {
+  if (points.size() < 2) {
+    return;
+  }
+  if constexpr (order == sort_order::lexicographic) {
+    const auto [lo, hi]{reduce::bounds(std::span<const Vec>(points))};
+    const auto passes{lexicographic_passes(lo, hi)};
+    std::vector<Vec> buffer(points.size());
+    lsd_radix_sort(
+        points,
+        std::span<Vec>(buffer),
+        passes.size(),
+        [&](const Vec& v, std::size_t pass) -> std::size_t {
+          const auto [axis, shift]{passes[pass]};
+          return (axis_offset(v, lo, axis) >> shift) & 0xff;
+        }
+    );
+  } else {
+    // the codes are computed once and sorted with the index of their point, which moves
+    // 16 bytes per pass instead of the code and the whole point
+    using keyed = std::pair<std::uint64_t, std::size_t>;
+    std::vector<keyed> items(points.size()), buffer(points.size());
+    parallel::for_each_chunk(
+        points.size(),
+        radix_min_chunk,
+        [&](std::size_t, std::size_t begin, std::size_t end) {
+          for (std::size_t i{begin}; i < end; ++i) {
+            items[i] = {morton_encode(points[i]), i};
+          }
+        }
+    );
+    lsd_radix_sort(
+        std::span<keyed>(items),
+        std::span<keyed>(buffer),
+        sizeof(std::uint64_t),
+        [](const keyed& item, std::size_t pass) -> std::size_t {
+          return (item.first >> (8 * pass)) & 0xff;
+        }
+    );
+    const std::vector<Vec> unsorted(points.begin(), points.end());
+    parallel::for_each_chunk(
+        points.size(),
+        radix_min_chunk,
+        [&](std::size_t, std::size_t begin, std::size_t end) {
+          for (std::size_t i{begin}; i < end; ++i) {
+            points[i] = unsorted[items[i].second];
+          }
+        }
+    );
+  }
+}
+
+// The points of a soa_vector are gathered into an AoS buffer, sorted and scattered back,
+// which costs two passes over the columns instead of moving every column in every pass.
+template <radix_vec Vec, typename Fn>
+auto with_aos_copy(soa_vector<Vec>& points, Fn&& fn) {
+  std::vector<Vec> aos(points.size());
+  parallel::for_each_chunk(
+      points.size(),
+      radix_min_chunk,
+      [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i{begin}; i < end; ++i) {
+          aos[i] = points[i];
+        }
+      }
+  );
+  auto res{fn(std::span<Vec>(aos))};
+  parallel::for_each_chunk(
+      points.size(),
+      radix_min_chunk,
+      [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i{begin}; i < end; ++i) {
+          points[i] = aos[i];
+        }
+      }
+  );
+  return res;
+}
+
+template <radix_vec Vec> [[nodiscard]] std::size_t sort_unique(std::span<Vec> points) {
+  radix_sort<sort_order::lexicographic>(points);
+  return static_cast<std::size_t>(std::ranges::unique(points).begin() - points.begin());
+}
+
+} // namespace detail
+
+// Sorts a contiguous range of integral vecs, e.g. radix_sort<sort_order::morton>(points).
+// Morton order is stable and only compiles for vecs that have a Morton code.
+template <sort_order order = sort_order::lexicographic, detail::radix_range R>
+  requires detail::radix_sortable<std::ranges::range_value_t<R>, order>
+void radix_sort(R&& points) {
+  using Vec = std::ranges::range_value_t<R>;
+  detail::radix_sort<order>(std::span<Vec>(points));
+}
+
+template <sort_order order = sort_order::lexicographic, detail::radix_vec Vec>
+  requires detail::radix_sortable<Vec, order>
+void radix_sort(soa_vector<Vec>& points) {
+  detail::with_aos_copy(points, [](std::span<Vec> aos) {
+    detail::radix_sort<order>(aos);
+    return 0;
+  });
+}
+
+// Sorts the points lexicographically and moves the distinct points to the front, returns
+// their count, e.g. points.resize(sort_unique(points)).
+template <detail::radix_range R> [[nodiscard]] std::size_t sort_unique(R&& points) {
+  using Vec = std::ranges::range_value_t<R>;
+  return detail::sort_unique(std::span<Vec>(points));
+}
+
+template <detail::radix_vec Vec>
+[[nodiscard]] std::size_t sort_unique(soa_vector<Vec>& points) {
+  return detail::with_aos_copy(points, [](std::span<Vec> aos) {
+    return detail::sort_unique(aos);
+  });
+}
+
+} // namespace ndvec
+
+#endif // NDVEC_RADIX_SORT_HEADER_INCLUDED
@@ -0,0 +1,354 @@
+#ifndef NDVEC_REDUCE_HEADER_INCLUDED
+#define NDVEC_REDUCE_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ndvec.hpp"
+#include "parallel.hpp"
+#include "soa_vector.hpp"
+
+// Reductions over all points of a contiguous range of ndvecs or a soa_vector, e.g. the
+// bounding box of a grid. The points are split into fixed blocks, and each block is
+// reduced with several independent accumulators, which compile to packed min, max and
+// add instructions. Blocks are reduced on several threads and then combined in a fixed
+// order, so floating-point sums do not depend on the number of threads or the layout.
+namespace ndvec::reduce {
+
+enum class summation {
+  // each block is summed by 8 interleaved accumulators, and the block sums are added
+  // pairwise, so the error grows with the logarithm of the number of blocks
+  pairwise,
+  // like pairwise, but every addition carries its rounding error along (Neumaier), so
+  // the error does not grow with the number of points
+  compensated,
+};
+
+// Indices of the first points with the smallest and the largest value on one axis.
+struct axis_extremes {
+  std::size_t min{};
+  std::size_t max{};
+
+  [[nodiscard]] constexpr bool operator==(const axis_extremes&) const noexcept = default;
+};
+
+namespace detail {
+
+inline constexpr std::size_t block_size{4096};
+inline constexpr std::size_t parallel_min_blocks{16};
+inline constexpr std::size_t lanes{8};
+
+template <typename T> struct is_ndvec : std::false_type {};
+template <typename... Ts> struct is_ndvec<ndvec<Ts...>> : std::true_type {};
+
+template <typename R>
+concept point_span = std::ranges::contiguous_range<R> and std::ranges::sized_range<R>
+                     and is_ndvec<std::ranges::range_value_t<R>>::value;
+
+template <typename Vec> struct aos_source {
+  using vec = Vec;
+
+  std::span<const Vec> points;
+
+  [[nodiscard]] std::size_t size() const noexcept { return points.size(); }
+  [[nodiscard]] Vec operator[](std::size_t i) const noexcept { return points[i]; }
+};
+
+template <typename Vec> struct soa_source {
+  using vec = Vec;
+
+  const soa_vector<Vec>& points;
+
+  [[nodiscard]] std::size_t size() const noexcept { return points.size(); }
+  [[nodiscard]] Vec operator[](std::size_t i) const noexcept {
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      return Vec(points.template axis_data<axes>()[i]...);
+    }(typename Vec::axes_indices{});
+  }
+};
+
+template <typename A, typename Vec>
+[[nodiscard]] constexpr vecn<A, Vec::ndim> convert(const Vec& v) noexcept {
+  return [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+    return vecn<A, Vec::ndim>(static_cast<A>(v.template get<axes>())...);
+  }(typename Vec::axes_indices{});
+}
+
+template <typename Vec>
+[[nodiscard]] constexpr std::array<typename Vec::value_type, Vec::ndim>
+coords(const Vec& v) noexcept {
+  return std::apply([](auto... vs) { return std::array{vs...}; }, v.values());
+}
+
+template <typename T>
+using wide_t = std::conditional_t<
+    std::floating_point<T>,
+    T,
+    std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>>;
+
+template <typename T>
+using mean_t = std::conditional_t<std::floating_point<T>, T, double>;
+
+// Calls fn(begin, end) for every block of the n points, on several threads for large n,
+// and returns the results in block order.
+template <typename Fn> [[nodiscard]] auto for_each_block(std::size_t n, Fn&& fn) {
+  using result_type = std::invoke_result_t<Fn&, std::size_t, std::size_t>;
+  const std::size_t blocks{(n + block_size - 1) / block_size};
+  std::vector<result_type> res(blocks);
+  parallel::for_each_chunk(blocks, parallel_min_blocks, [&](std::size_t, auto b, auto e) {
+    for (std::size_t block{b}; block < e; ++block) {
+      res[block] = fn(block * block_size, std::min(n, (block + 1) * block_size));
+    }
+  });
+  return res;
+}
+
+// Adds the values in a fixed binary tree, overwriting them.
+template <typename V>
+[[nodiscard]] constexpr V pairwise_sum(std::span<V> values) noexcept {
+  if (values.empty()) {
+    return V{};
+  }
+  for (std::size_t size{values.size()}; size > 1; size = (size + 1) / 2) {
+    for (std::size_t i{}; i < size / 2; ++i) {
+      values[i] = values[2 * i] + values[2 * i + 1];
+    }
+    if (size % 2 == 1) {
+      values[size / 2] = values[size - 1];
+    }
+  }
+  return values[0];
+}
+
+// Neumaier's compensated sum, axis by axis.
+template <typename V> struct compensated_sum {
+  V sum{};
+  V error{};
+
+  constexpr void add(const V& v) noexcept {
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      (add_axis(
+           sum.template get<axes>(),
+           error.template get<axes>(),
+           v.template get<axes>()
+       ),
+       ...);
+    }(typename V::axes_indices{});
+  }
+
+  constexpr void add(const compensated_sum& other) noexcept {
+    add(other.sum);
+    add(other.error);
+  }
+
+  [[nodiscard]] constexpr V value() const noexcept { return sum + error; }
+
+private:
+  template <typename T> static constexpr void add_axis(T& s, T& e, T x) noexcept {
+    const T t{s + x};
+    const T abs_s{s < 0 ? -s : s};
+    const T abs_x{x < 0 ? -x : x};
+    e += abs_s >= abs_x ? (s - t) + x : (x - t) + s;
+    s = t;
+  }
+};
+
+// Sum of the points converted to value type A. Point i of a block goes to accumulator
+// (i - begin) % lanes, the same for both layouts.
+template <typename A, typename Source>
+[[nodiscard]] vecn<A, Source::vec::ndim> sum(const Source& src, summation mode) {
+  using Acc = vecn<A, Source::vec::ndim>;
+  if constexpr (std::floating_point<A>) {
+    if (mode == summation::compensated) {
+      const std::vector<compensated_sum<Acc>> blocks{
+          for_each_block(src.size(), [&](std::size_t b, std::size_t e) {
+            std::array<compensated_sum<Acc>, lanes> acc{};
+            for (std::size_t i{b}; i < e; ++i) {
+              acc[(i - b) % lanes].add(convert<A>(src[i]));
+            }
+            compensated_sum<Acc> res;
+            for (const compensated_sum<Acc>& lane : acc) {
+              res.add(lane);
+            }
+            return res;
+          })
+      };
+      compensated_sum<Acc> res;
+      for (const compensated_sum<Acc>& block : blocks) {
+        res.add(block);
+      }
+      return res.value();
+    }
+  }
+  std::vector<Acc> blocks{for_each_block(src.size(), [&](std::size_t b, std::size_t e) {
+    std::array<Acc, lanes> acc{};
+    std::size_t i{b};
+    for (; i + lanes <= e; i += lanes) {
+      for (std::size_t lane{}; lane < lanes; ++lane) {
+        acc[lane] += convert<A>(src[i + lane]);
+      }
+    }
+    for (; i < e; ++i) {
+      acc[(i - b) % lanes] += convert<A>(src[i]);
+    }
+    return pairwise_sum<Acc>(acc);
+  })};
+  return pairwise_sum<Acc>(blocks);
+}
+
+template <typename Source>
+[[nodiscard]] auto centroid(const Source& src, summation mode) {
+  using T = Source::vec::value_type;
+  if (src.size() == 0) {
+    throw std::invalid_argument("reduce::centroid of an empty range");
+  }
+  using M = mean_t<T>;
+  auto res{convert<M>(sum<wide_t<T>>(src, mode))};
+  return res.apply([n = static_cast<M>(src.size())](M v) { return v / n; });
+}
+
+template <typename Source> [[nodiscard]] auto bounds(const Source& src) {
+  using Vec = Source::vec;
+  using box = std::pair<Vec, Vec>;
+  if (src.size() == 0) {
+    throw std::invalid_argument("reduce::bounds of an empty range");
+  }
+  const std::vector<box> blocks{
+      for_each_block(src.size(), [&](std::size_t b, std::size_t e) {
+        std::array<Vec, lanes> lo, hi;
+        lo.fill(src[b]);
+        hi.fill(src[b]);
+        std::size_t i{b};
+        for (; i + lanes <= e; i += lanes) {
+          for (std::size_t lane{}; lane < lanes; ++lane) {
+            const Vec p{src[i + lane]};
+            lo[lane] = lo[lane].min(p);
+            hi[lane] = hi[lane].max(p);
+          }
+        }
+        for (; i < e; ++i) {
+          lo[0] = lo[0].min(src[i]);
+          hi[0] = hi[0].max(src[i]);
+        }
+        for (std::size_t lane{1}; lane < lanes; ++lane) {
+          lo[0] = lo[0].min(lo[lane]);
+          hi[0] = hi[0].max(hi[lane]);
+        }
+        return box{lo[0], hi[0]};
+      })
+  };
+  box res{blocks[0]};
+  for (const auto& [lo, hi] : blocks) {
+    res = {res.first.min(lo), res.second.max(hi)};
+  }
+  return res;
+}
+
+template <typename Source> [[nodiscard]] auto minmax_by_axis(const Source& src) {
+  using Vec = Source::vec;
+  using extremes = std::array<axis_extremes, Vec::ndim>;
+  if (src.size() == 0) {
+    throw std::invalid_argument("reduce::minmax_by_axis of an empty range");
+  }
+  // strict comparisons keep the first of equal values, within and across blocks
+  const std::vector<extremes> blocks{
+      for_each_block(src.size(), [&](std::size_t b, std::size_t e) {
+        extremes res;
+        res.fill({b, b});
+        auto lo{coords(src[b])}, hi{lo};
+        for (std::size_t i{b + 1}; i < e; ++i) {
+          const auto p{coords(src[i])};
+          for (std::size_t axis{}; axis < Vec::ndim; ++axis) {
+            if (p[axis] < lo[axis]) {
+              lo[axis] = p[axis];
+              res[axis].min = i;
+            }
+            if (hi[axis] < p[axis]) {
+              hi[axis] = p[axis];
+              res[axis].max = i;
+            }
+          }
+        }
+        return res;
+      })
+  };
+  extremes res{blocks[0]};
+  for (const extremes& block : blocks) {
+    for (std::size_t axis{}; axis < Vec::ndim; ++axis) {
+      if (coords(src[block[axis].min])[axis] < coords(src[res[axis].min])[axis]) {
+        res[axis].min = block[axis].min;
+      }
+      if (coords(src[res[axis].max])[axis] < coords(src[block[axis].max])[axis]) {
+        res[axis].max = block[axis].max;
+      }
+    }
+  }
+  return res;
+}
+
+} // namespace detail
+
+// Sum of all points in value_type, or a zero vector for an empty range.
+template <detail::point_span R>
+[[nodiscard]] auto sum(const R& points, summation mode = summation::pairwise) {
+  using Vec = std::ranges::range_value_t<R>;
+  return detail::sum<typename Vec::value_type>(detail::aos_source<Vec>{points}, mode);
+}
+
+template <typename Vec>
+[[nodiscard]] Vec
+sum(const soa_vector<Vec>& points, summation mode = summation::pairwise) {
+  return detail::sum<typename Vec::value_type>(detail::soa_source<Vec>{points}, mode);
+}
+
+// Mean of all points. Integral points are summed in 64 bits and their mean is a vecn of
+// double. Throws std::invalid_argument for an empty range.
+template <detail::point_span R>
+[[nodiscard]] auto centroid(const R& points, summation mode = summation::pairwise) {
+  using Vec = std::ranges::range_value_t<R>;
+  return detail::centroid(detail::aos_source<Vec>{points}, mode);
+}
+
+template <typename Vec>
+[[nodiscard]] auto
+centroid(const soa_vector<Vec>& points, summation mode = summation::pairwise) {
+  return detail::centroid(detail::soa_source<Vec>{points}, mode);
+}
+
+// Smallest and largest value of every axis, as the corners of the bounding box. Throws
+// std::invalid_argument for an empty range.
+template <detail::point_span R> [[nodiscard]] auto bounds(const R& points) {
+  using Vec = std::ranges::range_value_t<R>;
+  return detail::bounds(detail::aos_source<Vec>{points});
+}
+
+template <typename Vec>
+[[nodiscard]] std::pair<Vec, Vec> bounds(const soa_vector<Vec>& points) {
+  return detail::bounds(detail::soa_source<Vec>{points});
+}
+
+// Indices of the points with the smallest and largest value of every axis. Throws
+// std::invalid_argument for an empty range.
+template <detail::point_span R> [[nodiscard]] auto minmax_by_axis(const R& points) {
+  using Vec = std::ranges::range_value_t<R>;
+  return detail::minmax_by_axis(detail::aos_source<Vec>{points});
+}
+
+template <typename Vec>
+[[nodiscard]] std::array<axis_extremes, Vec::ndim>
+minmax_by_axis(const soa_vector<Vec>& points) {
+  return detail::minmax_by_axis(detail::soa_source<Vec>{points});
+}
+
+} // namespace ndvec::reduce
+
+#endif // NDVEC_REDUCE_HEADER_INCLUDED
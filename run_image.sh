@@ -7,8 +7,38 @@ docker run \
   --pull never \
   --rm \
   -v "${PWD}/ndvec.hpp:/ndvec/ndvec.hpp" \
+  -v "${PWD}/expr.hpp:/ndvec/expr.hpp" \
+  -v "${PWD}/soa_vector.hpp:/ndvec/soa_vector.hpp" \
+  -v "${PWD}/batch.hpp:/ndvec/batch.hpp" \
+  -v "${PWD}/mat.hpp:/ndvec/mat.hpp" \
+  -v "${PWD}/grid.hpp:/ndvec/grid.hpp" \
+  -v "${PWD}/sparse_grid.hpp:/ndvec/sparse_grid.hpp" \
+  -v "${PWD}/neighborhood.hpp:/ndvec/neighborhood.hpp" \
+  -v "${PWD}/packed_vec.hpp:/ndvec/packed_vec.hpp" \
+  -v "${PWD}/flat_hash.hpp:/ndvec/flat_hash.hpp" \
+  -v "${PWD}/curve.hpp:/ndvec/curve.hpp" \
+  -v "${PWD}/radix_sort.hpp:/ndvec/radix_sort.hpp" \
+  -v "${PWD}/kdtree.hpp:/ndvec/kdtree.hpp" \
+  -v "${PWD}/metric.hpp:/ndvec/metric.hpp" \
+  -v "${PWD}/parallel.hpp:/ndvec/parallel.hpp" \
+  -v "${PWD}/cell_list.hpp:/ndvec/cell_list.hpp" \
+  -v "${PWD}/search.hpp:/ndvec/search.hpp" \
+  -v "${PWD}/parallel_bfs.hpp:/ndvec/parallel_bfs.hpp" \
+  -v "${PWD}/automaton.hpp:/ndvec/automaton.hpp" \
+  -v "${PWD}/zobrist.hpp:/ndvec/zobrist.hpp" \
+  -v "${PWD}/bitgrid.hpp:/ndvec/bitgrid.hpp" \
+  -v "${PWD}/mapped_file.hpp:/ndvec/mapped_file.hpp" \
+  -v "${PWD}/parse.hpp:/ndvec/parse.hpp" \
+  -v "${PWD}/point_file.hpp:/ndvec/point_file.hpp" \
+  -v "${PWD}/reduce.hpp:/ndvec/reduce.hpp" \
+  -v "${PWD}/instrument.hpp:/ndvec/instrument.hpp" \
+  -v "${PWD}/hash_quality.hpp:/ndvec/hash_quality.hpp" \
   -v "${PWD}/main.cpp:/ndvec/main.cpp" \
   -v "${PWD}/test.cpp:/ndvec/test.cpp" \
+  -v "${PWD}/bench.cpp:/ndvec/bench.cpp" \
+  -v "${PWD}/codegen.cpp:/ndvec/codegen.cpp" \
+  -v "${PWD}/hash_quality.cpp:/ndvec/hash_quality.cpp" \
+  -v "${PWD}/codegen.sh:/ndvec/codegen.sh" \
   -v "${PWD}/Makefile:/ndvec/Makefile" \
   -v "${PWD}/.clang-format:/ndvec/.clang-format" \
   --interactive \
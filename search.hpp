@@ -0,0 +1,329 @@
+#ifndef NDVEC_SEARCH_HEADER_INCLUDED
+#define NDVEC_SEARCH_HEADER_INCLUDED
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "flat_hash.hpp"
+#include "grid.hpp"
+#include "ndvec.hpp"
+
+// Shortest path searches over the implicit graph where every vec is a node and its
+// neighbours are given by adjacent(). Callbacks decide which nodes are open and what a
+// step costs:
+//   is_open(const Vec& p) -> bool
+//   weight(const Vec& from, const Vec& to) -> std::optional<Dist>, nullopt if blocked
+//   visit(const Vec& p, Dist dist) -> bool or void, true stops the search
+// Every node is visited once, in order of increasing distance, and the searches return
+// the distance of the node where visit stopped, or nullopt if all reachable nodes were
+// visited.
+namespace ndvec::search {
+
+template <typename Vec>
+concept searchable = std::integral<typename Vec::value_type> and requires(const Vec& v) {
+  { v.adjacent() } -> std::ranges::range;
+};
+
+// Node state over a known box, a bitmap of visited nodes and a dense grid of distances.
+// Nodes outside the box are never visited.
+template <searchable Vec, std::integral Dist> class dense_storage {
+  using T = Vec::value_type;
+  static constexpr Dist unreached{std::numeric_limits<Dist>::max()};
+
+  grid<Dist, Vec::ndim, T> distances;
+  std::vector<std::uint64_t> visited;
+
+public:
+  dense_storage(const Vec& origin, const Vec& extent)
+      : distances(origin, extent, unreached), visited((distances.size() + 63) / 64) {}
+
+  void reset_visited() { std::ranges::fill(visited, std::uint64_t{}); }
+  void reset_distances() { distances.fill(unreached); }
+
+  [[nodiscard]] bool contains(const Vec& p) const noexcept {
+    return distances.contains(p);
+  }
+
+  // Marks p visited and returns true if it was not visited before.
+  bool visit(const Vec& p) noexcept {
+    const std::size_t i{distances.index(p)};
+    const std::uint64_t bit{std::uint64_t{1} << (i % 64)};
+    return not(std::exchange(visited[i / 64], visited[i / 64] | bit) & bit);
+  }
+
+  [[nodiscard]] Dist& distance(const Vec& p) noexcept { return distances[p]; }
+};
+
+// Node state for unbounded searches, in flat hash tables that keep their capacity over
+// resets.
+template <searchable Vec, std::integral Dist> class hashed_storage {
+  static constexpr Dist unreached{std::numeric_limits<Dist>::max()};
+
+  flat_map<Vec, Dist> distances;
+  flat_set<Vec> visited;
+
+public:
+  void reset_visited() { visited.clear(); }
+  void reset_distances() { distances.clear(); }
+
+  [[nodiscard]] constexpr bool contains(const Vec&) const noexcept { return true; }
+
+  bool visit(const Vec& p) { return visited.insert(p).second; }
+
+  [[nodiscard]] Dist& distance(const Vec& p) {
+    return distances.try_emplace(p, unreached).first->second;
+  }
+};
+
+namespace detail {
+
+struct no_visit {
+  template <typename Vec, typename Dist>
+  constexpr void operator()(const Vec&, Dist) const {}
+};
+
+template <typename Visit, typename Vec, typename Dist>
+constexpr bool stops(Visit& visit, const Vec& p, Dist dist) {
+  if constexpr (std::is_void_v<std::invoke_result_t<Visit&, const Vec&, Dist>>) {
+    std::invoke(visit, p, dist);
+    return false;
+  } else {
+    return static_cast<bool>(std::invoke(visit, p, dist));
+  }
+}
+
+} // namespace detail
+
+// Search state that is kept between calls, so that repeated searches reuse the visited
+// set, the distance map and the frontier buffers instead of allocating them again.
+template <
+    searchable Vec,
+    std::integral Dist = int,
+    typename Storage = hashed_storage<Vec, Dist>>
+class engine {
+  Storage storage;
+  std::vector<Vec> frontier;
+  std::vector<Vec> next_frontier;
+  std::deque<std::pair<Vec, Dist>> deque;
+  std::vector<std::vector<Vec>> buckets;
+
+  template <typename Weight>
+  std::optional<Dist> step_weight(Weight& weight, const Vec& from, const Vec& to) {
+    if (not storage.contains(to)) {
+      return std::nullopt;
+    }
+    return std::invoke(weight, from, to);
+  }
+
+  template <typename Open> bool enter(Open& is_open, const Vec& p) {
+    return storage.contains(p) and std::invoke(is_open, p) and storage.visit(p);
+  }
+
+  [[nodiscard]] std::vector<Vec>& bucket(Dist key) noexcept {
+    return buckets[static_cast<std::size_t>(key) % buckets.size()];
+  }
+
+  void reset_buckets(Dist count) {
+    buckets.resize(static_cast<std::size_t>(count));
+    for (std::vector<Vec>& b : buckets) {
+      b.clear();
+    }
+  }
+
+public:
+  engine()
+    requires std::default_initializable<Storage>
+  = default;
+
+  explicit engine(Storage storage) : storage{std::move(storage)} {}
+
+  // Search over the box [origin, origin + extent).
+  engine(const Vec& origin, const Vec& extent)
+    requires std::constructible_from<Storage, const Vec&, const Vec&>
+      : storage(origin, extent) {}
+
+  // Breadth-first search over open nodes, level by level.
+  template <std::predicate<const Vec&> Open, typename Visit = detail::no_visit>
+  std::optional<Dist>
+  bfs(std::span<const Vec> starts, Open&& is_open, Visit&& visit = {}) {
+    storage.reset_visited();
+    frontier.clear();
+    for (const Vec& s : starts) {
+      if (enter(is_open, s)) {
+        frontier.push_back(s);
+      }
+    }
+    for (Dist dist{}; not frontier.empty(); ++dist) {
+      next_frontier.clear();
+      for (const Vec& p : frontier) {
+        if (detail::stops(visit, p, dist)) {
+          return dist;
+        }
+        for (const Vec& adj : p.adjacent()) {
+          if (enter(is_open, adj)) {
+            next_frontier.push_back(adj);
+          }
+        }
+      }
+      frontier.swap(next_frontier);
+    }
+    return std::nullopt;
+  }
+
+  template <std::predicate<const Vec&> Open, typename Visit = detail::no_visit>
+  std::optional<Dist> bfs(const Vec& start, Open&& is_open, Visit&& visit = {}) {
+    return bfs(std::span(&start, 1), is_open, visit);
+  }
+
+  // Shortest paths where every step costs 0 or 1, with a double-ended queue.
+  template <typename Weight, typename Visit = detail::no_visit>
+  std::optional<Dist> bfs01(const Vec& start, Weight&& weight, Visit&& visit = {}) {
+    storage.reset_visited();
+    storage.reset_distances();
+    deque.clear();
+    if (storage.contains(start)) {
+      storage.distance(start) = 0;
+      deque.emplace_back(start, 0);
+    }
+    while (not deque.empty()) {
+      const auto [p, dist]{deque.front()};
+      deque.pop_front();
+      if (not storage.visit(p)) {
+        continue;
+      }
+      if (detail::stops(visit, p, dist)) {
+        return dist;
+      }
+      for (const Vec& adj : p.adjacent()) {
+        if (auto w{step_weight(weight, p, adj)}) {
+          if (*w < 0 or *w > 1) {
+            throw std::out_of_range("bfs01 step weight must be 0 or 1");
+          }
+          if (Dist& best{storage.distance(adj)}; dist + *w < best) {
+            best = dist + *w;
+            if (*w == 0) {
+              deque.emplace_front(adj, best);
+            } else {
+              deque.emplace_back(adj, best);
+            }
+          }
+        }
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Dijkstra's algorithm with a circular bucket queue (Dial's algorithm), for step
+  // weights in [0, max_weight]. Popping the next node is amortized O(1) instead of
+  // O(log n).
+  template <typename Weight, typename Visit = detail::no_visit>
+  std::optional<Dist>
+  dijkstra(const Vec& start, Weight&& weight, Dist max_weight, Visit&& visit = {}) {
+    storage.reset_visited();
+    storage.reset_distances();
+    reset_buckets(max_weight + 1);
+    std::size_t pending{};
+    if (storage.contains(start)) {
+      storage.distance(start) = 0;
+      bucket(0).push_back(start);
+      ++pending;
+    }
+    for (Dist dist{}; pending > 0; ++dist) {
+      // steps of weight 0 append to the bucket that is being drained
+      std::vector<Vec>& current{bucket(dist)};
+      for (std::size_t i{}; i < current.size(); ++i) {
+        const Vec p{current[i]};
+        --pending;
+        if (storage.distance(p) != dist or not storage.visit(p)) {
+          continue;
+        }
+        if (detail::stops(visit, p, dist)) {
+          return dist;
+        }
+        for (const Vec& adj : p.adjacent()) {
+          if (auto w{step_weight(weight, p, adj)}) {
+            if (*w < 0 or *w > max_weight) {
+              throw std::out_of_range("dijkstra step weight must be in [0, max_weight]");
+            }
+            if (Dist& best{storage.distance(adj)}; dist + *w < best) {
+              best = dist + *w;
+              bucket(best).push_back(adj);
+              ++pending;
+            }
+          }
+        }
+      }
+      current.clear();
+    }
+    return std::nullopt;
+  }
+
+  // A* search from start to goal with the Manhattan distance as heuristic, for step
+  // weights in [1, max_weight]. Because adjacent() steps change the heuristic by at most
+  // 1, it is consistent and the nodes can be kept in a bucket queue by estimated length.
+  template <typename Weight>
+  std::optional<Dist>
+  astar(const Vec& start, const Vec& goal, Weight&& weight, Dist max_weight) {
+    storage.reset_visited();
+    storage.reset_distances();
+    reset_buckets(max_weight + 2);
+    auto heuristic{[&goal](const Vec& p) { return static_cast<Dist>(p.distance(goal)); }};
+    std::size_t pending{};
+    if (not storage.contains(start)) {
+      return std::nullopt;
+    }
+    storage.distance(start) = 0;
+    bucket(heuristic(start)).push_back(start);
+    ++pending;
+    for (Dist estimate{heuristic(start)}; pending > 0; ++estimate) {
+      std::vector<Vec>& current{bucket(estimate)};
+      for (std::size_t i{}; i < current.size(); ++i) {
+        const Vec p{current[i]};
+        --pending;
+        const Dist dist{storage.distance(p)};
+        if (dist + heuristic(p) != estimate or not storage.visit(p)) {
+          continue;
+        }
+        if (p == goal) {
+          return dist;
+        }
+        for (const Vec& adj : p.adjacent()) {
+          if (auto w{step_weight(weight, p, adj)}) {
+            if (*w < 1 or *w > max_weight) {
+              throw std::out_of_range("astar step weight must be in [1, max_weight]");
+            }
+            if (Dist& best{storage.distance(adj)}; dist + *w < best) {
+              best = dist + *w;
+              bucket(best + heuristic(adj)).push_back(adj);
+              ++pending;
+            }
+          }
+        }
+      }
+      current.clear();
+    }
+    return std::nullopt;
+  }
+};
+
+template <searchable Vec, std::integral Dist = int>
+using dense_engine = engine<Vec, Dist, dense_storage<Vec, Dist>>;
+
+template <searchable Vec, std::integral Dist = int>
+using hashed_engine = engine<Vec, Dist, hashed_storage<Vec, Dist>>;
+
+} // namespace ndvec::search
+
+#endif // NDVEC_SEARCH_HEADER_INCLUDED
@@ -0,0 +1,513 @@
+#ifndef NDVEC_SOA_VECTOR_HEADER_INCLUDED
+#define NDVEC_SOA_VECTOR_HEADER_INCLUDED
+
+#include <array>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ndvec.hpp"
+
+namespace ndvec {
+
+template <typename T, std::size_t alignment = 64> struct aligned_allocator {
+  static_assert(alignment >= alignof(T) and std::has_single_bit(alignment));
+
+  using value_type = T;
+
+  template <typename U> struct rebind {
+    using other = aligned_allocator<U, alignment>;
+  };
+
+  constexpr aligned_allocator() noexcept = default;
+
+  template <typename U>
+  constexpr aligned_allocator(const aligned_allocator<U, alignment>&) noexcept {}
+
+  [[nodiscard]] T* allocate(std::size_t n) {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignment}));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    ::operator delete(p, n * sizeof(T), std::align_val_t{alignment});
+  }
+
+  template <typename U>
+  constexpr bool operator==(const aligned_allocator<U, alignment>&) const noexcept {
+    return true;
+  }
+};
+
+template <typename Vec> class soa_vector;
+
+// Stores each axis of a sequence of ndvecs in its own contiguous, 64-byte aligned
+// column so that per-axis loops compile to packed SIMD instructions.
+template <typename T, typename... Ts> class soa_vector<ndvec<T, Ts...>> {
+public:
+  using vec = ndvec<T, Ts...>;
+  using value_type = vec;
+  using axis_type = vec::value_type;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using column_type = std::vector<axis_type, aligned_allocator<axis_type>>;
+
+  static constexpr std::size_t ndim{vec::ndim};
+
+private:
+  std::array<column_type, ndim> columns{};
+
+  template <typename Fn, std::size_t... axes>
+  static constexpr vec make_vec(Fn&& fn, std::index_sequence<axes...>) {
+    return vec(fn(axes)...);
+  }
+
+public:
+  class reference {
+    friend soa_vector;
+
+    soa_vector* self{};
+    size_type index{};
+
+    constexpr reference(soa_vector* self, size_type index) noexcept
+        : self{self}, index{index} {}
+
+  public:
+    constexpr reference(const reference&) noexcept = default;
+
+    template <std::size_t axis>
+      requires(axis < ndim)
+    constexpr axis_type& get() const noexcept {
+      return self->columns[axis][index];
+    }
+
+    constexpr axis_type& x() const noexcept { return get<0>(); }
+    constexpr axis_type& y() const noexcept { return get<1>(); }
+    constexpr axis_type& z() const noexcept { return get<2>(); }
+    constexpr axis_type& w() const noexcept { return get<3>(); }
+
+    constexpr operator vec() const noexcept {
+      return make_vec(
+          [this](std::size_t axis) { return self->columns[axis][index]; },
+          typename vec::axes_indices{}
+      );
+    }
+
+    constexpr const reference& operator=(const vec& v) const noexcept {
+      [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+        ((self->columns[axes][index] = v.template get<axes>()), ...);
+      }(typename vec::axes_indices{});
+      return *this;
+    }
+
+    constexpr const reference& operator=(const reference& other) const noexcept {
+      return *this = vec(other);
+    }
+
+    constexpr const reference& operator+=(const vec& rhs) const noexcept {
+      return *this = vec(*this) + rhs;
+    }
+
+    constexpr const reference& operator-=(const vec& rhs) const noexcept {
+      return *this = vec(*this) - rhs;
+    }
+
+    [[nodiscard]] constexpr bool operator==(const vec& rhs) const noexcept {
+      return vec(*this) == rhs;
+    }
+  };
+
+  template <bool is_const> class iterator_impl {
+    friend soa_vector;
+
+  public:
+    using value_type = vec;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<is_const, vec, soa_vector::reference>;
+    using iterator_category = std::input_iterator_tag;
+    using iterator_concept = std::random_access_iterator_tag;
+
+  private:
+    using container = std::conditional_t<is_const, const soa_vector, soa_vector>;
+
+    container* self{};
+    difference_type index{};
+
+    constexpr iterator_impl(container* self, difference_type index) noexcept
+        : self{self}, index{index} {}
+
+  public:
+    constexpr iterator_impl() noexcept = default;
+
+    constexpr reference operator*() const noexcept { return (*self)[index]; }
+    constexpr reference operator[](difference_type n) const noexcept {
+      return (*self)[index + n];
+    }
+
+    constexpr iterator_impl& operator++() noexcept {
+      ++index;
+      return *this;
+    }
+    constexpr iterator_impl operator++(int) noexcept { return {self, index++}; }
+    constexpr iterator_impl& operator--() noexcept {
+      --index;
+      return *this;
+    }
+    constexpr iterator_impl operator--(int) noexcept { return {self, index--}; }
+
+    constexpr iterator_impl& operator+=(difference_type n) noexcept {
+      index += n;
+      return *this;
+    }
+    constexpr iterator_impl& operator-=(difference_type n) noexcept {
+      index -= n;
+      return *this;
+    }
+    friend constexpr iterator_impl
+    operator+(iterator_impl it, difference_type n) noexcept {
+      return it += n;
+    }
+    friend constexpr iterator_impl
+    operator+(difference_type n, iterator_impl it) noexcept {
+      return it += n;
+    }
+    friend constexpr iterator_impl
+    operator-(iterator_impl it, difference_type n) noexcept {
+      return it -= n;
+    }
+    friend constexpr difference_type
+    operator-(const iterator_impl& lhs, const iterator_impl& rhs) noexcept {
+      return lhs.index - rhs.index;
+    }
+
+    friend constexpr bool
+    operator==(const iterator_impl& lhs, const iterator_impl& rhs) noexcept {
+      return lhs.index == rhs.index;
+    }
+    friend constexpr auto
+    operator<=>(const iterator_impl& lhs, const iterator_impl& rhs) noexcept {
+      return lhs.index <=> rhs.index;
+    }
+  };
+
+  using iterator = iterator_impl<false>;
+  using const_iterator = iterator_impl<true>;
+
+  constexpr soa_vector() = default;
+
+  constexpr explicit soa_vector(size_type n) {
+    for (column_type& col : columns) {
+      col.resize(n);
+    }
+  }
+
+  template <std::ranges::input_range R>
+    requires(
+        std::convertible_to<std::ranges::range_reference_t<R>, vec>
+        and not std::same_as<std::remove_cvref_t<R>, soa_vector>
+    )
+  constexpr explicit soa_vector(R&& points) {
+    if constexpr (std::ranges::sized_range<R>) {
+      reserve(std::ranges::size(points));
+    }
+    for (const vec& p : points) {
+      push_back(p);
+    }
+  }
+
+  [[nodiscard]] constexpr size_type size() const noexcept { return columns[0].size(); }
+  [[nodiscard]] constexpr bool empty() const noexcept { return columns[0].empty(); }
+
+  constexpr void reserve(size_type n) {
+    for (column_type& col : columns) {
+      col.reserve(n);
+    }
+  }
+
+  constexpr void resize(size_type n) {
+    for (column_type& col : columns) {
+      col.resize(n);
+    }
+  }
+
+  constexpr void clear() noexcept {
+    for (column_type& col : columns) {
+      col.clear();
+    }
+  }
+
+  constexpr void push_back(const vec& v) {
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      (columns[axes].push_back(v.template get<axes>()), ...);
+    }(typename vec::axes_indices{});
+  }
+
+  template <typename... Args>
+    requires std::constructible_from<vec, Args...>
+  constexpr reference emplace_back(Args&&... args) {
+    push_back(vec(std::forward<Args>(args)...));
+    return back();
+  }
+
+  constexpr void pop_back() noexcept {
+    for (column_type& col : columns) {
+      col.pop_back();
+    }
+  }
+
+  [[nodiscard]] constexpr reference operator[](size_type i) noexcept { return {this, i}; }
+
+  [[nodiscard]] constexpr vec operator[](size_type i) const noexcept {
+    return make_vec(
+        [this, i](std::size_t axis) { return columns[axis][i]; },
+        typename vec::axes_indices{}
+    );
+  }
+
+  [[nodiscard]] constexpr reference at(size_type i) {
+    if (i >= size()) {
+      throw std::out_of_range("soa_vector::at index out of range");
+    }
+    return (*this)[i];
+  }
+
+  [[nodiscard]] constexpr vec at(size_type i) const {
+    if (i >= size()) {
+      throw std::out_of_range("soa_vector::at index out of range");
+    }
+    return (*this)[i];
+  }
+
+  [[nodiscard]] constexpr reference back() noexcept { return (*this)[size() - 1]; }
+  [[nodiscard]] constexpr vec back() const noexcept { return (*this)[size() - 1]; }
+
+  template <std::size_t axis>
+    requires(axis < ndim)
+  [[nodiscard]] constexpr std::span<axis_type> axis_data() noexcept {
+    return columns[axis];
+  }
+
+  template <std::size_t axis>
+    requires(axis < ndim)
+  [[nodiscard]] constexpr std::span<const axis_type> axis_data() const noexcept {
+    return columns[axis];
+  }
+
+  [[nodiscard]] constexpr std::span<axis_type> axis_data(std::size_t axis) noexcept {
+    return columns[axis];
+  }
+
+  [[nodiscard]] constexpr std::span<const axis_type> axis_data(std::size_t axis
+  ) const noexcept {
+    return columns[axis];
+  }
+
+  [[nodiscard]] constexpr iterator begin() noexcept { return {this, 0}; }
+  [[nodiscard]] constexpr iterator end() noexcept {
+    return {this, static_cast<difference_type>(size())};
+  }
+  [[nodiscard]] constexpr const_iterator begin() const noexcept { return {this, 0}; }
+  [[nodiscard]] constexpr const_iterator end() const noexcept {
+    return {this, static_cast<difference_type>(size())};
+  }
+
+  [[nodiscard]] constexpr bool operator==(const soa_vector&) const = default;
+
+  template <std::regular_invocable<axis_type> UnaryFn>
+  constexpr soa_vector& apply(UnaryFn&& fn) noexcept {
+    for (column_type& col : columns) {
+      for (axis_type& val : col) {
+        val = fn(val);
+      }
+    }
+    return *this;
+  }
+
+  template <std::regular_invocable<axis_type, axis_type> BinaryFn>
+  constexpr soa_vector& apply(BinaryFn&& fn, const vec& rhs) noexcept {
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      (apply_column(fn, columns[axes], rhs.template get<axes>()), ...);
+    }(typename vec::axes_indices{});
+    return *this;
+  }
+
+  // Throws std::invalid_argument if rhs has a different size.
+  template <std::regular_invocable<axis_type, axis_type> BinaryFn>
+  constexpr soa_vector& apply(BinaryFn&& fn, const soa_vector& rhs) {
+    if (rhs.size() != size()) {
+      throw std::invalid_argument("soa_vector::apply sizes differ");
+    }
+    for (std::size_t axis{}; axis < ndim; ++axis) {
+      axis_type* lhs_col{columns[axis].data()};
+      const axis_type* rhs_col{rhs.columns[axis].data()};
+      for (size_type i{}; i < size(); ++i) {
+        lhs_col[i] = fn(lhs_col[i], rhs_col[i]);
+      }
+    }
+    return *this;
+  }
+
+private:
+  template <typename BinaryFn>
+  static constexpr void
+  apply_column(BinaryFn& fn, column_type& col, axis_type rhs) noexcept {
+    for (axis_type& val : col) {
+      val = fn(val, rhs);
+    }
+  }
+
+public:
+  constexpr soa_vector& operator+=(const vec& rhs) noexcept {
+    return apply(std::plus<axis_type>{}, rhs);
+  }
+  constexpr soa_vector& operator-=(const vec& rhs) noexcept {
+    return apply(std::minus<axis_type>{}, rhs);
+  }
+  constexpr soa_vector& operator*=(const vec& rhs) noexcept {
+    return apply(std::multiplies<axis_type>{}, rhs);
+  }
+  constexpr soa_vector& operator/=(const vec& rhs) noexcept {
+    return apply(std::divides<axis_type>{}, rhs);
+  }
+
+  constexpr soa_vector& operator+=(const soa_vector& rhs) {
+    return apply(std::plus<axis_type>{}, rhs);
+  }
+  constexpr soa_vector& operator-=(const soa_vector& rhs) {
+    return apply(std::minus<axis_type>{}, rhs);
+  }
+  constexpr soa_vector& operator*=(const soa_vector& rhs) {
+    return apply(std::multiplies<axis_type>{}, rhs);
+  }
+  constexpr soa_vector& operator/=(const soa_vector& rhs) {
+    return apply(std::divides<axis_type>{}, rhs);
+  }
+
+  [[nodiscard]] constexpr soa_vector min(const vec& rhs) const {
+    soa_vector lhs{*this};
+    return lhs.apply(
+        [](axis_type a, axis_type b) constexpr noexcept -> axis_type {
+          return std::min(a, b);
+        },
+        rhs
+    );
+  }
+
+  [[nodiscard]] constexpr soa_vector max(const vec& rhs) const {
+    soa_vector lhs{*this};
+    return lhs.apply(
+        [](axis_type a, axis_type b) constexpr noexcept -> axis_type {
+          return std::max(a, b);
+        },
+        rhs
+    );
+  }
+
+  [[nodiscard]] constexpr soa_vector abs() const {
+    soa_vector res{*this};
+    return res.apply([](axis_type val) constexpr noexcept -> axis_type {
+      return val < 0 ? -val : val;
+    });
+  }
+
+  [[nodiscard]] constexpr soa_vector signum() const {
+    soa_vector res{*this};
+    return res.apply([](axis_type val) constexpr noexcept -> axis_type {
+      return (axis_type{} < val) - (val < axis_type{});
+    });
+  }
+
+  // The reductions below write one value per point, out[i] = (*this)[i].op(rhs), and
+  // walk the columns one axis at a time. They throw std::invalid_argument if out is
+  // shorter than size().
+  constexpr void sum(std::span<axis_type> out) const {
+    check_output(out);
+    std::ranges::copy(columns[0], out.begin());
+    for (std::size_t axis{1}; axis < ndim; ++axis) {
+      const axis_type* col{columns[axis].data()};
+      for (size_type i{}; i < size(); ++i) {
+        out[i] += col[i];
+      }
+    }
+  }
+
+  constexpr void dot(const vec& rhs, std::span<axis_type> out) const {
+    check_output(out);
+    std::ranges::fill(out.first(size()), axis_type{});
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      (accumulate_column(
+           out,
+           columns[axes],
+           rhs.template get<axes>(),
+           detail::wrapping_mul<axis_type>
+       ),
+       ...);
+    }(typename vec::axes_indices{});
+  }
+
+  constexpr void distance(const vec& rhs, std::span<axis_type> out) const {
+    check_output(out);
+    std::ranges::fill(out.first(size()), axis_type{});
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      (accumulate_column(
+           out,
+           columns[axes],
+           rhs.template get<axes>(),
+           detail::wrapping_abs_diff<axis_type>
+       ),
+       ...);
+    }(typename vec::axes_indices{});
+  }
+
+  [[nodiscard]] constexpr std::vector<axis_type> sum() const {
+    std::vector<axis_type> out(size());
+    sum(out);
+    return out;
+  }
+
+  [[nodiscard]] constexpr std::vector<axis_type> dot(const vec& rhs) const {
+    std::vector<axis_type> out(size());
+    dot(rhs, out);
+    return out;
+  }
+
+  [[nodiscard]] constexpr std::vector<axis_type> distance(const vec& rhs) const {
+    std::vector<axis_type> out(size());
+    distance(rhs, out);
+    return out;
+  }
+
+private:
+  constexpr void check_output(std::span<axis_type> out) const {
+    if (out.size() < size()) {
+      throw std::invalid_argument("soa_vector output span is shorter than the vector");
+    }
+  }
+
+  template <typename BinaryFn>
+  constexpr void accumulate_column(
+      std::span<axis_type> out,
+      const column_type& col,
+      axis_type rhs,
+      BinaryFn&& fn
+  ) const noexcept {
+    const axis_type* src{col.data()};
+    for (size_type i{}; i < size(); ++i) {
+      out[i] += fn(src[i], rhs);
+    }
+  }
+};
+
+template <std::ranges::input_range R>
+soa_vector(R&&) -> soa_vector<std::ranges::range_value_t<R>>;
+
+} // namespace ndvec
+
+#endif // NDVEC_SOA_VECTOR_HEADER_INCLUDED
@@ -0,0 +1,242 @@
+#ifndef NDVEC_SPARSE_GRID_HEADER_INCLUDED
+#define NDVEC_SPARSE_GRID_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "flat_hash.hpp"
+#include "ndvec.hpp"
+
+namespace ndvec {
+
+// Unbounded grid of cells stored as dense chunks of 2^chunk_bits cells along every axis,
+// e.g. 64x64 in 2D and 16x16x16 in 3D, so memory follows the occupied area instead of
+// its bounding box. A flat_map takes a chunk coordinate to a page, an array of its cells
+// that stays in place while other chunks are allocated, and the page of the last chunk looked up is cached, so walking from a cell to its
+// neighbours mostly skips the hash lookup. Within a chunk axis 0 varies fastest, like
+// grid. Cells outside the allocated chunks read as the background value.
+//
+// The cache is updated by const lookups too, so even reads must not run concurrently.
+template <
+    typename Cell,
+    std::size_t ndim,
+    std::size_t chunk_bits = (ndim <= 2 ? 6 : 4),
+    std::integral T = int>
+  requires(ndim > 0 and chunk_bits > 0 and chunk_bits * ndim < 32
+           and chunk_bits < 8 * sizeof(T) - 1)
+class sparse_grid {
+public:
+  using vec = vecn<T, ndim>;
+  using value_type = Cell;
+  using size_type = std::size_t;
+
+  static constexpr T chunk_side{T{1} << chunk_bits};
+  static constexpr size_type chunk_cells{size_type{1} << (chunk_bits * ndim)};
+
+  using chunk_span = std::span<Cell, chunk_cells>;
+  using const_chunk_span = std::span<const Cell, chunk_cells>;
+
+private:
+  using unsigned_type = std::make_unsigned_t<T>;
+
+  static constexpr unsigned_type local_mask{chunk_side - 1};
+  static constexpr size_type no_page{std::numeric_limits<size_type>::max()};
+
+  using page_type = std::array<Cell, chunk_cells>;
+
+  // chunk coordinate -> index into pages_, a deque so that growing it keeps the cells
+  // of the other pages in place
+  flat_map<vec, size_type> chunks_{};
+  std::deque<page_type> pages_{};
+  std::vector<size_type> free_pages_{};
+  Cell background_{};
+  mutable vec cached_chunk_{};
+  mutable size_type cached_page_{no_page};
+
+  [[nodiscard]] constexpr size_type find_page(const vec& chunk) const noexcept {
+    if (cached_page_ != no_page and cached_chunk_ == chunk) {
+      return cached_page_;
+    }
+    const auto it{chunks_.find(chunk)};
+    if (it == chunks_.end()) {
+      return no_page;
+    }
+    cached_chunk_ = chunk;
+    return cached_page_ = it->second;
+  }
+
+  // Takes a page from the pool if there is one, so erasing and allocating chunks in a
+  // steady state does not allocate memory.
+  constexpr size_type allocate_page(const vec& chunk) {
+    size_type page{};
+    if (free_pages_.empty()) {
+      page = pages_.size();
+      pages_.emplace_back().fill(background_);
+    } else {
+      page = free_pages_.back();
+      free_pages_.pop_back();
+      pages_[page].fill(background_);
+    }
+    chunks_.insert({chunk, page});
+    cached_chunk_ = chunk;
+    return cached_page_ = page;
+  }
+
+public:
+  constexpr sparse_grid() = default;
+
+  constexpr explicit sparse_grid(const Cell& background) : background_{background} {}
+
+  // The chunk containing p, rounding towards negative infinity along every axis.
+  [[nodiscard]] static constexpr vec chunk_of(vec p) noexcept {
+    return p.apply([](T v) { return static_cast<T>(v >> chunk_bits); });
+  }
+
+  [[nodiscard]] static constexpr vec chunk_origin(vec chunk) noexcept {
+    return chunk.apply([](T v) { return static_cast<T>(v * chunk_side); });
+  }
+
+  // Index of p within the cells of its chunk.
+  [[nodiscard]] static constexpr size_type local_index(const vec& p) noexcept {
+    return [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      return (
+          ...
+          | (static_cast<size_type>(
+                 static_cast<unsigned_type>(p.template get<axes>()) & local_mask
+             )
+             << (axes * chunk_bits))
+      );
+    }(typename vec::axes_indices{});
+  }
+
+  // Position of cell i of the chunk starting at origin, the inverse of local_index.
+  [[nodiscard]] static constexpr vec
+  cell_position(const vec& origin, size_type i) noexcept {
+    vec p;
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      ((p.template get<axes>() = static_cast<T>(
+            origin.template get<axes>()
+            + static_cast<T>((i >> (axes * chunk_bits)) & local_mask)
+        )),
+       ...);
+    }(typename vec::axes_indices{});
+    return p;
+  }
+
+  [[nodiscard]] constexpr const Cell& background() const noexcept { return background_; }
+  [[nodiscard]] constexpr size_type chunk_count() const noexcept { return chunks_.size(); }
+  [[nodiscard]] constexpr size_type pooled_chunks() const noexcept {
+    return free_pages_.size();
+  }
+  // number of allocated cells, background or not
+  [[nodiscard]] constexpr size_type size() const noexcept {
+    return chunks_.size() * chunk_cells;
+  }
+  [[nodiscard]] constexpr bool empty() const noexcept { return chunks_.empty(); }
+
+  [[nodiscard]] constexpr bool allocated(const vec& p) const noexcept {
+    return find_page(chunk_of(p)) != no_page;
+  }
+
+  // The cell at p, or the background value if its chunk is not allocated.
+  [[nodiscard]] constexpr const Cell& operator[](const vec& p) const noexcept {
+    const size_type page{find_page(chunk_of(p))};
+    return page == no_page ? background_ : pages_[page][local_index(p)];
+  }
+
+  // The cell at p, allocating its chunk filled with the background value if needed.
+  // References to cells stay valid when other chunks are allocated, so g[a] = g[b] is
+  // fine, until the chunk of the cell is erased or cleared, or shrink_to_fit is called.
+  [[nodiscard]] constexpr Cell& operator[](const vec& p) {
+    const vec chunk{chunk_of(p)};
+    size_type page{find_page(chunk)};
+    if (page == no_page) {
+      page = allocate_page(chunk);
+    }
+    return pages_[page][local_index(p)];
+  }
+
+  // Returns the chunk to the pool, returns the number of chunks erased.
+  constexpr size_type erase_chunk(const vec& chunk) {
+    const auto it{chunks_.find(chunk)};
+    if (it == chunks_.end()) {
+      return 0;
+    }
+    free_pages_.push_back(it->second);
+    chunks_.erase(chunk);
+    cached_page_ = no_page;
+    return 1;
+  }
+
+  // Erases the chunks whose cells all equal the background value, e.g. after a step of a
+  // simulation, and returns their number.
+  constexpr size_type erase_background_chunks()
+    requires std::equality_comparable<Cell>
+  {
+    std::vector<vec> background_chunks;
+    for (const auto& [chunk, page] : chunks_) {
+      if (std::ranges::all_of(pages_[page], [this](const Cell& c) {
+            return c == background_;
+          })) {
+        background_chunks.push_back(chunk);
+      }
+    }
+    for (const vec& chunk : background_chunks) {
+      erase_chunk(chunk);
+    }
+    return background_chunks.size();
+  }
+
+  // Returns all chunks to the pool.
+  constexpr void clear() {
+    for (const auto& [chunk, page] : chunks_) {
+      free_pages_.push_back(page);
+    }
+    chunks_.clear();
+    cached_page_ = no_page;
+  }
+
+  // Frees the pool. The allocated pages are moved, which invalidates references to cells.
+  constexpr void shrink_to_fit() {
+    std::deque<page_type> pages;
+    flat_map<vec, size_type> chunks;
+    chunks.reserve(chunks_.size());
+    for (const auto& [chunk, page] : chunks_) {
+      chunks.insert({chunk, pages.size()});
+      pages.push_back(std::move(pages_[page]));
+    }
+    pages_ = std::move(pages);
+    chunks_ = std::move(chunks);
+    free_pages_ = {};
+    cached_page_ = no_page;
+  }
+
+  // Calls fn(origin, cells) for every allocated chunk in unspecified order, where cells is
+  // a span of chunk_cells cells and cell i is at cell_position(origin, i). The spans stay
+  // valid as long as references from operator[] do.
+  template <std::invocable<const vec&, chunk_span> Fn>
+  constexpr void for_each_chunk(Fn&& fn) {
+    for (const auto& [chunk, page] : chunks_) {
+      fn(chunk_origin(chunk), chunk_span(pages_[page]));
+    }
+  }
+
+  template <std::invocable<const vec&, const_chunk_span> Fn>
+  constexpr void for_each_chunk(Fn&& fn) const {
+    for (const auto& [chunk, page] : chunks_) {
+      fn(chunk_origin(chunk), const_chunk_span(pages_[page]));
+    }
+  }
+};
+
+} // namespace ndvec
+
+#endif // NDVEC_SPARSE_GRID_HEADER_INCLUDED
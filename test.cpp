@@ -1,13 +1,56 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
 #include <format>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <numbers>
+#include <numeric>
+#include <optional>
 #include <ranges>
+#include <set>
+#include <span>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <typeinfo>
 #include <utility>
 #include <vector>
 
+#include "automaton.hpp"
+#include "batch.hpp"
+#include "bitgrid.hpp"
+#include "cell_list.hpp"
+#include "curve.hpp"
+#include "expr.hpp"
+#include "flat_hash.hpp"
+#include "grid.hpp"
+#include "hash_quality.hpp"
+#include "instrument.hpp"
+#include "kdtree.hpp"
+#include "mat.hpp"
 #include "ndvec.hpp"
+#include "neighborhood.hpp"
+#include "packed_vec.hpp"
+#include "parallel_bfs.hpp"
+#include "parse.hpp"
+#include "point_file.hpp"
+#include "radix_sort.hpp"
+#include "reduce.hpp"
+#include "search.hpp"
+#include "soa_vector.hpp"
+#include "sparse_grid.hpp"
+#include "zobrist.hpp"
+
+// over-aligned storage, pads vec3<unsigned char> to 4 bytes
+template <>
+struct ndvec::storage_alignment<unsigned char, 3>
+    : std::integral_constant<std::size_t, 4> {};
 
 using std::operator""s;
 
@@ -509,65 +552,52 @@ template <typename T> void test_vec4() {
 
 template <typename T> void test_hash() {
   std::println("test_hash<{}>", demangle<T>());
-  auto hash{std::hash<T>{}};
-  auto width{std::numeric_limits<std::size_t>::digits};
+  using ::ndvec::detail::fmix64;
+  using U = std::make_unsigned_t<T>;
+  constexpr auto width{std::numeric_limits<U>::digits};
   {
     vec1<T> v;
-    assert_equal(std::hash<vec1<T>>{}(v), hash(0), "vec1() hash");
-  }
-  {
-    vec2<T> v;
-    assert_equal(
-        std::hash<vec2<T>>{}(v),
-        hash(0) ^ (hash(0) << (width / 2)),
-        "vec2() hash"
-    );
-  }
-  {
-    vec3<T> v;
-    assert_equal(
-        std::hash<vec3<T>>{}(v),
-        hash(0) ^ (hash(0) << (width / 3)) ^ (hash(0) << (2 * (width / 3))),
-        "vec3() hash"
-    );
-  }
-  {
-    vec4<T> v;
-    assert_equal(
-        std::hash<vec4<T>>{}(v),
-        hash(0) ^ (hash(0) << (width / 4)) ^ (hash(0) << (2 * (width / 4)))
-            ^ (hash(0) << (2 * (width / 4))),
-        "vec4() hash"
-    );
+    assert_equal(std::hash<vec1<T>>{}(v), fmix64(0), "vec1() hash");
   }
   {
     vec1<T> v(0xabc);
-    assert_equal(std::hash<vec1<T>>{}(v), hash(0xabc), "vec1(0xabc) hash");
+    assert_equal(std::hash<vec1<T>>{}(v), fmix64(0xabc), "vec1(0xabc) hash");
   }
-  {
-    vec2<T> v(0xabc, 0x123);
+  if constexpr (2 * width <= 64) {
+    vec2<T> v(0xabc, -0x123);
     assert_equal(
         std::hash<vec2<T>>{}(v),
-        (hash(0xabc) << 0) ^ (hash(0x123) << (width / 2)),
-        "vec2(0xabc, 0x123) hash"
+        fmix64(U{0xabc} | (std::uint64_t{static_cast<U>(-0x123)} << width)),
+        "vec2(0xabc, -0x123) hash"
     );
   }
   {
-    vec3<T> v(0xabc, 0x123, -0xfed);
+    vec3<T> lhs(0xabc, 0x123, -0xfed);
+    vec3<T> rhs(0xabc, 0x123, -0xfed);
     assert_equal(
-        std::hash<vec3<T>>{}(v),
-        (hash(0xabc) << 0) ^ (hash(0x123) << (width / 3))
-            ^ (hash(-0xfed) << ((2 * (width / 3)))),
+        std::hash<vec3<T>>{}(lhs),
+        std::hash<vec3<T>>{}(rhs),
         "vec3(0xabc, 0x123, -0xfed) hash"
     );
   }
   {
-    vec4<T> v(0xabc, 0x123, 0, -0xfed);
-    assert_equal(
-        std::hash<vec4<T>>{}(v),
-        (hash(0xabc) << 0) ^ (hash(0x123) << (width / 4)) ^ (hash(0) << (2 * (width / 4)))
-            ^ (hash(-0xfed) << (3 * (width / 4))),
-        "vec4(0xabc, 0x123, 0, -0xfed) hash"
+    std::vector<std::size_t> hashes, low_bits;
+    for (vec3<T> v(-8, -8, -8); v.x() < 8; v.x() += 1) {
+      for (v.y() = -8; v.y() < 8; v.y() += 1) {
+        for (v.z() = -8; v.z() < 8; v.z() += 1) {
+          hashes.push_back(std::hash<vec3<T>>{}(v));
+          low_bits.push_back(hashes.back() & 0xfff);
+        }
+      }
+    }
+    for (auto* hs : {&hashes, &low_bits}) {
+      std::ranges::sort(*hs);
+      hs->erase(std::ranges::unique(*hs).begin(), hs->end());
+    }
+    assert_equal(hashes.size(), 4096uz, "distinct vec3 hashes in a 16^3 box");
+    assert(
+        low_bits.size() > 2400,
+        std::format("low 12 bits of vec3 hashes take only {} values", low_bits.size())
     );
   }
 }
@@ -580,15 +610,7 @@ template <typename T> void test_vec_hash_collisions() {
   std::vector<std::pair<std::size_t, vec>> seen;
   for (vec v(lo, lo);; v.x() += 1) {
     for (v.y() = lo;; v.y() += 1) {
-      auto h{std::hash<vec>{}(v)};
-      if (auto prev{std::ranges::find_if(seen, [&h](auto&& hv) { return hv.first == h; })
-          };
-          prev != seen.end()) {
-        throw std::runtime_error(
-            std::format("hash '{}' collides for {} and {}", h, v, prev->second)
-        );
-      }
-      seen.emplace_back(h, v);
+      seen.emplace_back(std::hash<vec>{}(v), v);
       if (v.y() == hi) {
         break;
       }
@@ -597,171 +619,2763 @@ template <typename T> void test_vec_hash_collisions() {
       break;
     }
   }
+  std::ranges::sort(seen);
+  if (auto prev{std::ranges::adjacent_find(seen, {}, [](auto&& hv) { return hv.first; })};
+      prev != seen.end()) {
+    throw std::runtime_error(
+        std::format(
+            "hash '{}' collides for {} and {}",
+            prev->first,
+            prev[1].second,
+            prev->second
+        )
+    );
+  }
 }
 
-template <typename... Ts> void test_vec() {
-  (test_vec1<Ts>(), ...);
-  (test_vec2<Ts>(), ...);
-  (test_vec3<Ts>(), ...);
-  (test_vec4<Ts>(), ...);
-}
-
-template <typename T> consteval void test_vec3_compile_time_impl() {
-  static_assert(std::regular<vec3<T>>);
-  {
-    constexpr vec3<T> v;
-    static_assert(v.x() == T{}, "vec3: default init x should be T{}");
-    static_assert(v.y() == T{}, "vec3: default init y should be T{}");
-    static_assert(v.z() == T{}, "vec3: default init z should be T{}");
+template <typename T> void test_hash_quality() {
+  std::println("test_hash_quality<{}>", demangle<T>());
+  {
+    const auto c{hash_quality::collisions({1, 2, 2, 3, 3, 3})};
+    assert_equal(c.keys, 6uz, "hash_quality::collisions keys");
+    assert_equal(c.collisions, 3uz, "hash_quality::collisions of repeated hashes");
+    assert(c.expected < 1e-12, "hash_quality::collisions expected for 64 bits");
+    const auto low{hash_quality::collisions({0x100, 0x200, 0x301}, 8)};
+    assert_equal(low.collisions, 1uz, "hash_quality::collisions of the low 8 bits");
+    const double distinct{256 * (1 - std::pow(255 / 256.0, 3))};
+    assert(
+        std::abs(low.expected - (3 - distinct)) < 1e-9,
+        "hash_quality::collisions expected for 8 bits"
+    );
   }
   {
-    constexpr vec3<T> v(1, 2, 3);
-    static_assert(v.x() == 1, "vec3(1, 2, 3).x() should be 1");
-    static_assert(v.y() == 2, "vec3(1, 2, 3).y() should be 2");
-    static_assert(v.z() == 3, "vec3(1, 2, 3).z() should be 3");
+    std::vector<std::uint64_t> hashes(1024);
+    std::iota(hashes.begin(), hashes.end(), 0);
+    const auto even{hash_quality::bucket_distribution(hashes, 16)};
+    assert_equal(even.chi_square, 0.0, "bucket_distribution of equal buckets");
+    assert(even.z_score < 0, "bucket_distribution z_score of equal buckets");
+    std::ranges::fill(hashes, 7);
+    const auto one{hash_quality::bucket_distribution(hashes, 16)};
+    assert_equal(one.chi_square, 1024.0 * 15, "bucket_distribution of one bucket");
+    bool threw{false};
+    try {
+      (void)hash_quality::bucket_distribution(hashes, 1);
+    } catch (const std::invalid_argument&) {
+      threw = true;
+    }
+    assert(threw, "bucket_distribution with one bucket should throw");
   }
   {
-    constexpr vec3<T> lhs, rhs;
-    static_assert((lhs <=> rhs) == 0, "expected vec3() == vec3()");
+    assert_equal(
+        hash_quality::table_sizes(1000),
+        std::vector<std::size_t>{32, 67, 512, 1009},
+        "hash_quality::table_sizes"
+    );
   }
   {
-    constexpr vec3<T> lhs(-1, 0, 1);
-    constexpr vec3<T> rhs(-1, 0, 1);
-    static_assert((lhs <=> rhs) == 0, "expected vec3(-1, 0, 1) == vec3(-1, 0, 1)");
+    const auto box{hash_quality::dense_box(vec2<T>(-2, -3), vec2<T>(4, 5))};
+    assert_equal(box.size(), 20uz, "hash_quality::dense_box size");
+    assert(
+        std::ranges::all_of(
+            box,
+            [](const vec2<T>& p) {
+              return -2 <= p.x() and p.x() < 2 and -3 <= p.y() and p.y() < 2;
+            }
+        ),
+        "hash_quality::dense_box points in box"
+    );
+    assert_equal(
+        hash_quality::line(vec2<T>(-1, 2), vec2<T>(1, -2), 3),
+        std::vector{vec2<T>(-1, 2), vec2<T>(0, 0), vec2<T>(1, -2)},
+        "hash_quality::line"
+    );
+    const vec3<T> lo(-5, 0, 3), hi(5, 0, 4);
+    const auto random{hash_quality::random_points(100, lo, hi)};
+    assert(
+        std::ranges::all_of(
+            random,
+            [&](const vec3<T>& p) { return lo.max(p) == p and hi.min(p) == p; }
+        ),
+        "hash_quality::random_points in bounds"
+    );
+    assert_equal(
+        random,
+        hash_quality::random_points(100, lo, hi),
+        "hash_quality::random_points of a seed"
+    );
+    const auto clustered{
+        hash_quality::clusters(3, 10, T{2}, vec2<T>(-10, -10), vec2<T>(10, 10))
+    };
+    assert_equal(clustered.size(), 30uz, "hash_quality::clusters size");
+    for (std::size_t i{}; i < clustered.size(); ++i) {
+      assert(
+          (clustered[i] - clustered[i / 10 * 10]).abs().max() <= 4,
+          "hash_quality::clusters radius"
+      );
+    }
+    assert_equal(
+        hash_quality::frontier(std::vector{vec2<T>(0, 0)}),
+        std::vector{vec2<T>(-1, 0), vec2<T>(0, -1), vec2<T>(0, 1), vec2<T>(1, 0)},
+        "hash_quality::frontier of a point"
+    );
+    const auto square{hash_quality::dense_box(vec2<T>(0, 0), vec2<T>(3, 3))};
+    assert_equal(
+        hash_quality::frontier(square).size(),
+        12uz,
+        "hash_quality::frontier of a square"
+    );
   }
   {
-    constexpr vec3<T> lhs(-1, 0, 0);
-    constexpr vec3<T> rhs(-1, 0, 1);
-    static_assert((lhs <=> rhs) < 0, "expected vec3(-1, 0, 0) < vec3(-1, 0, 1)");
-    static_assert((rhs <=> lhs) > 0, "expected vec3(-1, 0, 1) < vec3(-1, 0, 0)");
+    const auto box{hash_quality::dense_box(vec3<T>(-8, -8, -8), vec3<T>(16, 16, 16))};
+    const auto good{hash_quality::analyze(box)};
+    assert_equal(good.keys, 4096uz, "hash_quality::analyze keys");
+    assert_equal(good.full.collisions, 0uz, "hash_quality::analyze std::hash collisions");
+    assert_equal(good.tables.size(), 4uz, "hash_quality::analyze table sizes");
+    assert(
+        std::abs(good.avalanche.mean_flipped - 32) < 1,
+        "std::hash flips half of the bits"
+    );
+    assert(hash_quality::acceptable(good), "std::hash of a box is acceptable");
+
+    auto polynomial{[](const vec3<T>& p) {
+      return (static_cast<std::size_t>(p.x()) * 31 + static_cast<std::size_t>(p.y())) * 31
+             + static_cast<std::size_t>(p.z());
+    }};
+    const auto bad{hash_quality::analyze(box, polynomial)};
+    assert_equal(bad.avalanche.max_bias, 0.5, "polynomial hash avalanche");
+    assert(not hash_quality::acceptable(bad), "polynomial hash of a box is acceptable");
+
+    const auto probes{hash_quality::probe_lengths(
+        std::span(box).first(100),
+        [](const vec3<T>&) { return 7uz; }
+    )};
+    assert_equal(probes.longest, 100uz, "probe_lengths of a constant hash");
+    assert_equal(probes.mean, 50.5, "probe_lengths mean of a constant hash");
+  }
+  {
+    const auto random{
+        hash_quality::random_points(50'000, vec2<T>(-1000, -1000), vec2<T>(1000, 1000))
+    };
+    assert(
+        hash_quality::acceptable(hash_quality::analyze(hash_quality::frontier(random))),
+        "std::hash of a frontier is acceptable"
+    );
   }
-  {
-    constexpr vec3<T> lhs(-2, 0, 2);
-    constexpr vec3<T> rhs(-1, 0, 1);
-    static_assert((lhs <=> rhs) < 0, "expected vec3(-2, 0, 2) < vec3(-1, 0, 1)");
-    static_assert((rhs <=> lhs) > 0, "expected vec3(-1, 0, 1) > vec3(-2, 0, 2)");
+}
+
+template <typename T> void test_soa_vector() {
+  std::println("test_soa_vector<{}>", demangle<T>());
+  using vec = vec3<T>;
+  {
+    soa_vector<vec> points;
+    assert(points.empty(), "soa_vector() should be empty");
+    points.push_back(vec(1, -2, 3));
+    points.emplace_back(-4, 5, -6);
+    assert_equal(points.size(), 2uz, "soa_vector size after 2 inserts");
+    assert_equal(vec(points[0]), vec(1, -2, 3), "soa_vector[0]");
+    assert_equal(vec(points[1]), vec(-4, 5, -6), "soa_vector[1]");
+    assert_equal(points.template axis_data<1>()[1], T{5}, "soa_vector axis 1 column");
+  }
+  {
+    soa_vector<vec> points(3);
+    points[1] = vec(7, 8, 9);
+    points[2].z() = 4;
+    points[0] += vec(1, 1, 1);
+    assert_equal(vec(points[0]), vec(1, 1, 1), "soa_vector proxy +=");
+    assert_equal(vec(points[1]), vec(7, 8, 9), "soa_vector proxy assign");
+    assert_equal(vec(points[2]), vec(0, 0, 4), "soa_vector proxy axis assign");
+  }
+  {
+    std::vector<vec> aos{vec(1, 2, 3), vec(-1, -2, -3), vec(0, 5, -5)};
+    const soa_vector<vec> points(aos);
+    assert_equal(points.size(), aos.size(), "soa_vector from range size");
+    for (std::size_t i{}; i < aos.size(); ++i) {
+      assert_equal(points[i], aos[i], std::format("soa_vector from range [{}]", i));
+    }
+    assert(std::ranges::equal(points, aos), "soa_vector const iteration");
+  }
+  {
+    std::vector<vec> aos{vec(1, 2, 3), vec(-1, -2, -3), vec(0, 5, -5)};
+    const vec rhs(2, -1, 4);
+    soa_vector<vec> points(aos);
+    points += rhs;
+    const soa_vector<vec> lo{points.min(rhs)};
+    const soa_vector<vec> hi{points.max(rhs)};
+    const soa_vector<vec> abs{points.abs()};
+    const soa_vector<vec> sig{points.signum()};
+    for (std::size_t i{}; i < aos.size(); ++i) {
+      vec p{aos[i] + rhs};
+      assert_equal(vec(points[i]), p, std::format("soa_vector += [{}]", i));
+      assert_equal(lo[i], p.min(rhs), std::format("soa_vector min [{}]", i));
+      assert_equal(hi[i], p.max(rhs), std::format("soa_vector max [{}]", i));
+      assert_equal(abs[i], p.abs(), std::format("soa_vector abs [{}]", i));
+      assert_equal(sig[i], p.signum(), std::format("soa_vector signum [{}]", i));
+    }
   }
   {
-    constexpr vec3<T> lhs(1, 2, 3);
-    constexpr vec3<T> rhs(12, 10, 8);
-    constexpr vec3<T> res(13, 12, 11);
-    static_assert((lhs + rhs) == res, "vec3(1, 2, 3) + vec3(12, 10, 8)");
+    std::vector<vec> aos{vec(1, 2, 3), vec(-1, -2, -3), vec(0, 5, -5), vec(9, -9, 1)};
+    const vec rhs(-2, 3, 1);
+    const soa_vector<vec> points(aos);
+    auto sums{points.sum()};
+    auto dots{points.dot(rhs)};
+    auto dists{points.distance(rhs)};
+    for (std::size_t i{}; i < aos.size(); ++i) {
+      assert_equal(sums[i], aos[i].sum(), std::format("soa_vector sum [{}]", i));
+      assert_equal(dots[i], aos[i].dot(rhs), std::format("soa_vector dot [{}]", i));
+      assert_equal(
+          dists[i],
+          aos[i].distance(rhs),
+          std::format("soa_vector distance [{}]", i)
+      );
+    }
   }
   {
-    constexpr vec3<T> lhs(7, 6, 5);
-    constexpr vec3<T> rhs(4, 5, 6);
-    constexpr vec3<T> res(3, 1, -1);
-    static_assert((lhs - rhs) == res, "vec3(7, 6, 5) - vec3(4, 5, 6)");
+    soa_vector<vec> points(3), shorter(2);
+    std::vector<T> out(2);
+    auto throws{[](auto&& fn) {
+      try {
+        fn();
+      } catch (const std::invalid_argument&) {
+        return true;
+      }
+      return false;
+    }};
+    assert(throws([&] { points += shorter; }), "soa_vector += shorter should throw");
+    assert(throws([&] { shorter -= points; }), "soa_vector -= longer should throw");
+    assert(throws([&] { points.sum(out); }), "soa_vector sum to short span should throw");
+    assert(throws([&] { points.dot(vec(), out); }), "soa_vector dot to short span");
+    assert(throws([&] { points.distance(vec(), out); }), "soa_vector distance to short");
+    assert_equal(vec(shorter[1]), vec(), "soa_vector unchanged after size mismatch");
   }
-  {
-    constexpr vec3<T> lhs(1, -2, 0);
-    constexpr vec3<T> rhs(8, 6, 4);
-    constexpr vec3<T> res(8, -12, 0);
-    static_assert((lhs * rhs) == res, "vec3(1, -2, 0) * vec3(8, 6, 4)");
+}
+
+template <typename Vec> void test_batch_impl(std::size_t n) {
+  using T = Vec::value_type;
+  std::vector<Vec> aos;
+  for (std::size_t i{}; i < n; ++i) {
+    Vec p;
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      ((p.template get<axes>() = static_cast<T>((i * (7 + axes) + 3 * axes) % 23) - 11),
+       ...);
+    }(typename Vec::axes_indices{});
+    aos.push_back(p);
+  }
+  const soa_vector<Vec> soa(aos);
+  Vec query;
+  query.x() = 3;
+  query.y() = static_cast<T>(-4);
+  std::vector<T> out_aos(n), out_soa(n);
+  {
+    batch::distance(query, aos, out_aos);
+    batch::distance(query, soa, out_soa);
+    for (std::size_t i{}; i < n; ++i) {
+      auto expected{aos[i].distance(query)};
+      assert_equal(out_aos[i], expected, std::format("AoS distance [{}]", i));
+      assert_equal(out_soa[i], expected, std::format("SoA distance [{}]", i));
+    }
   }
   {
-    constexpr vec3<T> lhs(10, 20, 0);
-    constexpr vec3<T> rhs(10, -5, 3);
-    constexpr vec3<T> res(1, -4, 0);
-    static_assert((lhs / rhs) == res, "vec3(10, 20, 0) / vec3(10, -5, 3)");
+    batch::dot(query, aos, out_aos);
+    batch::dot(query, soa, out_soa);
+    for (std::size_t i{}; i < n; ++i) {
+      assert_equal(out_aos[i], aos[i].dot(query), std::format("AoS dot [{}]", i));
+      assert_equal(out_soa[i], aos[i].dot(query), std::format("SoA dot [{}]", i));
+    }
   }
   {
-    constexpr vec3<T> lhs(10, 20, 0);
-    constexpr vec3<T> rhs(10, -5, 3);
-    constexpr vec3<T> res(10, -5, 0);
-    static_assert(lhs.min(rhs) == res, "vec3(10, 20, 0).min(vec3(10, -5, 3))");
+    batch::squared_l2(query, aos, out_aos);
+    batch::squared_l2(query, soa, out_soa);
+    for (std::size_t i{}; i < n; ++i) {
+      Vec d{aos[i] - query};
+      assert_equal(out_aos[i], d.dot(d), std::format("AoS squared_l2 [{}]", i));
+      assert_equal(out_soa[i], d.dot(d), std::format("SoA squared_l2 [{}]", i));
+    }
   }
   {
-    constexpr vec3<T> lhs(10, 20, 0);
-    constexpr vec3<T> rhs(10, -5, 3);
-    constexpr vec3<T> res(10, 20, 3);
-    static_assert(lhs.max(rhs) == res, "vec3(10, 20, 0).max(vec3(10, -5, 3))");
+    auto expected{static_cast<std::size_t>(std::distance(
+        aos.begin(),
+        std::ranges::min_element(aos, {}, [&](const Vec& p) { return p.distance(query); })
+    ))};
+    assert_equal(batch::argmin_distance(query, aos), expected, "AoS argmin_distance");
+    assert_equal(batch::argmin_distance(query, soa), expected, "SoA argmin_distance");
+  }
+  if (n > 0) {
+    // the query itself as the last point, in the scalar tail for most n
+    std::vector<Vec> with_query{aos};
+    with_query.back() = query;
+    const soa_vector<Vec> soa_with_query(with_query);
+    auto expected{static_cast<std::size_t>(std::distance(
+        with_query.begin(),
+        std::ranges::min_element(with_query, {}, [&](const Vec& p) {
+          return p.distance(query);
+        })
+    ))};
+    assert_equal(
+        batch::argmin_distance(query, with_query),
+        expected,
+        "AoS argmin_distance of the query"
+    );
+    assert_equal(
+        batch::argmin_distance(query, soa_with_query),
+        expected,
+        "SoA argmin_distance of the query"
+    );
   }
-  {
-    constexpr vec3<T> v;
-    static_assert(v.distance(v) == 0, "wrong distance from center to center");
+}
+
+template <typename T> void test_batch() {
+  std::println("test_batch<{}>", demangle<T>());
+  const std::size_t odd{3 * batch::detail::lanes<T> + 1};
+  for (std::size_t n : {0uz, 1uz, 7uz, 64uz, 101uz, odd}) {
+    test_batch_impl<vec2<T>>(n);
+    test_batch_impl<vec3<T>>(n);
+    test_batch_impl<vec4<T>>(n);
+  }
+  if constexpr (std::integral<T>) {
+    // differences that wrap around in T, in both the pack body and the scalar tail, and
+    // for types narrower than int also sums and products that overflow T
+    constexpr auto lo{static_cast<T>(std::numeric_limits<T>::lowest() + 2)};
+    constexpr auto hi{static_cast<T>(std::numeric_limits<T>::max() - 2)};
+    std::vector<std::pair<T, T>> cases{{1, 3}};
+    if constexpr (sizeof(T) < sizeof(int)) {
+      cases.insert(cases.end(), {{hi, lo}, {lo, hi}});
+    }
+    for (const auto& [p, q] : cases) {
+      const std::vector<vec2<T>> aos(odd, vec2<T>(p, q));
+      const soa_vector<vec2<T>> soa(aos);
+      const vec2<T> query(q, p);
+      std::vector<T> out_aos(odd), out_soa(odd);
+      batch::distance(query, aos, out_aos);
+      batch::distance(query, soa, out_soa);
+      const T expected{aos[0].distance(query)};
+      if constexpr (std::unsigned_integral<T>) {
+        assert_equal(vec2<T>(1, 0).distance(vec2<T>(3, 0)), T(-2), "distance wraps");
+      }
+      for (std::size_t i{}; i < odd; ++i) {
+        assert_equal(out_aos[i], expected, std::format("AoS wrapping distance [{}]", i));
+        assert_equal(out_soa[i], expected, std::format("SoA wrapping distance [{}]", i));
+      }
+      batch::squared_l2(query, aos, out_aos);
+      batch::squared_l2(query, soa, out_soa);
+      const vec2<T> d{aos[0] - query};
+      for (std::size_t i{}; i < odd; ++i) {
+        assert_equal(out_aos[i], d.dot(d), std::format("AoS wrapping squared [{}]", i));
+        assert_equal(out_soa[i], d.dot(d), std::format("SoA wrapping squared [{}]", i));
+      }
+    }
+  }
+}
+
+template <typename T> void test_grid() {
+  std::println("test_grid<{}>", demangle<T>());
+  using Grid = grid<char, 2, T>;
+  using vec = Grid::vec;
+  {
+    Grid g(vec(-2, 1), vec(4, 3), '.');
+    assert_equal(g.size(), 12uz, "grid(4x3) size");
+    assert(g.contains(vec(-2, 1)), "grid should contain origin");
+    assert(g.contains(vec(1, 3)), "grid should contain last cell");
+    assert(not g.contains(vec(2, 3)), "grid should not contain x past extent");
+    assert(not g.contains(vec(1, 4)), "grid should not contain y past extent");
+    assert(not g.contains(vec(-3, 1)), "grid should not contain x before origin");
+    assert(not g.contains(vec(-2, 0)), "grid should not contain y before origin");
+    for (std::size_t i{}; i < g.size(); ++i) {
+      assert_equal(g.index(g.position(i)), i, std::format("grid index(position({}))", i));
+    }
+    assert_equal(g.index(vec(-1, 1)), 1uz, "grid index increases along x");
+    assert_equal(g.index(vec(-2, 2)), 4uz, "grid index increases by width along y");
+  }
+  {
+    Grid g(vec(3, 2), '.');
+    g[vec(1, 1)] = '#';
+    g.at(vec(2, 0)) = '@';
+    assert_equal(g[4uz], '#', "grid[4] after grid[(1, 1)] assignment");
+    assert_equal(g[2uz], '@', "grid[2] after grid.at((2, 0)) assignment");
+    bool threw{false};
+    try {
+      (void)g.at(vec(3, 0));
+    } catch (const std::out_of_range&) {
+      threw = true;
+    }
+    assert(threw, "grid.at out of bounds should throw");
   }
   {
-    constexpr vec3<T> lhs(-1, 2, -4);
-    constexpr vec3<T> center;
-    static_assert(
-        lhs.distance(center) == 7,
-        "wrong distance from vec3(-1, 2, -4) to center"
+    Grid g(vec(3, 3));
+    auto adj_indices{[&g](vec p) {
+      std::vector<std::size_t> adj;
+      std::ranges::copy(g.adjacent(p), std::back_inserter(adj));
+      return adj;
+    }};
+    assert_equal(
+        adj_indices(vec(1, 1)),
+        std::vector<std::size_t>{1, 3, 5, 7},
+        "grid center adjacent"
     );
-    static_assert(lhs.distance(lhs) == 0, "wrong distance from vec3(-1, 2, -4) to self");
+    assert_equal(
+        adj_indices(vec(0, 0)),
+        std::vector<std::size_t>{1, 3},
+        "grid corner adjacent"
+    );
+    assert_equal(
+        adj_indices(vec(2, 1)),
+        std::vector<std::size_t>{2, 4, 8},
+        "grid right edge adjacent"
+    );
+    for (std::size_t i{}; i < g.size(); ++i) {
+      for (std::size_t j : g.adjacent(i)) {
+        assert_equal(
+            g.position(i).distance(g.position(j)),
+            T{1},
+            std::format("grid adjacent({}) neighbour {}", i, j)
+        );
+      }
+    }
   }
   {
-    constexpr vec3<T> lhs(-1, 2, -4);
-    constexpr vec3<T> rhs(1, 2, 4);
-    static_assert(
-        lhs.distance(rhs) == 10,
-        "wrong distance from vec3(-1, 2, -4) to vec3(1, 2, 4)"
+    auto g{grid<int, 3, T>::from_bounds(vec3<T>(-1, -1, -1), vec3<T>(1, 1, 1))};
+    assert_equal(g.size(), 27uz, "grid from_bounds 3x3x3 size");
+    assert_equal(g.adjacent(vec3<T>()).size(), 6uz, "grid 3D center adjacent count");
+    assert_equal(
+        g.adjacent(vec3<T>(-1, -1, -1)).size(),
+        3uz,
+        "grid 3D corner adjacent count"
     );
   }
   {
-    constexpr vec3<T> lhs(-1, 2, -4);
-    constexpr vec3<T> rhs(1, 2, 4);
-    static_assert(lhs.dot(rhs) == -13, "vec3(-1, 2, -4) dot vec3(1, 2, 4) should be -13");
+    // more cells than short can count, the index and the size are computed in size_t
+    Grid g(vec(300, 300), '.');
+    assert_equal(g.size(), 90'000uz, "grid(300x300) size");
+    assert_equal(g.index(vec(299, 299)), 89'999uz, "grid(300x300) index of last cell");
+    assert_equal(g.position(89'999uz), vec(299, 299), "grid(300x300) last position");
+    g[vec(299, 299)] = '#';
+    assert_equal(g.cells().back(), '#', "grid(300x300) last cell assignment");
+  }
+  if constexpr (sizeof(T) >= sizeof(int)) {
+    const T max{std::numeric_limits<T>::max()};
+    bool threw{false};
+    try {
+      const grid<char, 3, T> g(vec3<T>(max, max, max));
+    } catch (const std::length_error&) {
+      threw = true;
+    }
+    assert(threw, "grid with more cells than size_t can count should throw");
+  }
+}
+
+template <typename T> void test_flat_hash() {
+  std::println("test_flat_hash<{}>", demangle<T>());
+  using vec = vec2<T>;
+  {
+    flat_set<vec> set;
+    assert(set.empty(), "flat_set() should be empty");
+    assert(set.insert(vec(1, 2)).second, "first flat_set insert should be new");
+    assert(not set.insert(vec(1, 2)).second, "second flat_set insert should not be new");
+    assert(set.contains(vec(1, 2)), "flat_set should contain vec2(1, 2)");
+    assert(not set.contains(vec(2, 1)), "flat_set should not contain vec2(2, 1)");
+    assert_equal(*set.find(vec(1, 2)), vec(1, 2), "flat_set find");
+    assert_equal(set.erase(vec(1, 2)), 1uz, "flat_set erase existing");
+    assert_equal(set.erase(vec(1, 2)), 0uz, "flat_set erase missing");
+    assert(set.empty(), "flat_set should be empty after erase");
+  }
+  {
+    std::set<vec> expected;
+    flat_set<vec> set;
+    std::uint32_t state{1};
+    auto next{[&state] { return (state = state * 1664525 + 1013904223) >> 16; }};
+    for (int i{}; i < 20000; ++i) {
+      vec p(next() % 64 - 32, next() % 64 - 32);
+      if (i % 3 == 0) {
+        assert_equal(
+            set.erase(p),
+            expected.erase(p),
+            std::format("flat_set erase {}", p)
+        );
+      } else {
+        assert_equal(
+            set.insert(p).second,
+            expected.insert(p).second,
+            std::format("flat_set insert {}", p)
+        );
+      }
+    }
+    assert_equal(set.size(), expected.size(), "flat_set size after random operations");
+    for (const vec& p : expected) {
+      assert(set.contains(p), std::format("flat_set should contain {}", p));
+    }
+    for (const vec& p : set) {
+      assert(expected.contains(p), std::format("flat_set should not contain {}", p));
+    }
   }
   {
-    constexpr vec3<T> lhs(-1, 2, -4);
-    constexpr vec3<T> rhs(1, 2, 4);
-    constexpr vec3<T> res(16, 0, -4);
-    static_assert(lhs.cross(rhs) == res, "vec3(-1, 2, -4).cross(vec3(1, 2, 4))");
+    flat_map<vec, int> dist;
+    dist[vec(0, 0)] = 0;
+    dist[vec(1, 0)] += 2;
+    dist.try_emplace(vec(1, 0), 5);
+    dist.try_emplace(vec(0, 1), 5);
+    assert_equal(dist.size(), 3uz, "flat_map size");
+    assert_equal(dist.at(vec(1, 0)), 2, "flat_map operator[] +=");
+    assert_equal(dist.at(vec(0, 1)), 5, "flat_map try_emplace");
+    bool threw{false};
+    try {
+      (void)dist.at(vec(1, 1));
+    } catch (const std::out_of_range&) {
+      threw = true;
+    }
+    assert(threw, "flat_map.at missing key should throw");
   }
   {
-    constexpr vec3<T> lhs(-1, 2, -4);
-    constexpr vec3<T> res(-1, 1, -1);
-    static_assert(
-        lhs.signum() == res,
-        "expected vec3(-1, 2, -4).signum() == vec3(-1, 1, -1)"
+    struct constant_hash {
+      std::size_t operator()(const vec&) const noexcept { return 0; }
+    };
+    flat_set<vec, constant_hash> set;
+    for (int i{}; i < 200; ++i) {
+      set.insert(vec(i, -i));
+    }
+    for (int i{}; i < 200; ++i) {
+      assert(set.contains(vec(i, -i)), "flat_set with constant hash lost a key");
+    }
+    bool threw{false};
+    int inserted{200};
+    try {
+      for (; inserted < 1000; ++inserted) {
+        set.insert(vec(inserted, -inserted));
+      }
+    } catch (const std::overflow_error&) {
+      threw = true;
+    }
+    assert(threw, "flat_set with constant hash should overflow");
+    // the failed insert leaves the set as it was
+    const auto size{static_cast<std::size_t>(inserted)};
+    assert_equal(set.size(), size, "flat_set size after overflow");
+    assert_equal(
+        static_cast<std::size_t>(std::ranges::distance(set)),
+        size,
+        "flat_set iteration after overflow"
     );
+    for (int i{}; i < inserted; ++i) {
+      assert(set.contains(vec(i, -i)), "flat_set lost a key after overflow");
+    }
+    assert(not set.contains(vec(inserted, -inserted)), "flat_set overflowing key absent");
+    assert(not set.insert(vec(0, 0)).second, "flat_set insert of present key after overflow");
+    assert_equal(set.erase(vec(1, -1)), 1uz, "flat_set erase after overflow");
+    assert(set.insert(vec(inserted, -inserted)).second, "flat_set insert after erase");
+  }
+  {
+    // times the inverse of the Fibonacci multiplier, so x == 0 has its home in the middle
+    // slot and x != 0 in the slot before, at every capacity
+    struct middle_hash {
+      std::size_t operator()(const vec& v) const noexcept {
+        const std::uint64_t middle{std::uint64_t{1} << 63};
+        return (v.x() == 0 ? middle : middle - 1) * 0xf1de83e19937733d;
+      }
+    };
+    flat_set<vec, middle_hash> set;
+    for (int i{}; i < 254; ++i) {
+      set.insert(vec(0, i));
+    }
+    set.insert(vec(1, 0));
+    // vec(1, 1) displaces the run of x == 0 until its last value would overflow
+    bool threw{false};
+    try {
+      set.insert(vec(1, 1));
+    } catch (const std::overflow_error&) {
+      threw = true;
+    }
+    assert(threw, "flat_set displacing insert should overflow");
+    assert_equal(set.size(), 255uz, "flat_set size after displacing overflow");
+    for (int i{}; i < 254; ++i) {
+      assert(set.contains(vec(0, i)), "flat_set lost a key after displacing overflow");
+    }
+    assert(set.contains(vec(1, 0)), "flat_set lost vec(1, 0) after displacing overflow");
+    assert(not set.contains(vec(1, 1)), "flat_set displacing key absent");
   }
-  {
-    constexpr vec3<T> v(-1, 2, -4);
-    static_assert(v.sum() == -3, "expected vec3(-1, 2, -4).sum() == -3");
+}
+
+template <typename Vec> void test_curve_impl() {
+  using T = Vec::value_type;
+  constexpr int bits{curve_bits<Vec>};
+  constexpr std::int64_t half{std::int64_t{1} << (bits - 1)};
+  std::uint32_t state{1};
+  auto next{[&state] { return (state = state * 1664525 + 1013904223) >> 8; }};
+  auto reference_morton{[](const Vec& p) {
+    std::uint64_t code{};
+    [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+      for (int bit{}; bit < bits; ++bit) {
+        ((code |= ((static_cast<std::uint64_t>(p.template get<axes>() + half) >> bit) & 1)
+                  << (bit * Vec::ndim + axes)),
+         ...);
+      }
+    }(typename Vec::axes_indices{});
+    return code;
+  }};
+  for (int i{}; i < 1000; ++i) {
+    Vec p;
+    p.apply([&](T) { return static_cast<T>(next() % (2 * half) - half); });
+    assert_equal(
+        morton_encode(p),
+        reference_morton(p),
+        std::format("morton_encode {}", p)
+    );
+    assert_equal(
+        morton_decode<Vec>(morton_encode(p)),
+        p,
+        std::format("morton_decode {}", p)
+    );
+    assert_equal(
+        hilbert_decode<Vec>(hilbert_encode(p)),
+        p,
+        std::format("hilbert_decode {}", p)
+    );
   }
   {
-    constexpr vec3<T> v(-1, 2, -4);
-    static_assert(v.prod() == 8, "expected vec3(-1, 2, -4).prod() == 8");
+    Vec origin, p;
+    p.template get<Vec::ndim - 1>() = 1;
+    assert_equal(
+        morton_encode(p) ^ morton_encode(origin),
+        std::uint64_t{1} << (Vec::ndim - 1),
+        std::format("morton_encode {} lowest bit of last axis", p)
+    );
   }
   {
-    constexpr vec3<T> v(-1, 2, -4);
-    static_assert(v.min() == -4, "expected vec3(-1, 2, -4).min() == -4");
+    const std::uint64_t begin{hilbert_encode(Vec())};
+    for (std::uint64_t code{begin}; code < begin + 5000; ++code) {
+      const Vec p{hilbert_decode<Vec>(code)}, q{hilbert_decode<Vec>(code + 1)};
+      assert_equal(
+          p.distance(q),
+          T{1},
+          std::format("hilbert codes {} and {} should be adjacent", code, code + 1)
+      );
+    }
   }
   {
-    constexpr vec3<T> v(-1, 2, -4);
-    static_assert(v.max() == 2, "expected vec3(-1, 2, -4).max() == 2");
+    // an aligned box of side 4 is one contiguous section of the Hilbert curve
+    std::vector<Vec> points;
+    for (std::size_t i{}; i < (1uz << (2 * Vec::ndim)); ++i) {
+      Vec p;
+      [&]<std::size_t... axes>(std::index_sequence<axes...>) {
+        ((p.template get<axes>() = static_cast<T>((i >> (2 * axes)) & 3)), ...);
+      }(typename Vec::axes_indices{});
+      points.push_back(p);
+    }
+    std::vector<Vec> by_morton{points};
+    sort_by_curve(by_morton);
+    assert(
+        std::ranges::is_sorted(by_morton, {}, [](const Vec& p) {
+          return morton_encode(p);
+        }),
+        "sort_by_curve morton order"
+    );
+    sort_by_curve(points, space_filling_curve::hilbert);
+    for (std::size_t i{1}; i < points.size(); ++i) {
+      assert_equal(
+          points[i - 1].distance(points[i]),
+          T{1},
+          std::format("sort_by_curve hilbert order at {}", points[i])
+      );
+    }
+    std::ranges::sort(points);
+    std::ranges::sort(by_morton);
+    assert_equal(points, by_morton, "sort_by_curve should permute the points");
   }
 }
 
-template <typename T> consteval void test_vec4_compile_time_impl() {
-  static_assert(std::regular<vec4<T>>);
-  {
-    constexpr vec4<T> v;
-    static_assert(v.x() == T{}, "vec4: default init x should be T{}");
-    static_assert(v.y() == T{}, "vec4: default init y should be T{}");
-    static_assert(v.z() == T{}, "vec4: default init z should be T{}");
-    static_assert(v.w() == T{}, "vec4: default init w should be T{}");
+template <typename T> void test_curve() {
+  std::println("test_curve<{}>", demangle<T>());
+  {
+    constexpr vec2<T> p(-3, 7);
+    static_assert(morton_decode<vec2<T>>(morton_encode(p)) == p);
+    constexpr vec3<T> q(1, -2, 3);
+    static_assert(hilbert_decode<vec3<T>>(hilbert_encode(q)) == q);
+  }
+  test_curve_impl<vec2<T>>();
+  test_curve_impl<vec3<T>>();
+  test_curve_impl<vec4<T>>();
+  {
+    soa_vector<vec2<T>> points;
+    for (T y{3}; y >= 0; --y) {
+      for (T x{3}; x >= 0; --x) {
+        points.emplace_back(x, y);
+      }
+    }
+    sort_by_curve(points);
+    assert_equal(vec2<T>(points[0]), vec2<T>(0, 0), "soa_vector sort_by_curve first");
+    assert_equal(vec2<T>(points[1]), vec2<T>(1, 0), "soa_vector sort_by_curve second");
+    assert_equal(vec2<T>(points[2]), vec2<T>(0, 1), "soa_vector sort_by_curve third");
+    assert_equal(vec2<T>(points[15]), vec2<T>(3, 3), "soa_vector sort_by_curve last");
   }
-  {
-    constexpr vec4<T> v(1, 2, 3, 4);
-    static_assert(v.x() == 1, "vec4(1, 2, 3, 4).x() should be 1");
-    static_assert(v.y() == 2, "vec4(1, 2, 3, 4).y() should be 2");
-    static_assert(v.z() == 3, "vec4(1, 2, 3, 4).z() should be 3");
-    static_assert(v.w() == 4, "vec4(1, 2, 3, 4).w() should be 4");
+}
+
+template <typename Vec, typename Metric> void test_kdtree_metric(std::size_t n) {
+  using T = Vec::value_type;
+  using Tree = kdtree<Vec>;
+  using neighbor = Tree::neighbor;
+  std::uint32_t state{static_cast<std::uint32_t>(n)};
+  auto next{[&state] {
+    state = state * 1664525 + 1013904223;
+    return static_cast<T>(static_cast<int>(state >> 16) % 41 - 20);
+  }};
+  std::vector<Vec> points(n);
+  for (Vec& p : points) {
+    p.apply([&](T) { return next(); });
+  }
+  const Tree tree(points);
+  assert_equal(tree.size(), n, "kdtree size");
+  auto brute_force{[&](const Vec& q) {
+    std::vector<neighbor> res;
+    for (std::size_t i{}; i < n; ++i) {
+      res.emplace_back(metric::distance<Metric>(q, points[i]), i);
+    }
+    std::ranges::sort(res);
+    return res;
+  }};
+  auto indices{[](const auto& neighbors) {
+    std::vector<std::size_t> res;
+    for (const neighbor& nb : neighbors) {
+      res.push_back(nb.index);
+    }
+    return res;
+  }};
+  for (int i{}; i < 50; ++i) {
+    Vec q;
+    q.apply([&](T) { return next(); });
+    const std::vector<neighbor> expected{brute_force(q)};
+    for (std::size_t k : {1uz, 5uz, n + 1}) {
+      const auto res{tree.nearest(q, k, Metric{})};
+      assert_equal(
+          indices(res),
+          indices(expected | std::views::take(k)),
+          std::format("kdtree {} nearest to {}", k, q)
+      );
+    }
+    if (auto nearest{tree.nearest(q, Metric{})}; n > 0) {
+      assert(nearest and *nearest == expected.front(), "kdtree nearest neighbor");
+    } else {
+      assert(not nearest, "empty kdtree should not have a nearest neighbor");
+    }
+    const T radius{9};
+    assert_equal(
+        indices(tree.within_radius(q, radius, Metric{})),
+        indices(expected | std::views::take_while([&](const neighbor& nb) {
+                  return nb.distance <= radius;
+                })),
+        std::format("kdtree within radius {} of {}", radius, q)
+    );
   }
-  {
-    constexpr vec4<T> lhs, rhs;
-    static_assert((lhs <=> rhs) == 0, "expected vec4() == vec4()");
+}
+
+template <typename T> void test_kdtree() {
+  std::println("test_kdtree<{}>", demangle<T>());
+  for (std::size_t n : {0uz, 1uz, 2uz, 100uz, 1000uz}) {
+    test_kdtree_metric<vec2<T>, metric::manhattan>(n);
+    test_kdtree_metric<vec3<T>, metric::squared_euclidean>(n);
+    test_kdtree_metric<vec4<T>, metric::chebyshev>(n);
+  }
+  {
+    const std::vector<vec2<T>> points{
+        vec2<T>(0, 0),
+        vec2<T>(1, 1),
+        vec2<T>(1, 1),
+        vec2<T>(5, -2),
+        vec2<T>(-3, 4),
+    };
+    const kdtree tree(points);
+    assert_equal(
+        tree.within_box(vec2<T>(0, -2), vec2<T>(5, 1)),
+        std::vector<std::size_t>{0, 1, 2, 3},
+        "kdtree within_box"
+    );
+    assert_equal(
+        tree.within_box(vec2<T>(2, 2), vec2<T>(3, 3)),
+        std::vector<std::size_t>{},
+        "kdtree within empty box"
+    );
+    assert_equal(
+        metric::distance<metric::chebyshev>(points[3], points[4]),
+        T{8},
+        "chebyshev distance"
+    );
+    assert_equal(
+        metric::distance<metric::squared_euclidean>(points[3], points[4]),
+        T{100},
+        "squared euclidean distance"
+    );
   }
   {
-    constexpr vec4<T> lhs(-1, 0, 1, 2);
-    constexpr vec4<T> rhs(-1, 0, 1, 2);
-    static_assert((lhs <=> rhs) == 0, "expected vec4(-1, 0, 1, 2) == vec4(-1, 0, 1, 2)");
+    // large enough to build subtrees on several threads
+    std::vector<vec3<T>> points;
+    for (int i{}; i < 100'000; ++i) {
+      points.emplace_back(T(i % 47), T(i % 53), T(i % 59));
+    }
+    const kdtree tree(points);
+    for (int i{}; i < 100'000; i += 997) {
+      auto nearest{tree.nearest(points[i], metric::squared_euclidean{})};
+      assert(nearest and nearest->distance == 0, "kdtree should find each point");
+      assert_equal(points[nearest->index], points[i], "kdtree nearest index");
+    }
   }
-  {
-    constexpr vec4<T> lhs(-1, 0, 1, 1);
+}
+
+template <typename Vec, typename Metric> void test_cell_list_metric(std::size_t n) {
+  using T = Vec::value_type;
+  std::uint32_t state{static_cast<std::uint32_t>(n) + 7};
+  auto next{[&state] {
+    state = state * 1664525 + 1013904223;
+    return static_cast<T>(static_cast<int>(state >> 16) % 201 - 100) / T{4};
+  }};
+  std::vector<Vec> points(n);
+  for (Vec& p : points) {
+    p.apply([&](T) { return next(); });
+  }
+  const T radius{Metric::axis_distance(T{5})};
+  auto brute_force{[&](const Vec& q) {
+    std::vector<std::size_t> res;
+    for (std::size_t i{}; i < points.size(); ++i) {
+      if (metric::distance<Metric>(q, points[i]) <= radius) {
+        res.push_back(i);
+      }
+    }
+    return res;
+  }};
+  cell_list<Vec> cells(points, T{5});
+  assert_equal(cells.size(), n, "cell_list size");
+  std::vector<Vec> queries(points);
+  for (int i{}; i < 20; ++i) {
+    Vec q;
+    q.apply([&](T) { return next() * T{2}; });
+    queries.push_back(q);
+  }
+  auto check_all{[&](std::string_view what) {
+    const auto adjacency{cells.within_radius(queries, radius, Metric{})};
+    for (std::size_t i{}; i < queries.size(); ++i) {
+      const std::vector<std::size_t> expected{brute_force(queries[i])};
+      assert_equal(
+          cells.within_radius(queries[i], radius, Metric{}),
+          expected,
+          std::format("cell_list {} within radius of {}", what, queries[i])
+      );
+      std::vector<std::size_t> adjacent(adjacency[i].begin(), adjacency[i].end());
+      std::ranges::sort(adjacent);
+      assert_equal(
+          adjacent,
+          expected,
+          std::format("cell_list {} adjacency of {}", what, queries[i])
+      );
+    }
+  }};
+  check_all("build");
+  for (Vec& p : points) {
+    p.apply([&](T v) { return v + next() / T{8}; });
+  }
+  cells.update(points);
+  check_all("update within grid");
+  for (Vec& p : points) {
+    p.apply([&](T v) { return v * T{2}; });
+  }
+  cells.update(points);
+  check_all("update outside grid");
+}
+
+template <typename T> void test_cell_list() {
+  std::println("test_cell_list<{}>", demangle<T>());
+  for (std::size_t n : {0uz, 1uz, 50uz, 500uz}) {
+    test_cell_list_metric<vec2<T>, metric::manhattan>(n);
+    test_cell_list_metric<vec3<T>, metric::squared_euclidean>(n);
+    test_cell_list_metric<vec3<T>, metric::chebyshev>(n);
+  }
+  {
+    std::vector<vec2<T>> points{vec2<T>(0, 0), vec2<T>(1, 0), vec2<T>(3, 0)};
+    cell_list<vec2<T>> cells(points, T{1});
+    assert_equal(cells.cell_count(), 6uz * 3uz, "cell_list cell count with padding");
+    assert_equal(
+        cells.within_radius(vec2<T>(0, 0), T{1}),
+        std::vector<std::size_t>{0, 1},
+        "cell_list within radius 1"
+    );
+    bool threw{false};
+    try {
+      (void)cells.within_radius(vec2<T>(0, 0), T{2});
+    } catch (const std::invalid_argument&) {
+      threw = true;
+    }
+    assert(threw, "cell_list radius larger than cell size should throw");
+    points[0] = vec2<T>(0, 0.5);
+    cells.update(points);
+    assert_equal(
+        cells.within_radius(vec2<T>(0, 1.5), T{1}),
+        std::vector<std::size_t>{0},
+        "cell_list within radius after in-place update"
+    );
+    if constexpr (std::floating_point<T>) {
+      const T nan{std::numeric_limits<T>::quiet_NaN()};
+      assert_equal(
+          cells.within_radius(vec2<T>(1e30, -1e30), T{1}),
+          std::vector<std::size_t>{},
+          "cell_list within radius of a far away query"
+      );
+      assert_equal(
+          cells.within_radius(vec2<T>(3, nan), T{1}),
+          std::vector<std::size_t>{},
+          "cell_list within radius of a NaN query"
+      );
+      const std::vector<vec2<T>> queries{vec2<T>(nan, 0)};
+      assert_equal(
+          cells.within_radius(queries, T{1})[0].size(),
+          0uz,
+          "cell_list adjacency of a NaN query"
+      );
+    }
+    bool threw_wide{false};
+    try {
+      const std::vector<vec3<T>> wide{vec3<T>(0, 0, 0), vec3<T>(1e7, 1e7, 1e7)};
+      const cell_list<vec3<T>> wide_cells(wide, T{1});
+    } catch (const std::length_error&) {
+      threw_wide = true;
+    }
+    assert(threw_wide, "cell_list with too many cells should throw");
+    if constexpr (std::floating_point<T>) {
+      const std::vector<vec2<T>> far{vec2<T>(0, 0), vec2<T>(1e30, 0)};
+      bool threw_far{false};
+      try {
+        cells.build(far);
+      } catch (const std::length_error&) {
+        threw_far = true;
+      }
+      assert(threw_far, "cell_list build with too many cells on an axis should throw");
+      assert_equal(cells.cell_count(), 6uz * 3uz, "cell_list grid after a failed build");
+      assert_equal(
+          cells.within_radius(vec2<T>(0, 1.5), T{1}),
+          std::vector<std::size_t>{0},
+          "cell_list within radius after a failed build"
+      );
+    }
+  }
+  {
+    // enough points for the parallel counting sort to use several chunks
+    std::vector<vec3<T>> points;
+    for (int i{}; i < 100'000; ++i) {
+      points.emplace_back(T(i % 47), T(i % 53), T(i % 59));
+    }
+    const cell_list<vec3<T>> cells(points, T{1});
+    for (int i{}; i < 100'000; i += 997) {
+      const auto res{cells.within_radius(points[i], T{0})};
+      assert(
+          std::ranges::find(res, std::size_t(i)) != res.end(),
+          "cell_list should find each point"
+      );
+    }
+  }
+}
+
+template <typename Vec>
+grid<int, Vec::ndim, typename Vec::value_type> search_reference(
+    const grid<int, Vec::ndim, typename Vec::value_type>& costs,
+    const Vec& start
+) {
+  // relaxes every edge until nothing changes, negative costs are walls
+  grid<int, Vec::ndim, typename Vec::value_type> dist(costs.extent(), -1);
+  dist[start] = 0;
+  for (bool changed{true}; changed;) {
+    changed = false;
+    for (std::size_t i{}; i < dist.size(); ++i) {
+      if (dist[i] < 0) {
+        continue;
+      }
+      for (const Vec& adj : dist.position(i).adjacent()) {
+        if (costs.contains(adj) and costs[adj] >= 0) {
+          if (dist[adj] < 0 or dist[i] + costs[adj] < dist[adj]) {
+            dist[adj] = dist[i] + costs[adj];
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+  return dist;
+}
+
+template <typename Vec, typename Engine>
+void test_search_engine(
+    Engine& engine,
+    const grid<int, Vec::ndim, typename Vec::value_type>& costs,
+    const Vec& start,
+    std::string_view name
+) {
+  using T = Vec::value_type;
+  auto is_open{[&](const Vec& p) { return costs.contains(p) and costs[p] >= 0; }};
+  auto weight_mod{[&](int m) {
+    return [&costs, m](const Vec&, const Vec& to) -> std::optional<int> {
+      if (not costs.contains(to) or costs[to] < 0) {
+        return std::nullopt;
+      }
+      return costs[to] % m;
+    };
+  }};
+  grid<int, Vec::ndim, T> unit(costs.extent());
+  grid<int, Vec::ndim, T> binary(costs.extent());
+  for (std::size_t i{}; i < costs.size(); ++i) {
+    unit[i] = costs[i] < 0 ? -1 : 1;
+    binary[i] = costs[i] < 0 ? -1 : costs[i] % 2;
+  }
+  auto check{[&](const auto& expected, std::string_view what, auto&& search) {
+    grid<int, Vec::ndim, T> dist(costs.extent(), -1);
+    std::size_t visited{};
+    auto res{search([&](const Vec& p, int d) {
+      assert(dist[p] < 0, std::format("{} {} visits {} twice", name, what, p));
+      dist[p] = d;
+      ++visited;
+    })};
+    assert(not res, std::format("{} {} should visit every node", name, what));
+    assert(
+        std::ranges::equal(dist.cells(), expected.cells()),
+        std::format("{} {} distances", name, what)
+    );
+    return visited;
+  }};
+  for (int round{}; round < 2; ++round) {
+    check(search_reference(unit, start), "bfs", [&](auto visit) {
+      return engine.bfs(start, is_open, visit);
+    });
+    check(search_reference(binary, start), "bfs01", [&](auto visit) {
+      return engine.bfs01(start, weight_mod(2), visit);
+    });
+    const auto expected{search_reference(costs, start)};
+    check(expected, "dijkstra", [&](auto visit) {
+      return engine.dijkstra(start, weight_mod(10), 9, visit);
+    });
+    for (std::size_t i{}; i < costs.size(); i += 7) {
+      const Vec goal{costs.position(i)};
+      const auto res{engine.astar(start, goal, weight_mod(10), 9)};
+      assert_equal(
+          res.value_or(-1),
+          expected[goal],
+          std::format("{} astar from {} to {}", name, start, goal)
+      );
+    }
+  }
+  const Vec far{costs.position(costs.size() - 1)};
+  if (const int d{search_reference(unit, start)[far]}; d >= 0) {
+    auto is_far{[&far](const Vec& p, int) { return p == far; }};
+    const auto res{engine.bfs(start, is_open, is_far)};
+    assert_equal(res.value_or(-1), d, std::format("{} bfs stopped at goal", name));
+  }
+}
+
+template <typename T> void test_search() {
+  std::println("test_search<{}>", demangle<T>());
+  std::uint32_t state{17};
+  auto next{[&state](int m) {
+    state = state * 1664525 + 1013904223;
+    return static_cast<int>(state >> 16) % m;
+  }};
+  {
+    // weights 1 to 9, about a quarter of the cells are walls
+    grid<int, 2, T> costs(vec2<T>(40, 30));
+    for (int& c : costs) {
+      c = next(4) == 0 ? -1 : 1 + next(9);
+    }
+    const vec2<T> start(3, 4);
+    costs[start] = 1;
+    search::dense_engine<vec2<T>> dense(vec2<T>(), costs.extent());
+    search::hashed_engine<vec2<T>> hashed;
+    test_search_engine(dense, costs, start, "dense search");
+    test_search_engine(hashed, costs, start, "hashed search");
+
+    auto weight{[&](const vec2<T>&, const vec2<T>& to) -> std::optional<int> {
+      if (not costs.contains(to) or costs[to] < 0) {
+        return std::nullopt;
+      }
+      return costs[to];
+    }};
+    bool threw{false};
+    try {
+      (void)dense.dijkstra(start, weight, 5);
+    } catch (const std::out_of_range&) {
+      threw = true;
+    }
+    assert(threw, "dijkstra with a step above max_weight should throw");
+    threw = false;
+    try {
+      (void)hashed.astar(start, vec2<T>(), [](auto&&...) { return 0; }, 1);
+    } catch (const std::out_of_range&) {
+      threw = true;
+    }
+    assert(threw, "astar with a step of weight 0 should throw");
+  }
+  {
+    grid<int, 3, T> costs(vec3<T>(8, 7, 6));
+    for (int& c : costs) {
+      c = next(3) == 0 ? -1 : 1 + next(9);
+    }
+    const vec3<T> start(1, 2, 3);
+    costs[start] = 1;
+    // walls around the goal leave it unreachable
+    const vec3<T> goal(6, 5, 4);
+    for (const vec3<T>& adj : goal.adjacent()) {
+      costs[adj] = -1;
+    }
+    search::dense_engine<vec3<T>> dense(vec3<T>(), costs.extent());
+    search::hashed_engine<vec3<T>> hashed;
+    test_search_engine(dense, costs, start, "dense 3d search");
+    test_search_engine(hashed, costs, start, "hashed 3d search");
+    auto unit{[&](const vec3<T>&, const vec3<T>& to) -> std::optional<int> {
+      return costs.contains(to) and costs[to] >= 0 ? std::optional<int>(1) : std::nullopt;
+    }};
+    assert(not dense.astar(start, goal, unit, 1), "dense astar to unreachable goal");
+    assert(not hashed.astar(start, goal, unit, 1), "hashed astar to unreachable goal");
+  }
+}
+
+template <typename Vec>
+void test_parallel_bfs_box(
+    const grid<std::uint8_t, Vec::ndim, typename Vec::value_type>& walls,
+    std::span<const Vec> starts,
+    std::string_view name
+) {
+  using T = Vec::value_type;
+  auto is_open{[&](const Vec& p) { return not walls[p]; }};
+  grid<int, Vec::ndim, T> expected(walls.extent(), search::parallel_bfs<Vec>::unreached);
+  search::dense_engine<Vec> sequential(Vec(), walls.extent());
+  (void)sequential.bfs(starts, is_open, [&](const Vec& p, int d) { expected[p] = d; });
+  const auto reached{static_cast<std::size_t>(std::ranges::count_if(
+      expected,
+      [](int d) { return d != search::parallel_bfs<Vec>::unreached; }
+  ))};
+
+  search::parallel_bfs<Vec> bfs(Vec(), walls.extent());
+  for (auto direction : {
+           search::bfs_direction::automatic,
+           search::bfs_direction::top_down,
+           search::bfs_direction::bottom_up,
+       }) {
+    const auto what{std::format("{} direction {}", name, std::to_underlying(direction))};
+    const std::size_t n{
+        bfs.run(starts, is_open, {.direction = direction, .parents = true}),
+    };
+    assert_equal(n, reached, std::format("{} reached", what));
+    assert(
+        std::ranges::equal(bfs.distances().cells(), expected.cells()),
+        std::format("{} distances", what)
+    );
+    for (std::size_t i{}; i < walls.size(); ++i) {
+      const Vec p{walls.position(i)};
+      std::optional<Vec> parent;
+      if (expected[i] > 0 and expected[i] != search::parallel_bfs<Vec>::unreached) {
+        for (const std::size_t adj : expected.adjacent(i)) {
+          if (expected[adj] == expected[i] - 1) {
+            parent = expected.position(adj);
+            break;
+          }
+        }
+      }
+      assert(bfs.parent(p) == parent, std::format("{} parent of {}", what, p));
+    }
+  }
+}
+
+template <typename T> void test_parallel_bfs() {
+  std::println("test_parallel_bfs<{}>", demangle<T>());
+  std::uint32_t state{31};
+  auto next{[&state](int m) {
+    state = state * 1664525 + 1013904223;
+    return static_cast<int>(state >> 16) % m;
+  }};
+  {
+    // large enough for several threads, a third of the cells are walls
+    using Vec = vec2<T>;
+    grid<std::uint8_t, 2, T> walls(Vec(301, 203));
+    for (std::size_t i{}; i < walls.size(); ++i) {
+      walls[i] = next(3) == 0;
+    }
+    const std::array starts{Vec(3, 4), Vec(250, 150), Vec(-1, 0)};
+    walls[starts[0]] = 0;
+    walls[starts[1]] = 0;
+    test_parallel_bfs_box<Vec>(walls, starts, "parallel_bfs 2D");
+    // a wall splitting the box leaves the right side unreached
+    for (Vec p(150, 0); p.y() < 203; p.y() += 1) {
+      walls[p] = 1;
+    }
+    test_parallel_bfs_box<Vec>(
+        walls,
+        std::span(starts).first(1),
+        "parallel_bfs 2D split"
+    );
+
+    search::parallel_bfs<Vec> bfs(Vec(), walls.extent());
+    assert_equal(
+        bfs.run(Vec(150, 5), [](const Vec&) { return false; }),
+        0uz,
+        "parallel_bfs closed start"
+    );
+    assert(not bfs.distance(Vec(150, 5)), "parallel_bfs closed start unreached");
+    bool threw{false};
+    try {
+      (void)bfs.run(Vec(3, 4), [](const Vec& p) {
+        if (p == Vec(10, 10)) {
+          throw std::runtime_error("is_open");
+        }
+        return true;
+      });
+    } catch (const std::runtime_error&) {
+      threw = true;
+    }
+    assert(threw, "parallel_bfs rethrows from is_open");
+    (void)bfs.run(Vec(0, 0), [](const Vec&) { return true; });
+    assert_equal(bfs.distance(Vec(300, 202)).value_or(-1), 502, "parallel_bfs open box");
+    assert(not bfs.parent(Vec(300, 202)), "parallel_bfs parents not recorded");
+  }
+  {
+    using Vec = vec3<T>;
+    grid<std::uint8_t, 3, T> walls(Vec(41, 30, 20));
+    for (std::size_t i{}; i < walls.size(); ++i) {
+      walls[i] = next(4) == 0;
+    }
+    const std::array starts{Vec(1, 2, 3), Vec(40, 29, 19)};
+    walls[starts[0]] = 0;
+    walls[starts[1]] = 0;
+    test_parallel_bfs_box<Vec>(walls, starts, "parallel_bfs 3D");
+  }
+}
+
+enum class forest : std::uint8_t { open, tree, yard };
+
+template <typename Cell, typename T, typename Rule>
+void test_automaton_rule(
+    const grid<Cell, 2, T>& initial,
+    neighborhood n,
+    Rule rule,
+    std::string_view name
+) {
+  using Vec = vec2<T>;
+  std::vector<Vec> offsets;
+  for (Vec d(-1, -1); d.y() <= 1; d.y() += 1) {
+    for (d.x() = -1; d.x() <= 1; d.x() += 1) {
+      if (d != Vec() and (n == neighborhood::moore or d.abs().sum() == 1)) {
+        offsets.push_back(d);
+      }
+    }
+  }
+  auto reference_step{[&](const grid<Cell, 2, T>& cells) {
+    grid<Cell, 2, T> next(cells.extent());
+    for (std::size_t i{}; i < cells.size(); ++i) {
+      std::uint64_t packed{};
+      for (const Vec& d : offsets) {
+        if (const Vec p{cells.position(i) + d}; cells.contains(p)) {
+          packed += std::uint64_t{1} << (4 * static_cast<unsigned>(cells[p]));
+        }
+      }
+      next[i] = rule(cells[i], typename automaton<Cell, T>::counts{packed});
+    }
+    return next;
+  }};
+  automaton<Cell, T> life(initial);
+  grid<Cell, 2, T> expected(initial);
+  for (int g{1}; g <= 4; ++g) {
+    expected = reference_step(expected);
+    life.step(rule, n);
+    assert(
+        life.cells() == expected,
+        std::format("{} generation {} of {}", name, g, initial.extent())
+    );
+  }
+  assert_equal(life.generation(), 4uz, std::format("{} generation count", name));
+}
+
+template <typename T> void test_automaton() {
+  std::println("test_automaton<{}>", demangle<T>());
+  std::uint32_t state{23};
+  auto next{[&state](int m) {
+    state = state * 1664525 + 1013904223;
+    return static_cast<int>(state >> 16) % m;
+  }};
+  auto game_of_life{[](std::uint8_t alive, auto counts) -> std::uint8_t {
+    const int n{counts.count(1)};
+    return n == 3 or (alive and n == 2);
+  }};
+  auto parity{[](std::uint8_t c, auto counts) -> std::uint8_t {
+    return (c + counts.count(1) + 2 * counts.count(2)) % 3;
+  }};
+  auto lumber{[](forest f, auto counts) {
+    const int trees{counts.count(forest::tree)}, yards{counts.count(forest::yard)};
+    switch (f) {
+      case forest::open:
+        return trees >= 3 ? forest::tree : f;
+      case forest::tree:
+        return yards >= 3 ? forest::yard : f;
+      case forest::yard:
+        return yards > 0 and trees > 0 ? f : forest::open;
+    }
+    return f;
+  }};
+  // enough rows and columns for several tiles along both axes
+  for (vec2<T> extent : {
+           vec2<T>(1, 1),
+           vec2<T>(1, 7),
+           vec2<T>(7, 1),
+           vec2<T>(37, 5),
+           vec2<T>(70, 100),
+           vec2<T>(2100, 3),
+       }) {
+    grid<std::uint8_t, 2, T> binary(extent), ternary(extent);
+    grid<forest, 2, T> lumber_area(extent);
+    for (std::size_t i{}; i < binary.size(); ++i) {
+      binary[i] = next(2);
+      ternary[i] = next(3);
+      lumber_area[i] = forest(next(3));
+    }
+    test_automaton_rule(binary, neighborhood::moore, game_of_life, "game of life");
+    test_automaton_rule(ternary, neighborhood::von_neumann, parity, "von neumann parity");
+    test_automaton_rule(lumber_area, neighborhood::moore, lumber, "lumber area");
+  }
+  {
+    grid<std::uint8_t, 2, T> cells(vec2<T>(3, 3));
+    cells[vec2<T>(1, 2)] = 16;
+    bool threw{false};
+    try {
+      automaton life(cells);
+    } catch (const std::invalid_argument&) {
+      threw = true;
+    }
+    assert(threw, "automaton with a state above 15 should throw");
+  }
+}
+
+template <typename T> void test_bitgrid() {
+  std::println("test_bitgrid<{}>", demangle<T>());
+  std::uint32_t state{29};
+  auto next{[&state](int m) {
+    state = state * 1664525 + 1013904223;
+    return static_cast<int>(state >> 16) % m;
+  }};
+  auto life_like{[](life_rule rule) {
+    return [rule](std::uint8_t alive, auto counts) -> std::uint8_t {
+      const int n{counts.count(1)};
+      return ((alive ? rule.survive : rule.birth) >> n) & 1;
+    };
+  }};
+  // B36/S23
+  constexpr life_rule highlife{
+      .birth = (1 << 3) | (1 << 6),
+      .survive = (1 << 2) | (1 << 3),
+  };
+  for (vec2<T> extent : {
+           vec2<T>(1, 1),
+           vec2<T>(63, 2),
+           vec2<T>(64, 64),
+           vec2<T>(65, 3),
+           vec2<T>(130, 70),
+           vec2<T>(200, 200),
+       }) {
+    grid<std::uint8_t, 2, T> cells(vec2<T>(-3, 5), extent);
+    for (std::uint8_t& c : cells) {
+      c = next(3) == 0;
+    }
+    for (life_rule rule : {life_rule::conway(), highlife}) {
+      auto bits{bitgrid<2, T>::from_grid(cells, [](std::uint8_t c) { return c != 0; })};
+      automaton<std::uint8_t, T> expected(cells);
+      for (int g{1}; g <= 4; ++g) {
+        bits.step(rule);
+        expected.step(life_like(rule));
+        assert(
+            bits
+                == bitgrid<2, T>::from_grid(
+                    expected.cells(),
+                    [](std::uint8_t c) { return c != 0; }
+                ),
+            std::format(
+                "bitgrid rule {}/{} generation {} of {}",
+                rule.birth,
+                rule.survive,
+                g,
+                extent
+            )
+        );
+      }
+      assert_equal(
+          bits.count(),
+          static_cast<std::size_t>(std::ranges::count(expected.cells(), 1)),
+          "bitgrid count"
+      );
+    }
+  }
+  {
+    // region counts against a loop over the cells, for boxes inside and across the edges
+    using Vec = vec3<T>;
+    bitgrid<3, T> bits(Vec(-70, 0, 2), Vec(140, 5, 4));
+    std::vector<Vec> set;
+    for (int i{}; i < 2000; ++i) {
+      const Vec p(next(140) - 70, next(5), next(4) + 2);
+      assert(bits.contains(p), std::format("bitgrid contains {}", p));
+      bits.set(p);
+      set.push_back(p);
+    }
+    std::ranges::sort(set);
+    set.erase(std::ranges::unique(set).begin(), set.end());
+    assert_equal(bits.count(), set.size(), "bitgrid 3D count");
+    assert(not bits.contains(Vec(70, 0, 2)), "bitgrid does not contain end");
+    for (int i{}; i < 200; ++i) {
+      const Vec lo(next(160) - 80, next(7) - 1, next(6) + 1);
+      const Vec hi(lo + Vec(next(150), next(4), next(3)));
+      const auto expected{std::ranges::count_if(set, [&](const Vec& p) {
+        return lo.min(p) == lo and hi.max(p) == hi;
+      })};
+      assert_equal(
+          bits.count(lo, hi),
+          static_cast<std::size_t>(expected),
+          std::format("bitgrid count in [{}, {}]", lo, hi)
+      );
+    }
+    const Vec p{set.front()};
+    assert(bits.test(p), "bitgrid test set cell");
+    bits.reset(p);
+    assert(not bits.test(p), "bitgrid test reset cell");
+    bits.flip(p);
+    assert(bits.test(p), "bitgrid test flipped cell");
+    bits.clear();
+    assert_equal(bits.count(), 0uz, "bitgrid count after clear");
+  }
+}
+
+template <typename T> void test_zobrist() {
+  std::println("test_zobrist<{}>", demangle<T>());
+  std::uint32_t state{37};
+  auto next{[&state](int m) {
+    state = state * 1664525 + 1013904223;
+    return static_cast<int>(state >> 16) % m;
+  }};
+  {
+    using Vec = vec2<T>;
+    grid<forest, 2, T> cells(Vec(-4, 3), Vec(23, 11));
+    for (forest& f : cells) {
+      f = forest(next(3));
+    }
+    zobrist_grid<forest, 2, T> z(cells);
+    assert_equal(z.hash(), zobrist_hash(cells), "zobrist_grid initial hash");
+    const std::uint64_t initial{z.hash()};
+    for (int i{}; i < 1000; ++i) {
+      const Vec p{cells.position(static_cast<std::size_t>(next(23 * 11)))};
+      z.set(p, forest(next(3)));
+      assert_equal(
+          z.hash(),
+          zobrist_hash(z.cells()),
+          std::format("zobrist_grid hash after write {}", i)
+      );
+    }
+    for (std::size_t i{}; i < cells.size(); ++i) {
+      z.set(cells.position(i), cells[i]);
+    }
+    assert_equal(z.hash(), initial, "zobrist_grid hash after restoring every cell");
+    assert(z == zobrist_grid<forest, 2, T>(cells), "zobrist_grid restored");
+    const Vec p(0, 5);
+    const forest other{forest((std::to_underlying(cells[p]) + 1) % 3)};
+    z.set(p, other);
+    assert(z.hash() != initial, "zobrist_grid hash changes with a cell");
+    z.set(p, cells[p]);
+    assert_equal(z.hash(), initial, "zobrist_grid hash restored");
+    assert(
+        zobrist_hash(cells, 1) != zobrist_hash(cells, 2),
+        "zobrist_hash depends on the seed"
+    );
+  }
+  {
+    // x -> (x * x + c) mod m has a tail and a cycle, found by listing the sequence
+    for (int c : {1, 3, 7}) {
+      for (int m : {97, 1009, 4099}) {
+        auto step{[c, m](int& x) { x = (x * x + c) % m; }};
+        auto hash{[](const int& x) { return std::hash<vec2<T>>{}(vec2<T>(x, -x)); }};
+        std::vector<int> seq{2};
+        std::optional<cycle> expected;
+        while (not expected) {
+          int x{seq.back()};
+          step(x);
+          if (auto it{std::ranges::find(seq, x)}; it != seq.end()) {
+            const auto start{static_cast<std::size_t>(it - seq.begin())};
+            expected = cycle{.start = start, .length = seq.size() - start};
+          }
+          seq.push_back(x);
+        }
+        const auto what{std::format("x * x + {} mod {}", c, m)};
+        cycle_detector detector;
+        std::optional<cycle> found;
+        for (std::size_t g{}; not found; ++g) {
+          found = detector.push(hash(seq[g]));
+        }
+        assert(found == expected, std::format("cycle_detector {}", what));
+        assert(
+            find_cycle(2, step, hash, 1'000'000) == expected,
+            std::format("find_cycle {}", what)
+        );
+        if (expected->start > 0) {
+          assert(
+              not find_cycle(2, step, hash, expected->start / 2),
+              std::format("find_cycle {} within too few generations", what)
+          );
+        }
+        for (std::size_t n : {0uz, 1uz, 5uz, 1'000'000'000uz}) {
+          assert_equal(
+              fast_forward(2, n, step, hash),
+              seq[expected->equivalent(n)],
+              std::format("fast_forward {} by {}", what, n)
+          );
+        }
+      }
+    }
+  }
+  {
+    // a blinker oscillates with period 2 from the start
+    using Vec = vec2<T>;
+    grid<std::uint8_t, 2, T> board(Vec(5, 5));
+    for (T x{1}; x <= 3; ++x) {
+      board[Vec(x, 2)] = 1;
+    }
+    auto life_step{[](zobrist_grid<std::uint8_t, 2, T>& z) {
+      const auto before{z.cells()};
+      for (std::size_t i{}; i < before.size(); ++i) {
+        const Vec p{before.position(i)};
+        int n{};
+        for (const Vec& d : moore_offsets<Vec>()) {
+          n += before.contains(p + d) and before[p + d];
+        }
+        const std::uint8_t alive{n == 3 or (before[i] and n == 2)};
+        if (alive != before[i]) {
+          z.set(p, alive);
+        }
+      }
+    }};
+    auto hash{[](const zobrist_grid<std::uint8_t, 2, T>& z) { return z.hash(); }};
+    const zobrist_grid<std::uint8_t, 2, T> blinker(board);
+    assert(
+        find_cycle(blinker, life_step, hash, 100) == cycle{.start = 0, .length = 2},
+        "blinker cycle"
+    );
+    assert(
+        fast_forward(blinker, 1'000'000'001, life_step, hash) != blinker,
+        "blinker after an odd number of generations"
+    );
+    assert(
+        fast_forward(blinker, 1'000'000'000, life_step, hash) == blinker,
+        "blinker after an even number of generations"
+    );
+  }
+}
+
+template <typename T> void test_parse() {
+  std::println("test_parse<{}>", demangle<T>());
+  assert_equal(
+      parse_points<vec2<T>>("1,2\n-3, 4\r\n\n+5 6 7 8\n"),
+      std::vector{vec2<T>(1, 2), vec2<T>(-3, 4), vec2<T>(5, 6), vec2<T>(7, 8)},
+      "parse_points with default separators"
+  );
+  assert_equal(
+      parse_points<vec3<T>>("x=1, y=-2, z=3\nx=4, y=5, z=-6", {.separators{" ,xyz="}}),
+      std::vector{vec3<T>(1, -2, 3), vec3<T>(4, 5, -6)},
+      "parse_points with labels"
+  );
+  assert_equal(
+      parse_points<vec2<T>>("p=<1,2>, v=<-3,4>\n", {.separators{" ,pv=<>"}}),
+      std::vector{vec2<T>(1, 2), vec2<T>(-3, 4)},
+      "parse_points with angle brackets"
+  );
+  if constexpr (std::floating_point<T>) {
+    assert_equal(
+        parse_points<vec2<T>>("0.25,-1.5e2\n"),
+        std::vector{vec2<T>(0.25, -150)},
+        "parse_points floating-point values"
+    );
+  }
+  auto throws{[](std::string_view input, std::string_view expected_message) {
+    try {
+      (void)parse_points<vec2<T>>(input);
+    } catch (const std::exception& e) {
+      return std::string_view(e.what()) == expected_message;
+    }
+    return false;
+  }};
+  assert(
+      throws("1,2,3\n4,5\n", "parse_points incomplete point at offset 5"),
+      "parse_points point split across lines should throw"
+  );
+  assert(
+      throws("1,2\n3", "parse_points incomplete point at offset 5"),
+      "parse_points incomplete last point should throw"
+  );
+  assert(
+      throws("1,2\n3;4\n", "parse_points unexpected character ';' at offset 5"),
+      "parse_points unknown separator should throw"
+  );
+  if constexpr (std::integral<T>) {
+    assert(
+        throws("1,99999999999999999999", "parse_points value out of range at offset 2"),
+        "parse_points value out of range should throw"
+    );
+  } else {
+    assert(
+        throws("1,1e99999", "parse_points value out of range at offset 2"),
+        "parse_points floating-point value out of range should throw"
+    );
+    const std::string digits(100, '0');
+    assert_equal(
+        parse_points<vec2<T>>(std::format("0.25{}1,-2.{}\n", digits, digits)),
+        std::vector{vec2<T>(0.25, -2)},
+        "parse_points values longer than 64 characters"
+    );
+  }
+
+  {
+    // large enough to be split into chunks that are parsed in parallel
+    std::uint32_t state{11};
+    std::vector<vec3<T>> expected(300'000);
+    std::string text;
+    for (vec3<T>& p : expected) {
+      p.apply([&state](T) {
+        state = state * 1664525 + 1013904223;
+        return static_cast<T>(static_cast<int>(state >> 16) % 2001 - 1000) / T{4};
+      });
+      text += std::format("{},{},{}\n", p.x(), p.y(), p.z());
+    }
+    assert(parse_points<vec3<T>>(text) == expected, "parse_points large input");
+    soa_vector<vec3<T>> soa(1);
+    parse_points<vec3<T>>(text, soa);
+    assert_equal(soa.size(), expected.size() + 1, "parse_points into soa_vector size");
+    assert(
+        std::ranges::equal(soa | std::views::drop(1), expected),
+        "parse_points into soa_vector"
+    );
+    text.insert(text.size() - 20, "?");
+    const auto expected_message{
+        std::format("parse_points unexpected character '?' at offset {}", text.find('?'))
+    };
+    std::string message;
+    try {
+      (void)parse_points<vec3<T>>(text);
+    } catch (const std::invalid_argument& e) {
+      message = e.what();
+    }
+    assert_equal(
+        message,
+        expected_message,
+        "parse_points reports the offset of errors in later chunks"
+    );
+  }
+
+  {
+    const auto path{std::filesystem::temp_directory_path() / "ndvec_test_parse.txt"};
+    std::ofstream(path) << "1 2\n3 4\n";
+    assert_equal(
+        parse_points_file<vec2<T>>(path),
+        std::vector{vec2<T>(1, 2), vec2<T>(3, 4)},
+        "parse_points_file"
+    );
+    std::ofstream(path, std::ios::trunc).close();
+    assert(parse_points_file<vec2<T>>(path).empty(), "parse_points_file empty file");
+    std::filesystem::remove(path);
+    bool threw{false};
+    try {
+      (void)parse_points_file<vec2<T>>(path);
+    } catch (const std::system_error&) {
+      threw = true;
+    }
+    assert(threw, "parse_points_file missing file should throw");
+  }
+
+  if constexpr (std::integral<T>) {
+    const auto digits{parse_grid<T>("123\r\n456\r\n", [](char c) { return c - '0'; })};
+    assert_equal(digits.extent(), vec2<T>(3, 2), "parse_grid extent");
+    assert_equal(digits[vec2<T>(2, 1)], 6, "parse_grid cell");
+    const auto chars{parse_grid<T>("#.\n.#")};
+    assert_equal(chars.extent(), vec2<T>(2, 2), "parse_grid without trailing newline");
+    assert_equal(chars[vec2<T>(1, 0)], '.', "parse_grid char cell");
+    assert(parse_grid<T>("").empty(), "parse_grid empty input");
+    bool threw{false};
+    try {
+      (void)parse_grid<T>("123\n45\n");
+    } catch (const std::invalid_argument&) {
+      threw = true;
+    }
+    assert(threw, "parse_grid ragged lines should throw");
+  }
+}
+
+template <typename T> void test_point_file() {
+  std::println("test_point_file<{}>", demangle<T>());
+  using Vec = vec3<T>;
+  std::uint32_t state{31};
+  std::vector<Vec> points(1000);
+  for (Vec& p : points) {
+    p.apply([&state](T) {
+      state = state * 1664525 + 1013904223;
+      return static_cast<T>(static_cast<int>(state >> 16) % 2001 - 1000) / T{4};
+    });
+  }
+  const auto path{std::filesystem::temp_directory_path() / "ndvec_test_point_file.bin"};
+  auto throws{[](auto&& fn) {
+    try {
+      (void)fn();
+    } catch (const std::invalid_argument&) {
+      return true;
+    }
+    return false;
+  }};
+
+  write_points(path, points);
+  {
+    const point_file file(path);
+    assert_equal(file.size(), points.size(), "point_file size");
+    assert_equal(file.ndim(), 3uz, "point_file ndim");
+    assert(file.layout() == point_layout::aos, "point_file default layout is AoS");
+    assert(file.read<Vec>() == points, "point_file read AoS");
+    if (detail::has_packed_layout<Vec>()) {
+      assert(std::ranges::equal(file.points<Vec>(), points), "point_file AoS points");
+    } else {
+      assert(
+          throws([&] { return file.points<Vec>(); }),
+          "point_file points of a vec with unpacked axes should throw"
+      );
+    }
+    assert(
+        throws([&] { return file.axis<T>(0); }),
+        "point_file axis of an AoS file should throw"
+    );
+    assert(
+        throws([&] { return file.read<vec2<T>>(); }),
+        "point_file read with wrong ndim should throw"
+    );
+    using other = std::conditional_t<std::floating_point<T>, int, double>;
+    assert(
+        throws([&] { return file.read<vec3<other>>(); }),
+        "point_file read with wrong value type should throw"
+    );
+  }
+
+  const soa_vector<Vec> soa(points);
+  write_points(path, soa, point_layout::soa);
+  {
+    const point_file file(path);
+    assert(file.layout() == point_layout::soa, "point_file SoA layout");
+    for (std::size_t axis{}; axis < 3; ++axis) {
+      const std::span<const T> values{file.axis<T>(axis)};
+      assert(
+          std::ranges::equal(values, soa.axis_data(axis)),
+          std::format("point_file SoA axis {}", axis)
+      );
+      assert(
+          reinterpret_cast<std::uintptr_t>(values.data()) % 64 == 0,
+          "point_file SoA axis is 64-byte aligned"
+      );
+    }
+    assert(file.read<Vec>() == points, "point_file read SoA");
+    assert(
+        throws([&] { return file.points<Vec>(); }),
+        "point_file points of an SoA file should throw"
+    );
+  }
+
+  write_points(path, std::vector<Vec>{});
+  assert(point_file(path).read<Vec>().empty(), "point_file without points");
+
+  write_points(path, points);
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 100);
+  assert(throws([&] { return point_file(path); }), "truncated point_file should throw");
+  std::ofstream(path, std::ios::trunc) << std::string(100, 'x');
+  assert(throws([&] { return point_file(path); }), "point_file of text should throw");
+  std::filesystem::remove(path);
+}
+
+template <typename T> void test_storage() {
+  std::println("test_storage<{}>", demangle<T>());
+  static_assert(sizeof(vec1<T>) == sizeof(T) and alignof(vec1<T>) == alignof(T));
+  static_assert(sizeof(vec2<T>) == 2 * sizeof(T) and alignof(vec2<T>) == alignof(T));
+  static_assert(sizeof(vec3<T>) == 3 * sizeof(T) and alignof(vec3<T>) == alignof(T));
+  static_assert(sizeof(vec4<T>) == 4 * sizeof(T) and alignof(vec4<T>) == alignof(T));
+  static_assert(std::is_trivially_copyable_v<vec4<T>>);
+  static_assert(sizeof(vec3<unsigned char>) == 4 and alignof(vec3<unsigned char>) == 4);
+  static_assert(std::tuple_size_v<vec3<T>> == 3);
+  static_assert(std::same_as<std::tuple_element_t<2, vec3<T>>, T>);
+  static_assert([] {
+    auto [x, y, z]{vec3<T>(1, 2, 3)};
+    return x == 1 and y == 2 and z == 3;
+  }());
+  static_assert(std::get<1>(vec3<T>(1, 2, 3).values()) == 2);
+  {
+    vec4<T> v(1, 2, 3, 4);
+    auto& [x, y, z, w]{v};
+    y = 5;
+    assert_equal(v, vec4<T>(1, 5, 3, 4), "structured binding by reference");
+    assert_equal(w, T{4}, "structured binding w");
+    assert_equal(x + z, T{4}, "structured binding x + z");
+  }
+  {
+    const std::tuple<T, T> values{vec2<T>(1, 2).values()};
+    assert_equal(std::get<0>(values), T{1}, "vec2(1, 2).values() x");
+    assert_equal(std::get<1>(values), T{2}, "vec2(1, 2).values() y");
+  }
+  {
+    vec3<unsigned char> padded(1, 2, 3);
+    padded += vec3<unsigned char>(1, 1, 1);
+    assert_equal(padded, vec3<unsigned char>(2, 3, 4), "padded vec3 operator+=");
+    assert_equal(padded.sum(), 9, "padded vec3 sum");
+    assert_equal(std::format("{}", padded), "ndvec3(2, 3, 4)"s, "padded vec3 format");
+  }
+}
+
+template <typename T> void test_expr() {
+  std::println("test_expr<{}>", demangle<T>());
+  static_assert([] {
+    vec4<T> a(1, -2, 3, -4), b(5, 6, -7, 8), c(2, 3, 4, 5), d(-1, 1, -1, 1);
+    return vec4<T>{lazy(a) + lazy(b) * c - d} == a + b * c - d
+           and vec4<T>{lazy(a) + b * c - d} == a + b * c - d
+           and (lazy(a) - b).abs().sum() == a.distance(b)
+           and lazy(a).distance(lazy(b)) == a.distance(b) and lazy(a).dot(b) == a.dot(b)
+           and (lazy(a) * c).prod() == (a * c).prod() and (lazy(a) / c).eval() == a / c
+           and vec4<T>{lazy(a).min(b).max(lazy(d))} == a.min(b).max(d)
+           and (lazy(a) + d).min() == (a + d).min()
+           and (lazy(a) + d).max() == (a + d).max();
+  }());
+  // unsigned short products wrap instead of overflowing int, eager and lazy alike
+  static_assert([] {
+    using U = unsigned short;
+    const vec2<U> a(65535, 65535), b(65535, 2);
+    return a * b == vec2<U>(1, 65534) and vec2<U>{lazy(a) * b} == a * b
+           and a.dot(b) == U{65535} and lazy(a).dot(lazy(b)) == a.dot(b);
+  }());
+  {
+    // the 6-D vector of main.cpp
+    const vecn<T, 6> v(1, 2, -3, -2, 4, 10);
+    assert_equal(lazy(v).signum().sum(), v.signum().sum(), "lazy 6-D signum sum");
+    assert_equal(lazy(v).abs().eval(), v.abs(), "lazy 6-D abs");
+  }
+  {
+    // temporaries are kept by value
+    const auto e{lazy(vec2<T>(1, 2)) + vec2<T>(3, 4)};
+    assert_equal(vec2<T>{e}, vec2<T>(4, 6), "lazy expression of temporaries");
+  }
+  {
+    vec3<T> a(1, 2, 3), b(4, 5, 6);
+    vec3<T> r;
+    r = lazy(a) * b - a;
+    assert_equal(r, a * b - a, "assign lazy expression");
+    r += lazy(a) + b;
+    assert_equal(r, a * b - a + (a + b), "add lazy expression");
+  }
+  {
+    std::uint32_t state{1};
+    auto next{[&state] { return (state = state * 1664525 + 1013904223) >> 16; }};
+    auto random_vec{[&] {
+      vec4<T> v;
+      return v.apply([&](T) {
+        return static_cast<T>(static_cast<int>(next() % 201) - 100);
+      });
+    }};
+    for (int i{}; i < 1000; ++i) {
+      const vec4<T> a{random_vec()}, b{random_vec()}, c{random_vec()};
+      assert_equal(
+          vec4<T>{(lazy(a) - b * c).abs() + lazy(c).signum()},
+          (a - b * c).abs() + c.signum(),
+          "lazy expression of random vecs"
+      );
+      assert_equal(
+          (lazy(a) * b + c).sum(),
+          (a * b + c).sum(),
+          "lazy sum of random vecs"
+      );
+      assert_equal(lazy(a).dot(b), a.dot(b), "lazy dot of random vecs");
+      assert_equal(lazy(a).distance(b), a.distance(b), "lazy distance of random vecs");
+    }
+  }
+}
+
+template <typename T> void test_reduce() {
+  std::println("test_reduce<{}>", demangle<T>());
+  using Vec = vec3<T>;
+  auto throws{[](auto&& fn) {
+    try {
+      (void)fn();
+    } catch (const std::invalid_argument&) {
+      return true;
+    }
+    return false;
+  }};
+  std::uint32_t state{7};
+  // more than one block and a partial block at the end
+  std::vector<Vec> points(100'003);
+  for (Vec& p : points) {
+    p.apply([&state](T) {
+      state = state * 1664525 + 1013904223;
+      return static_cast<T>(static_cast<int>(state >> 16) % 2001 - 1000) / T{4};
+    });
+  }
+  const soa_vector<Vec> soa(points);
+  for (const std::size_t n : {1uz, 5uz, 4096uz, 4103uz, points.size()}) {
+    const std::span<const Vec> view(points.data(), n);
+    const auto msg{std::format("{} points", n)};
+
+    Vec lo{view[0]}, hi{view[0]};
+    for (const Vec& p : view) {
+      lo = lo.min(p);
+      hi = hi.max(p);
+    }
+    assert_equal(reduce::bounds(view).first, lo, "reduce::bounds lo of " + msg);
+    assert_equal(reduce::bounds(view).second, hi, "reduce::bounds hi of " + msg);
+
+    std::array<reduce::axis_extremes, 3> extremes{};
+    for (std::size_t i{}; i < n; ++i) {
+      for (std::size_t axis{}; axis < 3; ++axis) {
+        const auto value{[&](std::size_t j) { return soa.axis_data(axis)[j]; }};
+        if (value(i) < value(extremes[axis].min)) {
+          extremes[axis].min = i;
+        }
+        if (value(extremes[axis].max) < value(i)) {
+          extremes[axis].max = i;
+        }
+      }
+    }
+    assert(
+        reduce::minmax_by_axis(view) == extremes,
+        "reduce::minmax_by_axis of " + msg
+    );
+
+    std::array<long double, 3> exact{};
+    for (const Vec& p : view) {
+      exact[0] += p.x();
+      exact[1] += p.y();
+      exact[2] += p.z();
+    }
+    const auto centroid{reduce::centroid(view)};
+    for (std::size_t axis{}; axis < 3; ++axis) {
+      const auto mean{static_cast<double>(exact[axis] / static_cast<long double>(n))};
+      const double got{reduce::detail::coords(centroid)[axis]};
+      assert(
+          std::abs(got - mean) <= 1e-4 * (1 + std::abs(mean)),
+          std::format("reduce::centroid axis {} of {}", axis, msg)
+      );
+    }
+    if constexpr (std::integral<T>) {
+      Vec sum;
+      for (const Vec& p : view) {
+        sum += p;
+      }
+      assert_equal(reduce::sum(view), sum, "reduce::sum of " + msg);
+    } else {
+      for (const auto mode : {reduce::summation::pairwise, reduce::summation::compensated}
+      ) {
+        const Vec sum{reduce::sum(view, mode)};
+        for (std::size_t axis{}; axis < 3; ++axis) {
+          const long double got{reduce::detail::coords(sum)[axis]};
+          const long double tolerance{
+              mode == reduce::summation::compensated and not std::same_as<T, float>
+                  ? 1e-9L
+                  : 1e-3L
+          };
+          assert(
+              std::abs(got - exact[axis]) <= tolerance * (1 + std::abs(exact[axis])),
+              std::format("reduce::sum axis {} of {}", axis, msg)
+          );
+        }
+      }
+    }
+  }
+
+  // the same blocks and accumulators for both layouts and any number of threads
+  for (const auto mode : {reduce::summation::pairwise, reduce::summation::compensated}) {
+    assert_equal(
+        reduce::sum(soa, mode),
+        reduce::sum(points, mode),
+        "reduce::sum of soa_vector"
+    );
+    assert_equal(
+        reduce::sum(points, mode),
+        reduce::sum(std::span<const Vec>(points), mode),
+        "reduce::sum is deterministic"
+    );
+  }
+  assert(reduce::bounds(soa) == reduce::bounds(points), "reduce::bounds of soa_vector");
+  assert(
+      reduce::minmax_by_axis(soa) == reduce::minmax_by_axis(points),
+      "reduce::minmax_by_axis of soa_vector"
+  );
+  assert(
+      reduce::centroid(soa) == reduce::centroid(points),
+      "reduce::centroid of soa_vector"
+  );
+
+  const std::vector<Vec> empty;
+  assert_equal(reduce::sum(empty), Vec(), "reduce::sum of no points");
+  assert(throws([&] { return reduce::bounds(empty); }), "reduce::bounds of no points");
+  assert(
+      throws([&] { return reduce::centroid(empty); }),
+      "reduce::centroid of no points"
+  );
+  assert(
+      throws([&] { return reduce::minmax_by_axis(empty); }),
+      "reduce::minmax_by_axis of no points"
+  );
+}
+
+template <typename T> void test_neighborhood() {
+  std::println("test_neighborhood<{}>", demangle<T>());
+  static_assert(moore_offsets<vec2<T>>().size() == 8);
+  static_assert(moore_offsets<vec3<T>>().size() == 26);
+  static_assert(moore_offsets<vec4<T>>().size() == 80);
+  static_assert(moore_offsets<vec2<T>, 2>().size() == 24);
+  static_assert(von_neumann_offsets<vec2<T>>().size() == 4);
+  static_assert(von_neumann_offsets<vec2<T>, 2>().size() == 12);
+  static_assert(von_neumann_offsets<vecn<T, 5>>().size() == 10);
+  static_assert(l1_shell_offsets<vec2<T>, 2>().size() == 8);
+  static_assert(l1_shell_offsets<vec3<T>, 2>().size() == 18);
+  static_assert(neighbors<neighborhood::moore>(vec2<T>(1, 1))[0] == vec2<T>());
+  static_assert(neighbors<neighborhood::l1_shell>(vec1<T>(5))[1] == vec1<T>(6));
+
+  {
+    const vec3<T> p(3, -2, 7);
+    assert_equal(
+        neighbors<neighborhood::von_neumann>(p),
+        p.adjacent(),
+        "von neumann neighbors equal adjacent() in 3D"
+    );
+    auto adj{vec2<T>(3, -2).adjacent()};
+    std::ranges::sort(adj);
+    assert_equal(
+        neighbors<neighborhood::l1_shell>(vec2<T>(3, -2)),
+        adj,
+        "sorted l1 shell neighbors equal adjacent() in 2D"
+    );
+  }
+
+  // every table against a filter over the lexicographically enumerated cube
+  auto check{[]<neighborhood kind, std::size_t radius>(const auto& offsets) {
+    using Vec = vec4<T>;
+    const int r{static_cast<int>(radius)};
+    std::vector<Vec> expected;
+    for (int x{-r}; x <= r; ++x) {
+      for (int y{-r}; y <= r; ++y) {
+        for (int z{-r}; z <= r; ++z) {
+          for (int w{-r}; w <= r; ++w) {
+            const Vec d(x, y, z, w);
+            const int l1{static_cast<int>(d.abs().sum())};
+            const int linf{static_cast<int>(d.abs().max())};
+            const bool keep{
+                kind == neighborhood::moore         ? linf > 0
+                : kind == neighborhood::von_neumann ? l1 > 0 and l1 <= r
+                                                    : l1 == r
+            };
+            if (keep) {
+              expected.push_back(d);
+            }
+          }
+        }
+      }
+    }
+    assert_equal(
+        std::vector<Vec>(offsets.begin(), offsets.end()),
+        expected,
+        std::format("4D offsets of kind {} with radius {}", std::to_underlying(kind), r)
+    );
+    const Vec p(1, -2, 3, -4);
+    const auto adj{neighbors<kind, radius>(p)};
+    for (std::size_t i{}; i < adj.size(); ++i) {
+      assert_equal(adj[i], p + offsets[i], std::format("4D neighbor {}", i));
+    }
+  }};
+  check.template operator()<neighborhood::moore, 1>(moore_offsets<vec4<T>>());
+  check.template operator()<neighborhood::moore, 2>(moore_offsets<vec4<T>, 2>());
+  check.template operator()<neighborhood::von_neumann, 2>(
+      von_neumann_offsets<vec4<T>, 2>()
+  );
+  check.template operator()<neighborhood::l1_shell, 3>(l1_shell_offsets<vec4<T>, 3>());
+}
+
+template <typename T> void test_mat() {
+  std::println("test_mat<{}>", demangle<T>());
+  using M2 = mat<T, 2>;
+  using M3 = mat<T, 3>;
+  static_assert(M3::identity() * vec3<T>(1, -2, 3) == vec3<T>(1, -2, 3));
+  static_assert(quarter_turn<T>(1) * vec2<T>(1, 0) == vec2<T>(0, 1));
+  static_assert(rotations<T, 2>().size() == 4);
+  static_assert(rotations<T, 3>().size() == 24);
+  static_assert(rotations<T, 4>().size() == 192);
+  static_assert(signed_permutations<T, 2>().size() == 8);
+  static_assert(signed_permutations<T, 3>().size() == 48);
+  static_assert(rotations<T, 3>()[0] == M3::identity());
+
+  {
+    const M3 m({{{2, 0, 1}, {1, 3, 2}, {1, 1, 2}}});
+    assert_equal(m.determinant(), T{6}, "determinant");
+    assert_equal(m.transpose()(0, 1), T{1}, "transpose");
+    assert_equal(m.transpose().transpose(), m, "transpose twice");
+    assert_equal(m * vec3<T>(1, 2, 3), vec3<T>(5, 13, 9), "mat * vec");
+    assert_equal(
+        m * M3::identity() * m,
+        M3({{{5, 1, 4}, {7, 11, 11}, {5, 5, 7}}}),
+        "mat * mat"
+    );
+  }
+
+  for (int k{-5}; k <= 5; ++k) {
+    const vec2<T> p(3, -7);
+    const double angle{k * std::numbers::pi / 2};
+    const vec2<T> expected(
+        static_cast<T>(std::round(3 * std::cos(angle) + 7 * std::sin(angle))),
+        static_cast<T>(std::round(3 * std::sin(angle) - 7 * std::cos(angle)))
+    );
+    assert_equal(quarter_turn<T>(k) * p, expected, std::format("quarter_turn({})", k));
+    assert_equal(
+        quarter_turn<T>(k) * quarter_turn<T>(1),
+        quarter_turn<T>(k + 1),
+        std::format("quarter_turn({}) * quarter_turn(1)", k)
+    );
+  }
+  {
+    const vec2<T> p(3, -7);
+    vec2<T> left{p}, right{p};
+    assert_equal(quarter_turn<T>(-1) * p, left.rotate_left(), "rotate_left");
+    assert_equal(quarter_turn<T>(1) * p, right.rotate_right(), "rotate_right");
+  }
+
+  {
+    std::set<M2> quarter_turns;
+    for (int k{}; k < 4; ++k) {
+      quarter_turns.insert(quarter_turn<T>(k));
+    }
+    const auto rot2{rotations<T, 2>()};
+    assert_equal(std::set<M2>(rot2.begin(), rot2.end()), quarter_turns, "2D rotations");
+  }
+
+  // the 3D rotations form a group, and with the reflections they are every matrix with
+  // one 1 or -1 in each row and column
+  const auto rot{rotations<T, 3>()};
+  const std::set<M3> rot_set(rot.begin(), rot.end());
+  assert_equal(rot_set.size(), 24uz, "distinct 3D rotations");
+  for (const M3& a : rot) {
+    assert_equal(a.determinant(), T{1}, "3D rotation determinant");
+    assert_equal(a * a.transpose(), M3::identity(), "3D rotation is orthogonal");
+    for (const M3& b : rot) {
+      assert(rot_set.contains(a * b), "3D rotations are closed under products");
+    }
+  }
+  const auto all{signed_permutations<T, 3>()};
+  const std::set<M3> all_set(all.begin(), all.end());
+  assert_equal(all_set.size(), 48uz, "distinct 3D signed permutations");
+  for (const M3& m : all) {
+    assert(
+        m.determinant() == T{1} ? rot_set.contains(m) : m.determinant() == T{-1},
+        "3D signed permutation determinant"
+    );
+    assert_equal(m * m.transpose(), M3::identity(), "3D signed permutation orthogonal");
+  }
+
+  std::uint32_t state{11};
+  std::vector<vec3<T>> points(1001);
+  for (vec3<T>& p : points) {
+    p.apply([&state](T) {
+      state = state * 1664525 + 1013904223;
+      return static_cast<T>(static_cast<int>(state >> 16) % 201 - 100);
+    });
+  }
+  const affine<T, 3> a{rot[5], vec3<T>(1, -2, 3)};
+  const affine<T, 3> b{all[40], vec3<T>(-4, 0, 2)};
+  for (const vec3<T>& p : points) {
+    assert_equal((a * b)(p), a(b(p)), "affine composition");
+  }
+  for (const M3& m : all) {
+    const affine<T, 3> t{m, vec3<T>(5, -1, 0)};
+    std::vector<vec3<T>> out(points.size());
+    batch::transform(t, points, out);
+    soa_vector<vec3<T>> soa(points);
+    batch::transform(t, soa);
+    std::vector<vec3<T>> in_place(points);
+    batch::transform(t, in_place);
+    for (std::size_t i{}; i < points.size(); ++i) {
+      const vec3<T> expected{m * points[i] + vec3<T>(5, -1, 0)};
+      assert_equal(out[i], expected, std::format("batch::transform point {}", i));
+      assert_equal(
+          vec3<T>(soa[i]),
+          expected,
+          std::format("batch::transform soa point {}", i)
+      );
+      assert_equal(in_place[i], expected, std::format("batch::transform in place {}", i));
+    }
+  }
+}
+
+template <typename T> void test_packed_vec() {
+  std::println("test_packed_vec<{}>", demangle<T>());
+  static_assert(sizeof(packed_vec<15, 2>) == 4);
+  static_assert(sizeof(packed_vec<16, 2>) == 8);
+  static_assert(sizeof(packed_vec<20, 3>) == 8);
+  static_assert(packed_vec<20, 3>() == packed_vec<20, 3>(0, 0, 0));
+  static_assert(std::same_as<packed_vec<31, 2>::value_type, std::int32_t>);
+  static_assert(packed_vec<31, 2>::min_value == -(1 << 30));
+  static_assert(std::same_as<packed_vec<32, 1>::value_type, std::int64_t>);
+  static_assert(packed_vec<32, 1>::min_value == std::numeric_limits<std::int32_t>::min());
+  static_assert(packed_vec<32, 1>::max_value == std::numeric_limits<std::int32_t>::max());
+  static_assert(
+      packed_vec<32, 1>(std::numeric_limits<std::int32_t>::min()).get<0>()
+      == std::numeric_limits<std::int32_t>::min()
+  );
+  static_assert(
+      packed_vec<63, 1>::max_value == std::numeric_limits<std::int64_t>::max() / 2
+  );
+  static_assert(packed_vec<4, 2>(-8, 7).word() == 0b0'0000'0'1111);
+  static_assert(
+      packed_vec<4, 2>(7, 0) + packed_vec<4, 2>(1, -8) == packed_vec<4, 2>(-8, -8)
+  );
+
+  auto check{[]<std::size_t bits, std::size_t ndim>(std::uint32_t seed) {
+    using Packed = packed_vec<bits, ndim>;
+    using Vec = vecn<long long, ndim>;
+    const auto name{std::format("packed_vec<{}, {}>", bits, ndim)};
+    auto unpack{[](const Packed& v) { return v.template unpack<long long>(); }};
+    const long long range{1LL << bits};
+    auto wrap{[&](Vec v) {
+      return v.apply([&](long long x) {
+        return ((x - Packed::min_value) % range + range) % range + Packed::min_value;
+      });
+    }};
+    std::uint64_t state{seed};
+    auto random_vec{[&] {
+      Vec v;
+      v.apply([&](long long) {
+        state = state * 6364136223846793005 + 1442695040888963407;
+        // mostly near the limits, where the lanes carry and borrow
+        const auto r{static_cast<long long>(state >> 33)};
+        const long long offset{(r >> 2) % (r % 4 < 2 ? std::min(range, 3LL) : range)};
+        return r % 4 == 1 ? Packed::max_value - offset : Packed::min_value + offset;
+      });
+      return v;
+    }};
+    for (int i{}; i < 2000; ++i) {
+      const Vec a{random_vec()}, b{random_vec()};
+      const Packed pa(a), pb(b);
+      assert_equal(unpack(pa), a, name + " round trip");
+      assert_equal(Packed::from_word(pa.word()), pa, name + " from_word");
+      assert_equal(std::hash<Packed>{}(pa), pa.word(), name + " hash");
+      assert_equal(unpack((pa + pb)), wrap(a + b), name + " +");
+      assert_equal(unpack((pa - pb)), wrap(a - b), name + " -");
+      assert_equal(unpack(pa.min(pb)), a.min(b), name + " min");
+      assert_equal(unpack(pa.max(pb)), a.max(b), name + " max");
+      assert((pa <=> pb) == (a <=> b), name + " <=>");
+      assert_equal(pa == pb, a == b, name + " ==");
+      const auto adj{pa.adjacent()};
+      for (std::size_t j{}; j < adj.size(); ++j) {
+        const Vec d{neighbors<neighborhood::von_neumann>(Vec())[j]};
+        assert_equal(unpack(adj[j]), wrap(a + d), name + " adjacent");
+      }
+    }
+    Vec too_large;
+    too_large.template get<ndim - 1>() = Packed::max_value + 1;
+    assert(not Packed::representable(too_large), name + " representable");
+    bool thrown{false};
+    try {
+      (void)Packed(too_large);
+    } catch (const std::out_of_range&) {
+      thrown = true;
+    }
+    assert(thrown, name + " out of range throws");
+  }};
+  check.template operator()<1, 3>(1);
+  check.template operator()<4, 2>(2);
+  check.template operator()<15, 2>(3);
+  check.template operator()<20, 3>(4);
+  check.template operator()<15, 4>(5);
+  check.template operator()<31, 2>(6);
+  check.template operator()<62, 1>(7);
+
+  {
+    bool thrown{false};
+    try {
+      (void)packed_vec<4, 2>::from_word(1u << 4);
+    } catch (const std::invalid_argument&) {
+      thrown = true;
+    }
+    assert(thrown, "packed_vec from_word with a guard bit throws");
+  }
+
+  const vec3<T> p(-3, 100, 7);
+  const packed_vec<15, 3> packed(p);
+  assert_equal(packed.unpack<T>(), p, "packed_vec to and from vec3");
+  assert_equal(
+      packed.adjacent()[0].unpack<T>(),
+      p.adjacent()[0],
+      "packed_vec adjacent like vec3"
+  );
+  flat_set<packed_vec<15, 3>> visited;
+  for (const auto& adj : packed.adjacent()) {
+    visited.insert(adj);
+    visited.insert(adj);
+  }
+  assert_equal(visited.size(), 6uz, "packed_vec flat_set");
+}
+
+template <typename T> void test_radix_sort() {
+  std::println("test_radix_sort<{}>", demangle<T>());
+  using Vec = vec3<T>;
+  std::uint64_t state{13};
+  auto random_points{[&state](std::size_t n, long long lo, long long hi) {
+    std::vector<Vec> points(n);
+    for (Vec& p : points) {
+      p.apply([&](T) {
+        state = state * 6364136223846793005 + 1442695040888963407;
+        const std::uint64_t r{state ^ (state >> 29)};
+        const auto first{static_cast<std::uint64_t>(lo)};
+        const std::uint64_t width{static_cast<std::uint64_t>(hi) - first + 1};
+        return static_cast<T>(first + (width == 0 ? r : r % width));
+      });
+    }
+    return points;
+  }};
+  constexpr long long lo{std::numeric_limits<T>::min()};
+  constexpr long long hi{std::numeric_limits<T>::max()};
+  // more than one chunk, small boxes where most passes are skipped, and full ranges
+  for (const auto& [n, box_lo, box_hi] : {
+           std::tuple{0uz, 0LL, 0LL},
+           std::tuple{1uz, lo, hi},
+           std::tuple{1000uz, lo, hi},
+           std::tuple{200'003uz, std::max(lo, -20LL), std::min(hi, 20LL)},
+           std::tuple{200'003uz, lo, hi},
+       }) {
+    const auto msg{std::format("{} points in [{}, {}]", n, box_lo, box_hi)};
+    const std::vector<Vec> points{random_points(n, box_lo, box_hi)};
+
+    std::vector<Vec> expected{points};
+    std::ranges::sort(expected);
+    std::vector<Vec> sorted{points};
+    radix_sort(sorted);
+    assert(sorted == expected, "radix_sort of " + msg);
+    soa_vector<Vec> soa(points);
+    radix_sort(soa);
+    assert(
+        std::vector<Vec>(soa.begin(), soa.end()) == expected,
+        "radix_sort soa_vector of " + msg
+    );
+
+    expected.erase(std::ranges::unique(expected).begin(), expected.end());
+    std::vector<Vec> unique{points};
+    unique.resize(sort_unique(unique));
+    assert(unique == expected, "sort_unique of " + msg);
+    soa_vector<Vec> soa_unique(points);
+    soa_unique.resize(sort_unique(soa_unique));
+    assert(
+        std::vector<Vec>(soa_unique.begin(), soa_unique.end()) == expected,
+        "sort_unique soa_vector of " + msg
+    );
+
+    std::vector<Vec> by_code{points};
+    std::ranges::stable_sort(by_code, {}, [](const Vec& p) { return morton_encode(p); });
+    std::vector<Vec> morton{points};
+    radix_sort<sort_order::morton>(morton);
+    assert(morton == by_code, "morton radix_sort of " + msg);
+  }
+
+  std::vector<vecn<T, 5>> five{vecn<T, 5>(1, 0, 0, 0, 0), vecn<T, 5>(0, 0, 0, 0, 1)};
+  radix_sort(five);
+  assert(five.front() == vecn<T, 5>(0, 0, 0, 0, 1), "radix_sort of 5D vecs");
+  static_assert(
+      requires { radix_sort<sort_order::morton>(std::declval<Vec (&)[1]>()); },
+      "morton radix_sort of 3D vecs should compile"
+  );
+  static_assert(
+      not requires { radix_sort<sort_order::morton>(std::declval<vecn<T, 5> (&)[1]>()); },
+      "morton radix_sort of 5D vecs should not compile"
+  );
+}
+
+template <typename T> void test_sparse_grid() {
+  std::println("test_sparse_grid<{}>", demangle<T>());
+  {
+    using Grid = sparse_grid<int, 2, 3, T>;
+    using Vec = vec2<T>;
+    static_assert(Grid::chunk_cells == 64);
+    assert_equal(
+        Grid::chunk_of(Vec(-1, 8)),
+        Vec(-1, 1),
+        "sparse_grid chunk_of rounds down"
+    );
+    assert_equal(Grid::chunk_of(Vec(-8, 7)), Vec(-1, 0), "sparse_grid chunk_of(-8, 7)");
+    assert_equal(Grid::chunk_origin(Vec(-1, 1)), Vec(-8, 8), "sparse_grid chunk_origin");
+    for (std::size_t i{}; i < Grid::chunk_cells; ++i) {
+      const Vec p{Grid::cell_position(Vec(-8, 8), i)};
+      assert_equal(
+          Grid::chunk_of(p),
+          Vec(-1, 1),
+          std::format("sparse_grid cell {} chunk", i)
+      );
+      assert_equal(Grid::local_index(p), i, std::format("sparse_grid local_index({})", p));
+    }
+
+    Grid g(-1);
+    const Grid& cg{g};
+    assert_equal(cg[Vec(3, -4)], -1, "sparse_grid reads background");
+    assert(g.empty(), "sparse_grid const read does not allocate");
+    g[Vec(3, -4)] = 7;
+    assert_equal(g.chunk_count(), 1uz, "sparse_grid write allocates one chunk");
+    assert_equal(g.size(), 64uz, "sparse_grid size counts allocated cells");
+    assert(g.allocated(Vec(0, -8)), "sparse_grid chunk of (0, -8) allocated");
+    assert(not g.allocated(Vec(0, 0)), "sparse_grid chunk of (0, 0) not allocated");
+    assert_equal(cg[Vec(3, -4)], 7, "sparse_grid reads written cell");
+    assert_equal(cg[Vec(4, -4)], -1, "sparse_grid new chunk filled with background");
+
+    // a random walk that crosses many chunks, against a std::map
+    std::map<Vec, int> expected{{Vec(3, -4), 7}};
+    std::uint64_t state{5};
+    Vec p;
+    for (int step{}; step < 20'000; ++step) {
+      state = state * 6364136223846793005 + 1442695040888963407;
+      const auto dir{(state >> 40) % 4};
+      p += Vec(dir == 0 ? 1 : dir == 1 ? -1 : 0, dir == 2 ? 1 : dir == 3 ? -1 : 0);
+      ++g[p];
+      expected.try_emplace(p, -1);
+      ++expected[p];
+      const auto left{expected.find(p - Vec(1, 0))};
+      assert_equal(
+          cg[p - Vec(1, 0)],
+          left == expected.end() ? -1 : left->second,
+          "sparse_grid neighbour read"
+      );
+    }
+    std::map<Vec, int> seen;
+    g.for_each_chunk([&](const Vec& origin, std::span<int, 64> cells) {
+      assert_equal(
+          Grid::chunk_of(origin) * Vec(8, 8),
+          origin,
+          "sparse_grid chunk origin aligned"
+      );
+      for (std::size_t i{}; i < cells.size(); ++i) {
+        if (cells[i] != -1) {
+          seen[Grid::cell_position(origin, i)] = cells[i];
+        }
+      }
+    });
+    assert(seen == expected, "sparse_grid for_each_chunk visits every written cell");
+
+    // erased chunks go to the pool and are reused, filled with the background again
+    const std::size_t chunks{g.chunk_count()};
+    assert_equal(g.erase_chunk(Grid::chunk_of(p)), 1uz, "sparse_grid erase_chunk");
+    assert_equal(g.erase_chunk(Grid::chunk_of(p)), 0uz, "sparse_grid erase_chunk twice");
+    assert_equal(g.chunk_count(), chunks - 1, "sparse_grid chunk_count after erase");
+    assert_equal(g.pooled_chunks(), 1uz, "sparse_grid pooled_chunks after erase");
+    assert_equal(cg[p], -1, "sparse_grid erased chunk reads background");
+    g[Vec(1000, 1000)] = 1;
+    assert_equal(g.pooled_chunks(), 0uz, "sparse_grid reuses pooled chunk");
+    assert_equal(
+        cg[Vec(1001, 1000)],
+        -1,
+        "sparse_grid reused chunk filled with background"
+    );
+
+    Grid copy{g};
+    g.shrink_to_fit();
+    std::size_t cells_seen{};
+    g.for_each_chunk([&](const Vec& origin, std::span<int, 64> cells) {
+      for (std::size_t i{}; i < cells.size(); ++i) {
+        const Vec q{Grid::cell_position(origin, i)};
+        assert_equal(
+            cells[i],
+            std::as_const(copy)[q],
+            "sparse_grid shrink_to_fit keeps cells"
+        );
+        ++cells_seen;
+      }
+    });
+    assert_equal(cells_seen, g.size(), "sparse_grid shrink_to_fit keeps chunks");
+
+    g.clear();
+    assert(g.empty(), "sparse_grid clear");
+    assert_equal(g.pooled_chunks(), chunks, "sparse_grid clear pools every chunk");
+    assert_equal(cg[Vec(1000, 1000)], -1, "sparse_grid cleared cell reads background");
+  }
+  {
+    sparse_grid<char, 3, 4, T> g('.');
+    g[vec3<T>(-1, -1, -1)] = '#';
+    g[vec3<T>(20, 0, 0)] = '#';
+    g[vec3<T>(20, 0, 0)] = '.';
+    assert_equal(g.chunk_count(), 2uz, "sparse_grid 3D chunk_count");
+    assert_equal(g.erase_background_chunks(), 1uz, "sparse_grid erase_background_chunks");
+    assert(g.allocated(vec3<T>(-16, -16, -16)), "sparse_grid keeps non-background chunk");
+    assert(not g.allocated(vec3<T>(20, 0, 0)), "sparse_grid erases background chunk");
+  }
+  {
+    // references stay valid while other chunks are allocated
+    sparse_grid<int, 2, 3, T> g(-1);
+    int& cell{g[vec2<T>(3, -4)]};
+    cell = 7;
+    for (T x{}; x < 256; x += 8) {
+      g[vec2<T>(x, 100)] = g[vec2<T>(3, -4)];
+    }
+    assert_equal(g.chunk_count(), 33uz, "sparse_grid chunks after g[a] = g[b]");
+    cell = 8;
+    assert_equal(g[vec2<T>(3, -4)], 8, "sparse_grid reference survives allocations");
+    assert_equal(g[vec2<T>(248, 100)], 7, "sparse_grid g[a] = g[b] across chunks");
+  }
+  {
+    // every page is an array, so bool cells are real bool references
+    sparse_grid<bool, 2, 6, T> g;
+    static_assert(std::same_as<decltype(g[vec2<T>()]), bool&>);
+    bool& cell{g[vec2<T>(1, 2)]};
+    g[vec2<T>(-100, 0)] = true;
+    cell = true;
+    assert(std::as_const(g)[vec2<T>(1, 2)], "sparse_grid bool reference");
+  }
+}
+
+template <typename T> void test_instrument() {
+  std::println("test_instrument<{}>", demangle<T>());
+  using instrument::op;
+  instrument::reset();
+  assert(instrument::snapshot() == instrument::counters{}, "instrument reset");
+  {
+    instrument::region outer("outer \"phase\"");
+    instrument::count(op::hash);
+    {
+      instrument::region inner("inner");
+      instrument::count(op::parse);
+      instrument::count(op::parse);
+    }
+    std::vector<std::thread> threads;
+    for (int t{}; t < 4; ++t) {
+      threads.emplace_back([] {
+        for (int i{}; i < 1000; ++i) {
+          instrument::count(op::arithmetic);
+        }
+      });
+    }
+    for (std::thread& t : threads) {
+      t.join();
+    }
+  }
+  {
+    instrument::region inner("inner");
+    instrument::count(op::format);
+  }
+  const instrument::counters total{instrument::snapshot()};
+  assert_equal(total[op::arithmetic], 4000uz, "instrument counts of exited threads");
+  assert_equal(total[op::hash], 1uz, "instrument hash count");
+  assert_equal(total[op::parse], 2uz, "instrument parse count");
+  assert_equal(total[op::format], 1uz, "instrument format count");
+  const auto regions{instrument::regions()};
+  assert_equal(regions.size(), 2uz, "instrument region count");
+  assert_equal(regions[0].first, "inner"s, "instrument regions in order of completion");
+  assert_equal(regions[0].second[op::parse], 2uz, "instrument inner region parses");
+  assert_equal(regions[0].second[op::format], 1uz, "instrument regions accumulate");
+  assert_equal(regions[1].second[op::arithmetic], 4000uz, "instrument outer threads");
+  assert_equal(regions[1].second[op::format], 0uz, "instrument outer region formats");
+  assert_equal(
+      instrument::to_json(),
+      "{\"total\": {\"arithmetic\": 4000, \"reductions\": 0, \"temporaries\": 0, "
+      "\"hashes\": 1, \"formats\": 1, \"parses\": 2}, \"regions\": {"
+      "\"inner\": {\"arithmetic\": 0, \"reductions\": 0, \"temporaries\": 0, "
+      "\"hashes\": 0, \"formats\": 1, \"parses\": 2}, "
+      "\"outer \\\"phase\\\"\": {\"arithmetic\": 4000, \"reductions\": 0, "
+      "\"temporaries\": 0, \"hashes\": 1, \"formats\": 0, \"parses\": 2}}}"s,
+      "instrument to_json"
+  );
+  assert(
+      instrument::report().contains("outer \"phase\""),
+      "instrument report lists regions"
+  );
+  {
+    // a region open during a reset counts from the reset instead of wrapping around
+    instrument::region open("open");
+    instrument::count(op::hash);
+    instrument::reset();
+    instrument::count(op::parse);
+  }
+  assert_equal(instrument::regions().size(), 1uz, "instrument reset during a region");
+  assert_equal(
+      instrument::regions()[0].second,
+      instrument::snapshot(),
+      "instrument region open during a reset counts from the reset"
+  );
+  assert_equal(instrument::snapshot()[op::hash], 0uz, "instrument hashes after reset");
+
+  instrument::reset();
+  const vec3<T> a(1, 2, 3), b(4, 5, 6);
+  const vec3<T> c{(a + b - a).abs()};
+  (void)c.sum();
+  (void)c.distance(a);
+  if constexpr (std::integral<T>) {
+    (void)std::hash<vec3<T>>{}(c);
+  }
+  (void)std::format("{}", c);
+  vec3<T> parsed;
+  std::istringstream("1 2 3") >> parsed;
+  static_assert((vec2<T>(1, 2) + vec2<T>(3, 4)).sum() == 10, "counted ops are constexpr");
+  const instrument::counters counted{instrument::snapshot()};
+#ifdef NDVEC_INSTRUMENT
+  assert_equal(counted[op::arithmetic], 3uz, "instrumented arithmetic");
+  assert_equal(counted[op::temporary], 3uz, "instrumented temporaries");
+  assert_equal(counted[op::reduction], 2uz, "instrumented reductions");
+  if constexpr (std::integral<T>) {
+    assert_equal(counted[op::hash], 1uz, "instrumented hashes");
+  }
+  assert_equal(counted[op::format], 1uz, "instrumented formats");
+  assert_equal(counted[op::parse], 1uz, "instrumented parses");
+#else
+  assert(counted == instrument::counters{}, "ndvec counts only with NDVEC_INSTRUMENT");
+#endif
+}
+
+template <typename... Ts> void test_vec() {
+  (test_vec1<Ts>(), ...);
+  (test_vec2<Ts>(), ...);
+  (test_vec3<Ts>(), ...);
+  (test_vec4<Ts>(), ...);
+}
+
+template <typename T> consteval void test_vec3_compile_time_impl() {
+  static_assert(std::regular<vec3<T>>);
+  {
+    constexpr vec3<T> v;
+    static_assert(v.x() == T{}, "vec3: default init x should be T{}");
+    static_assert(v.y() == T{}, "vec3: default init y should be T{}");
+    static_assert(v.z() == T{}, "vec3: default init z should be T{}");
+  }
+  {
+    constexpr vec3<T> v(1, 2, 3);
+    static_assert(v.x() == 1, "vec3(1, 2, 3).x() should be 1");
+    static_assert(v.y() == 2, "vec3(1, 2, 3).y() should be 2");
+    static_assert(v.z() == 3, "vec3(1, 2, 3).z() should be 3");
+  }
+  {
+    constexpr vec3<T> lhs, rhs;
+    static_assert((lhs <=> rhs) == 0, "expected vec3() == vec3()");
+  }
+  {
+    constexpr vec3<T> lhs(-1, 0, 1);
+    constexpr vec3<T> rhs(-1, 0, 1);
+    static_assert((lhs <=> rhs) == 0, "expected vec3(-1, 0, 1) == vec3(-1, 0, 1)");
+  }
+  {
+    constexpr vec3<T> lhs(-1, 0, 0);
+    constexpr vec3<T> rhs(-1, 0, 1);
+    static_assert((lhs <=> rhs) < 0, "expected vec3(-1, 0, 0) < vec3(-1, 0, 1)");
+    static_assert((rhs <=> lhs) > 0, "expected vec3(-1, 0, 1) < vec3(-1, 0, 0)");
+  }
+  {
+    constexpr vec3<T> lhs(-2, 0, 2);
+    constexpr vec3<T> rhs(-1, 0, 1);
+    static_assert((lhs <=> rhs) < 0, "expected vec3(-2, 0, 2) < vec3(-1, 0, 1)");
+    static_assert((rhs <=> lhs) > 0, "expected vec3(-1, 0, 1) > vec3(-2, 0, 2)");
+  }
+  {
+    constexpr vec3<T> lhs(1, 2, 3);
+    constexpr vec3<T> rhs(12, 10, 8);
+    constexpr vec3<T> res(13, 12, 11);
+    static_assert((lhs + rhs) == res, "vec3(1, 2, 3) + vec3(12, 10, 8)");
+  }
+  {
+    constexpr vec3<T> lhs(7, 6, 5);
+    constexpr vec3<T> rhs(4, 5, 6);
+    constexpr vec3<T> res(3, 1, -1);
+    static_assert((lhs - rhs) == res, "vec3(7, 6, 5) - vec3(4, 5, 6)");
+  }
+  {
+    constexpr vec3<T> lhs(1, -2, 0);
+    constexpr vec3<T> rhs(8, 6, 4);
+    constexpr vec3<T> res(8, -12, 0);
+    static_assert((lhs * rhs) == res, "vec3(1, -2, 0) * vec3(8, 6, 4)");
+  }
+  {
+    constexpr vec3<T> lhs(10, 20, 0);
+    constexpr vec3<T> rhs(10, -5, 3);
+    constexpr vec3<T> res(1, -4, 0);
+    static_assert((lhs / rhs) == res, "vec3(10, 20, 0) / vec3(10, -5, 3)");
+  }
+  {
+    constexpr vec3<T> lhs(10, 20, 0);
+    constexpr vec3<T> rhs(10, -5, 3);
+    constexpr vec3<T> res(10, -5, 0);
+    static_assert(lhs.min(rhs) == res, "vec3(10, 20, 0).min(vec3(10, -5, 3))");
+  }
+  {
+    constexpr vec3<T> lhs(10, 20, 0);
+    constexpr vec3<T> rhs(10, -5, 3);
+    constexpr vec3<T> res(10, 20, 3);
+    static_assert(lhs.max(rhs) == res, "vec3(10, 20, 0).max(vec3(10, -5, 3))");
+  }
+  {
+    constexpr vec3<T> v;
+    static_assert(v.distance(v) == 0, "wrong distance from center to center");
+  }
+  {
+    constexpr vec3<T> lhs(-1, 2, -4);
+    constexpr vec3<T> center;
+    static_assert(
+        lhs.distance(center) == 7,
+        "wrong distance from vec3(-1, 2, -4) to center"
+    );
+    static_assert(lhs.distance(lhs) == 0, "wrong distance from vec3(-1, 2, -4) to self");
+  }
+  {
+    constexpr vec3<T> lhs(-1, 2, -4);
+    constexpr vec3<T> rhs(1, 2, 4);
+    static_assert(
+        lhs.distance(rhs) == 10,
+        "wrong distance from vec3(-1, 2, -4) to vec3(1, 2, 4)"
+    );
+  }
+  {
+    constexpr vec3<T> lhs(-1, 2, -4);
+    constexpr vec3<T> rhs(1, 2, 4);
+    static_assert(lhs.dot(rhs) == -13, "vec3(-1, 2, -4) dot vec3(1, 2, 4) should be -13");
+  }
+  {
+    constexpr vec3<T> lhs(-1, 2, -4);
+    constexpr vec3<T> rhs(1, 2, 4);
+    constexpr vec3<T> res(16, 0, -4);
+    static_assert(lhs.cross(rhs) == res, "vec3(-1, 2, -4).cross(vec3(1, 2, 4))");
+  }
+  {
+    constexpr vec3<T> lhs(-1, 2, -4);
+    constexpr vec3<T> res(-1, 1, -1);
+    static_assert(
+        lhs.signum() == res,
+        "expected vec3(-1, 2, -4).signum() == vec3(-1, 1, -1)"
+    );
+  }
+  {
+    constexpr vec3<T> v(-1, 2, -4);
+    static_assert(v.sum() == -3, "expected vec3(-1, 2, -4).sum() == -3");
+  }
+  {
+    constexpr vec3<T> v(-1, 2, -4);
+    static_assert(v.prod() == 8, "expected vec3(-1, 2, -4).prod() == 8");
+  }
+  {
+    constexpr vec3<T> v(-1, 2, -4);
+    static_assert(v.min() == -4, "expected vec3(-1, 2, -4).min() == -4");
+  }
+  {
+    constexpr vec3<T> v(-1, 2, -4);
+    static_assert(v.max() == 2, "expected vec3(-1, 2, -4).max() == 2");
+  }
+}
+
+template <typename T> consteval void test_vec4_compile_time_impl() {
+  static_assert(std::regular<vec4<T>>);
+  {
+    constexpr vec4<T> v;
+    static_assert(v.x() == T{}, "vec4: default init x should be T{}");
+    static_assert(v.y() == T{}, "vec4: default init y should be T{}");
+    static_assert(v.z() == T{}, "vec4: default init z should be T{}");
+    static_assert(v.w() == T{}, "vec4: default init w should be T{}");
+  }
+  {
+    constexpr vec4<T> v(1, 2, 3, 4);
+    static_assert(v.x() == 1, "vec4(1, 2, 3, 4).x() should be 1");
+    static_assert(v.y() == 2, "vec4(1, 2, 3, 4).y() should be 2");
+    static_assert(v.z() == 3, "vec4(1, 2, 3, 4).z() should be 3");
+    static_assert(v.w() == 4, "vec4(1, 2, 3, 4).w() should be 4");
+  }
+  {
+    constexpr vec4<T> lhs, rhs;
+    static_assert((lhs <=> rhs) == 0, "expected vec4() == vec4()");
+  }
+  {
+    constexpr vec4<T> lhs(-1, 0, 1, 2);
+    constexpr vec4<T> rhs(-1, 0, 1, 2);
+    static_assert((lhs <=> rhs) == 0, "expected vec4(-1, 0, 1, 2) == vec4(-1, 0, 1, 2)");
+  }
+  {
+    constexpr vec4<T> lhs(-1, 0, 1, 1);
     constexpr vec4<T> rhs(-1, 0, 1, 2);
     static_assert((lhs <=> rhs) < 0, "expected vec4(-1, 0, 1, 1) < vec4(-1, 0, 1, 2)");
     static_assert((rhs <=> lhs) > 0, "expected vec4(-1, 0, 1, 2) > vec4(-1, 0, 1, 1)");
@@ -877,12 +3491,102 @@ template <typename... Ts> consteval void test_vec_compile_time() {
   (test_vec4_compile_time_impl<Ts>(), ...);
 }
 
+template <typename... Ts> void test_vec_storage() { (test_storage<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_expr() { (test_expr<Ts>(), ...); }
+
 template <typename... Ts> void test_vec_hash() { (test_hash<Ts>(), ...); }
 
+template <typename... Ts> void test_vec_soa() { (test_soa_vector<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_batch() { (test_batch<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_grid() { (test_grid<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_flat_hash() { (test_flat_hash<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_curve() { (test_curve<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_kdtree() { (test_kdtree<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_cell_list() { (test_cell_list<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_search() { (test_search<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_parallel_bfs() { (test_parallel_bfs<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_automaton() { (test_automaton<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_parse() { (test_parse<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_point_file() { (test_point_file<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_reduce() { (test_reduce<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_neighborhood() { (test_neighborhood<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_mat() { (test_mat<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_packed() { (test_packed_vec<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_radix_sort() { (test_radix_sort<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_bitgrid() { (test_bitgrid<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_zobrist() { (test_zobrist<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_hash_quality() { (test_hash_quality<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_instrument() { (test_instrument<Ts>(), ...); }
+
+template <typename... Ts> void test_vec_sparse_grid() { (test_sparse_grid<Ts>(), ...); }
+
 int main() {
   test_vec<short, int, long, long long, float, double, long double>();
+  test_vec_storage<short, int, long, long long, float, double, long double>();
+  test_vec_expr<short, int, long, long long, float, double, long double>();
   test_vec_hash<short, int, long, long long>();
   test_vec_hash_collisions<signed char>();
   test_vec_compile_time<short, int, long, long long, float, double, long double>();
+  test_vec_soa<
+      short,
+      unsigned short,
+      int,
+      unsigned,
+      long,
+      long long,
+      float,
+      double,
+      long double>();
+  test_vec_batch<
+      short,
+      unsigned short,
+      unsigned char,
+      int,
+      long,
+      long long,
+      float,
+      double,
+      long double>();
+  test_vec_grid<short, int, long, long long>();
+  test_vec_flat_hash<short, int, long, long long>();
+  test_vec_curve<short, int, long, long long>();
+  test_vec_kdtree<int, long long, float, double>();
+  test_vec_cell_list<float, double>();
+  test_vec_search<short, int, long, long long>();
+  test_vec_parallel_bfs<short, int, long long>();
+  test_vec_automaton<short, int, long, long long>();
+  test_vec_parse<int, long long, float, double>();
+  test_vec_point_file<short, int, long long, float, double>();
+  test_vec_reduce<short, int, long long, float, double>();
+  test_vec_neighborhood<short, int, long, long long, float, double>();
+  test_vec_mat<short, int, long long, float, double>();
+  test_vec_packed<short, int, long long>();
+  test_vec_radix_sort<signed char, short, unsigned, int, long long>();
+  test_vec_sparse_grid<short, int, long long>();
+  test_vec_bitgrid<short, int, long long>();
+  test_vec_zobrist<short, int, long long>();
+  test_vec_instrument<int, double>();
+  test_vec_hash_quality<short, int, long long>();
   return 0;
 }
@@ -0,0 +1,206 @@
+#ifndef NDVEC_ZOBRIST_HEADER_INCLUDED
+#define NDVEC_ZOBRIST_HEADER_INCLUDED
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include "flat_hash.hpp"
+#include "grid.hpp"
+#include "ndvec.hpp"
+
+namespace ndvec {
+
+inline constexpr std::uint64_t zobrist_seed{0x2545f4914f6cdd1d};
+
+// Pseudo-random 64-bit key of the cell value at p, derived from std::hash of both, so no
+// table of keys has to be stored for unbounded coordinates.
+template <typename Vec, typename Cell>
+[[nodiscard]] constexpr std::uint64_t
+zobrist_key(const Vec& p, const Cell& value, std::uint64_t seed = zobrist_seed) noexcept {
+  const std::uint64_t position{std::hash<Vec>{}(p)};
+  const std::uint64_t cell{std::hash<Cell>{}(value)};
+  return detail::fmix64(detail::fmix64(position ^ seed) + cell * 0x9e3779b97f4a7c15);
+}
+
+// XOR of the keys of every cell of g, in O(size).
+template <typename Cell, std::size_t ndim, std::integral T>
+[[nodiscard]] constexpr std::uint64_t
+zobrist_hash(const grid<Cell, ndim, T>& g, std::uint64_t seed = zobrist_seed) noexcept {
+  std::uint64_t h{};
+  for (std::size_t i{}; i < g.size(); ++i) {
+    h ^= zobrist_key(g.position(i), g[i], seed);
+  }
+  return h;
+}
+
+// Dense grid that keeps the zobrist_hash of its cells up to date. Cells are written
+// through set(), which updates the hash in O(1) by XORing out the key of the old value
+// and XORing in the key of the new one. Equal grids have equal hashes no matter in which
+// order their cells were written.
+template <typename Cell, std::size_t ndim, std::integral T = int> class zobrist_grid {
+public:
+  using grid_type = grid<Cell, ndim, T>;
+  using vec = grid_type::vec;
+  using value_type = Cell;
+  using size_type = std::size_t;
+
+private:
+  grid_type cells_{};
+  std::uint64_t seed_{zobrist_seed};
+  std::uint64_t hash_{};
+
+public:
+  constexpr zobrist_grid() = default;
+
+  constexpr explicit zobrist_grid(grid_type cells, std::uint64_t seed = zobrist_seed)
+      : cells_{std::move(cells)}, seed_{seed}, hash_{zobrist_hash(cells_, seed_)} {}
+
+  [[nodiscard]] constexpr const grid_type& cells() const noexcept { return cells_; }
+  [[nodiscard]] constexpr std::uint64_t hash() const noexcept { return hash_; }
+  [[nodiscard]] constexpr std::uint64_t seed() const noexcept { return seed_; }
+
+  [[nodiscard]] constexpr bool contains(const vec& p) const noexcept {
+    return cells_.contains(p);
+  }
+
+  [[nodiscard]] constexpr const Cell& operator[](const vec& p) const noexcept {
+    return cells_[p];
+  }
+
+  constexpr void set(const vec& p, const Cell& value) {
+    Cell& cell{cells_[p]};
+    hash_ ^= zobrist_key(p, cell, seed_) ^ zobrist_key(p, value, seed_);
+    cell = value;
+  }
+
+  // Replaces all cells, in O(size).
+  constexpr void assign(grid_type cells) {
+    cells_ = std::move(cells);
+    hash_ = zobrist_hash(cells_, seed_);
+  }
+
+  [[nodiscard]] constexpr bool operator==(const zobrist_grid& other) const {
+    return hash_ == other.hash_ and cells_ == other.cells_;
+  }
+};
+
+// A sequence of states that enters a cycle: generation start is the first state that
+// repeats, and it repeats every length generations.
+struct cycle {
+  std::size_t start{};
+  std::size_t length{};
+
+  // The generation in [0, start + length) whose state is the same as that of generation
+  // g.
+  [[nodiscard]] constexpr std::size_t equivalent(std::size_t g) const noexcept {
+    return g < start ? g : start + (g - start) % length;
+  }
+
+  [[nodiscard]] constexpr bool operator==(const cycle&) const = default;
+};
+
+// Remembers the generation of every state hash pushed to it and reports the cycle when a
+// hash repeats. Hashes are compared instead of states, so a 64-bit collision reports a
+// false cycle, which is unlikely for fewer than billions of generations.
+class cycle_detector {
+  flat_map<std::uint64_t, std::size_t> seen_{};
+  std::size_t generation_{};
+
+public:
+  // Records the hash of the next generation, generation 0 being the first push, and
+  // returns the cycle if the same hash was pushed before.
+  std::optional<cycle> push(std::uint64_t hash) {
+    const auto [it, inserted]{seen_.try_emplace(hash, generation_)};
+    const std::size_t g{generation_++};
+    if (inserted) {
+      return std::nullopt;
+    }
+    return cycle{.start = it->second, .length = g - it->second};
+  }
+
+  // Number of hashes pushed.
+  [[nodiscard]] std::size_t generation() const noexcept { return generation_; }
+
+  void clear() {
+    seen_.clear();
+    generation_ = 0;
+  }
+};
+
+// Brent's cycle detection over the states initial, step(initial), ..., comparing hash(s)
+// of the states. Keeps two states and two hashes instead of a table, at the cost of
+// stepping about three times as many generations as cycle_detector. Returns nullopt if
+// no cycle starts and repeats within max_generations steps.
+template <
+    std::copyable State,
+    std::invocable<State&> Step,
+    std::invocable<const State&> Hash>
+[[nodiscard]] std::optional<cycle> find_cycle(
+    const State& initial,
+    Step&& step,
+    Hash&& hash,
+    std::size_t max_generations
+) {
+  auto hash_of{[&hash](const State& s) -> std::uint64_t { return std::invoke(hash, s); }};
+  // find the cycle length with power-of-two sized windows
+  std::size_t power{1}, length{1};
+  State hare{initial};
+  std::invoke(step, hare);
+  std::uint64_t tortoise_hash{hash_of(initial)}, hare_hash{hash_of(hare)};
+  for (std::size_t generations{1}; tortoise_hash != hare_hash; ++generations) {
+    if (generations >= max_generations) {
+      return std::nullopt;
+    }
+    if (power == length) {
+      tortoise_hash = hare_hash;
+      power *= 2;
+      length = 0;
+    }
+    std::invoke(step, hare);
+    hare_hash = hash_of(hare);
+    ++length;
+  }
+  // find the start with a hare length generations ahead of the tortoise
+  State tortoise{initial};
+  hare = initial;
+  for (std::size_t i{}; i < length; ++i) {
+    std::invoke(step, hare);
+  }
+  std::size_t start{};
+  for (; hash_of(tortoise) != hash_of(hare); ++start) {
+    std::invoke(step, tortoise);
+    std::invoke(step, hare);
+  }
+  return cycle{.start = start, .length = length};
+}
+
+// The state after the given number of generations. Steps until a state hash repeats and
+// then skips all the remaining whole cycles, so e.g. 10^9 generations cost the cycle
+// start plus twice the cycle length at most.
+template <
+    std::movable State,
+    std::invocable<State&> Step,
+    std::invocable<const State&> Hash>
+[[nodiscard]] State
+fast_forward(State state, std::size_t generations, Step&& step, Hash&& hash) {
+  cycle_detector detector;
+  for (std::size_t g{}; g < generations; ++g) {
+    if (const auto c{detector.push(std::invoke(hash, std::as_const(state)))}) {
+      // state is generation g, the same as generation c->start
+      for (std::size_t i{}; i < (generations - g) % c->length; ++i) {
+        std::invoke(step, state);
+      }
+      return state;
+    }
+    std::invoke(step, state);
+  }
+  return state;
+}
+
+} // namespace ndvec
+
+#endif // NDVEC_ZOBRIST_HEADER_INCLUDED